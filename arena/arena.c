@@ -0,0 +1,238 @@
+#include "arena.h"
+#include <string.h>
+
+
+//! Выравнивание размера.
+#define ARENA_ALIGN_SIZE(size) (((size) + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1))
+
+#ifdef USE_ARENA_TAGS
+
+//! Заголовок выделения с тегом.
+typedef struct _Arena_Header {
+    size_t size; //!< Полный размер выделения.
+    arena_tag_t tag; //!< Тег.
+} arena_header_t;
+
+//! Размер заголовка с учётом выравнивания.
+#define ARENA_HEADER_SIZE ARENA_ALIGN_SIZE(sizeof(arena_header_t))
+
+//! Наибольший размер выделения, при котором размер с заголовком и выравниванием не переполняется.
+#define ARENA_SIZE_MAX (SIZE_MAX - ARENA_ALIGNMENT - ARENA_HEADER_SIZE)
+
+/**
+ * Уменьшает использование памяти тегами для
+ * выделений в заданной части области.
+ * @param arena Арена.
+ * @param begin Начало части области.
+ * @param end Конец части области.
+ */
+static void arena_untag(arena_t* arena, uint8_t* begin, uint8_t* end)
+{
+    arena_header_t* header;
+    
+    while(begin < end){
+        header = (arena_header_t*)begin;
+        arena->tags_used[header->tag] -= header->size;
+        begin += header->size;
+    }
+}
+
+#else
+
+//! Наибольший размер выделения, при котором выровненный размер не переполняется.
+#define ARENA_SIZE_MAX (SIZE_MAX - ARENA_ALIGNMENT)
+
+#endif
+
+/**
+ * Выравнивает указатель.
+ * @param ptr Указатель.
+ * @return Выровненный указатель.
+ */
+ALWAYS_INLINE static uint8_t* arena_align_ptr(uint8_t* ptr)
+{
+    return (uint8_t*)ARENA_ALIGN_SIZE((uintptr_t)ptr);
+}
+
+err_t arena_init(arena_t* arena)
+{
+    if(arena == NULL) return E_NULL_POINTER;
+    
+    memset(arena, 0x0, sizeof(arena_t));
+    
+    return E_NO_ERROR;
+}
+
+err_t arena_add_region(arena_t* arena, arena_region_t* region, void* memory, size_t size)
+{
+    if(arena == NULL || region == NULL || memory == NULL) return E_NULL_POINTER;
+    
+    uint8_t* begin = arena_align_ptr((uint8_t*)memory);
+    uint8_t* end = (uint8_t*)memory + size;
+    
+    if(begin >= end) return E_INVALID_VALUE;
+    
+    region->next = NULL;
+    region->begin = begin;
+    region->end = end;
+    region->ptr = begin;
+    
+    if(arena->regions == NULL){
+        arena->regions = region;
+        arena->current = region;
+    }else{
+        arena_region_t* last = arena->regions;
+        while(last->next) last = last->next;
+        last->next = region;
+    }
+    
+    return E_NO_ERROR;
+}
+
+/**
+ * Выделяет блок памяти заданного полного размера.
+ * @param arena Арена.
+ * @param size Выровненный размер.
+ * @return Блок памяти, NULL при нехватке памяти.
+ */
+static uint8_t* arena_alloc_block(arena_t* arena, size_t size)
+{
+    arena_region_t* region = arena->current;
+    uint8_t* ptr;
+    
+    while(region){
+        if((size_t)(region->end - region->ptr) >= size){
+            ptr = region->ptr;
+            region->ptr += size;
+            arena->current = region;
+    
+            arena->used += size;
+    
+            if(arena->used > arena->peak){
+                arena->peak = arena->used;
+                if(arena->stats_callback) arena->stats_callback(arena, arena->stats_arg);
+            }
+    
+            return ptr;
+        }
+        region = region->next;
+    }
+    
+    arena->failures ++;
+    
+    return NULL;
+}
+
+void* arena_alloc(arena_t* arena, size_t size)
+{
+#ifdef USE_ARENA_TAGS
+    return arena_alloc_tagged(arena, size, 0);
+#else
+    if(size == 0) return NULL;
+    
+    if(size > ARENA_SIZE_MAX){
+        arena->failures ++;
+        return NULL;
+    }
+    
+    return arena_alloc_block(arena, ARENA_ALIGN_SIZE(size));
+#endif
+}
+
+#ifdef USE_ARENA_TAGS
+
+void* arena_alloc_tagged(arena_t* arena, size_t size, arena_tag_t tag)
+{
+    if(size == 0 || tag >= ARENA_TAGS_COUNT) return NULL;
+    
+    if(size > ARENA_SIZE_MAX){
+        arena->failures ++;
+        return NULL;
+    }
+    
+    size = ARENA_HEADER_SIZE + ARENA_ALIGN_SIZE(size);
+    
+    uint8_t* ptr = arena_alloc_block(arena, size);
+    
+    if(ptr == NULL) return NULL;
+    
+    arena_header_t* header = (arena_header_t*)ptr;
+    
+    header->size = size;
+    header->tag = tag;
+    
+    arena->tags_used[tag] += size;
+    
+    return ptr + ARENA_HEADER_SIZE;
+}
+
+size_t arena_tag_used(const arena_t* arena, arena_tag_t tag)
+{
+    if(tag >= ARENA_TAGS_COUNT) return 0;
+    
+    return arena->tags_used[tag];
+}
+
+#endif
+
+void arena_mark(const arena_t* arena, arena_mark_t* mark)
+{
+    mark->region = arena->current;
+    mark->ptr = arena->current ? arena->current->ptr : NULL;
+    mark->used = arena->used;
+}
+
+void arena_release(arena_t* arena, const arena_mark_t* mark)
+{
+    arena_region_t* region;
+    
+    if(mark->region == NULL){
+        arena_reset(arena);
+        return;
+    }
+    
+    // Освобождение областей, заполненных после состояния.
+    for(region = mark->region->next; region != NULL; region = region->next){
+#ifdef USE_ARENA_TAGS
+        arena_untag(arena, region->begin, region->ptr);
+#endif
+        region->ptr = region->begin;
+    }
+    
+#ifdef USE_ARENA_TAGS
+    arena_untag(arena, mark->ptr, mark->region->ptr);
+#endif
+    
+    mark->region->ptr = mark->ptr;
+    
+    arena->current = mark->region;
+    arena->used = mark->used;
+}
+
+void arena_reset(arena_t* arena)
+{
+    arena_region_t* region;
+    
+    for(region = arena->regions; region != NULL; region = region->next){
+        region->ptr = region->begin;
+    }
+    
+    arena->current = arena->regions;
+    arena->used = 0;
+    
+#ifdef USE_ARENA_TAGS
+    memset(arena->tags_used, 0x0, sizeof(arena->tags_used));
+#endif
+}
+
+void arena_set_stats_callback(arena_t* arena, arena_stats_callback_t callback, void* arg)
+{
+    arena->stats_callback = callback;
+    arena->stats_arg = arg;
+}
+
+void arena_reset_stats(arena_t* arena)
+{
+    arena->peak = arena->used;
+    arena->failures = 0;
+}
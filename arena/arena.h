@@ -0,0 +1,193 @@
+/**
+ * @file arena.h Библиотека выделения памяти из областей (арена).
+ * Память выделяется последовательно (сдвигом указателя)
+ * из предоставленных пользователем областей памяти.
+ * Отдельные блоки не освобождаются, вместо этого
+ * запоминается состояние арены (arena_mark) и вся
+ * выделенная после него память освобождается разом
+ * (arena_release), например, по окончании обработки
+ * кадра или запроса.
+ * При определении USE_ARENA_TAGS каждое выделение
+ * может быть помечено тегом, для каждого тега ведётся
+ * учёт использованной памяти; каждому выделению при
+ * этом предшествует заголовок.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "errors/errors.h"
+#include "defs/defs.h"
+
+
+//! Выравнивание выделяемой памяти.
+#ifndef ARENA_ALIGNMENT
+#define ARENA_ALIGNMENT 8
+#endif
+
+#ifdef USE_ARENA_TAGS
+//! Число тегов.
+#ifndef ARENA_TAGS_COUNT
+#define ARENA_TAGS_COUNT 8
+#endif
+
+//! Тип тега выделения.
+typedef uint8_t arena_tag_t;
+#endif
+
+//! Область памяти арены.
+typedef struct _Arena_Region {
+    struct _Arena_Region* next; //!< Следующая область.
+    uint8_t* begin; //!< Начало области.
+    uint8_t* end; //!< Конец области.
+    uint8_t* ptr; //!< Начало свободной памяти области.
+} arena_region_t;
+
+struct _Arena;
+
+/**
+ * Тип функции обратного вызова статистики.
+ * Вызывается при достижении нового максимума
+ * использования памяти.
+ * @param arena Арена.
+ * @param arg Аргумент.
+ */
+typedef void (*arena_stats_callback_t)(const struct _Arena* arena, void* arg);
+
+//! Арена.
+typedef struct _Arena {
+    arena_region_t* regions; //!< Первая область.
+    arena_region_t* current; //!< Текущая область выделения.
+    size_t used; //!< Используемая память.
+    size_t peak; //!< Максимум используемой памяти.
+    uint32_t failures; //!< Число неудачных выделений.
+    arena_stats_callback_t stats_callback; //!< Функция обратного вызова статистики.
+    void* stats_arg; //!< Аргумент функции обратного вызова статистики.
+#ifdef USE_ARENA_TAGS
+    size_t tags_used[ARENA_TAGS_COUNT]; //!< Используемая память по тегам.
+#endif
+} arena_t;
+
+//! Состояние арены.
+typedef struct _Arena_Mark {
+    arena_region_t* region; //!< Текущая область.
+    uint8_t* ptr; //!< Начало свободной памяти области.
+    size_t used; //!< Используемая память.
+} arena_mark_t;
+
+/**
+ * Инициализирует арену.
+ * @param arena Арена.
+ * @return Код ошибки.
+ */
+EXTERN err_t arena_init(arena_t* arena);
+
+/**
+ * Добавляет область памяти в арену.
+ * Области используются в порядке добавления.
+ * @param arena Арена.
+ * @param region Область.
+ * @param memory Память области.
+ * @param size Размер памяти.
+ * @return Код ошибки.
+ */
+EXTERN err_t arena_add_region(arena_t* arena, arena_region_t* region, void* memory, size_t size);
+
+/**
+ * Выделяет память.
+ * @param arena Арена.
+ * @param size Размер памяти.
+ * @return Указатель на память, NULL при нехватке памяти.
+ */
+EXTERN void* arena_alloc(arena_t* arena, size_t size);
+
+#ifdef USE_ARENA_TAGS
+
+/**
+ * Выделяет память, помеченную тегом.
+ * @param arena Арена.
+ * @param size Размер памяти.
+ * @param tag Тег.
+ * @return Указатель на память, NULL при нехватке памяти.
+ */
+EXTERN void* arena_alloc_tagged(arena_t* arena, size_t size, arena_tag_t tag);
+
+/**
+ * Получает используемую тегом память.
+ * @param arena Арена.
+ * @param tag Тег.
+ * @return Используемая память.
+ */
+EXTERN size_t arena_tag_used(const arena_t* arena, arena_tag_t tag);
+
+#endif
+
+/**
+ * Запоминает состояние арены.
+ * @param arena Арена.
+ * @param mark Состояние арены.
+ */
+EXTERN void arena_mark(const arena_t* arena, arena_mark_t* mark);
+
+/**
+ * Освобождает память, выделенную после запоминания состояния.
+ * Состояния, запомненные после данного, становятся недействительными.
+ * @param arena Арена.
+ * @param mark Состояние арены.
+ */
+EXTERN void arena_release(arena_t* arena, const arena_mark_t* mark);
+
+/**
+ * Освобождает всю память арены.
+ * @param arena Арена.
+ */
+EXTERN void arena_reset(arena_t* arena);
+
+/**
+ * Устанавливает функцию обратного вызова статистики.
+ * @param arena Арена.
+ * @param callback Функция обратного вызова.
+ * @param arg Аргумент функции.
+ */
+EXTERN void arena_set_stats_callback(arena_t* arena, arena_stats_callback_t callback, void* arg);
+
+/**
+ * Получает используемую память.
+ * @param arena Арена.
+ * @return Используемая память.
+ */
+ALWAYS_INLINE static size_t arena_used(const arena_t* arena)
+{
+    return arena->used;
+}
+
+/**
+ * Получает максимум используемой памяти.
+ * @param arena Арена.
+ * @return Максимум используемой памяти.
+ */
+ALWAYS_INLINE static size_t arena_peak(const arena_t* arena)
+{
+    return arena->peak;
+}
+
+/**
+ * Получает число неудачных выделений.
+ * @param arena Арена.
+ * @return Число неудачных выделений.
+ */
+ALWAYS_INLINE static uint32_t arena_failures(const arena_t* arena)
+{
+    return arena->failures;
+}
+
+/**
+ * Сбрасывает статистику арены.
+ * @param arena Арена.
+ */
+EXTERN void arena_reset_stats(arena_t* arena);
+
+#endif /* ARENA_H */
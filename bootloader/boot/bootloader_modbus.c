@@ -1,5 +1,6 @@
 #include "bootloader_modbus.h"
 #include "flash/flash.h"
+#include "modbus/modbus_reg_map.h"
 #include <string.h>
 
 
@@ -27,6 +28,9 @@
 #define BOOT_MODBUS_FILE_BASE 0x1
 //! Файл текущей страницы памяти.
 #define BOOT_MODBUS_FILE_PAGE (BOOT_MODBUS_FILE_BASE + 0)
+// Карта регистров.
+//! Число диапазонов карты регистров.
+#define BOOT_MODBUS_REG_MAP_ENTRIES_COUNT 4
 
 
 
@@ -35,12 +39,41 @@ typedef struct _Bootloader_Modbus {
     modbus_rtu_t* modbus; //!< Интерфейс Modbus RTU.
     uint16_t page_number; //!< Номер страницы флеш-памяти.
     bootloader_run_app_callback_t run_app_callback; //!< Функция обратного вызова запуска приложения.
+    modbus_reg_map_t reg_map; //!< Карта регистров.
+    MODBUS_REG_MAP_INDEX_BUFFER(reg_map_index, BOOT_MODBUS_REG_MAP_ENTRIES_COUNT); //!< Индекс карты регистров.
 } bootloader_modbus_t;
 
 //! Интерфейс Modbus загрузчика.
 static bootloader_modbus_t boot_modbus;
 
 
+/*
+ * Каллбэки Modbus.
+ */
+
+static modbus_rtu_error_t boot_modbus_on_read_page_erase(uint16_t address, uint16_t* value);
+static modbus_rtu_error_t boot_modbus_on_write_page_erase(uint16_t address, uint16_t value);
+static modbus_rtu_error_t boot_modbus_on_write_run_app(uint16_t address, uint16_t value);
+static modbus_rtu_error_t boot_modbus_on_read_input_reg(uint16_t address, uint16_t* value);
+
+
+/*
+ * Карта регистров.
+ */
+
+//! Таблица диапазонов карты регистров.
+static const modbus_reg_map_entry_t boot_modbus_reg_map_entries[BOOT_MODBUS_REG_MAP_ENTRIES_COUNT] = {
+    {MODBUS_RTU_COIL, BOOT_MODBUS_COIL_PAGE_ERASE, 1, MODBUS_REG_MAP_ACCESS_RW,
+        NULL, boot_modbus_on_read_page_erase, boot_modbus_on_write_page_erase, 0, 0},
+    {MODBUS_RTU_COIL, BOOT_MODBUS_COIL_RUN_APP, 1, MODBUS_REG_MAP_ACCESS_WRITE,
+        NULL, NULL, boot_modbus_on_write_run_app, 0, 0},
+    {MODBUS_RTU_INPUT_REG, BOOT_MODBUS_INPUT_REG_BASE, 2, MODBUS_REG_MAP_ACCESS_READ,
+        NULL, boot_modbus_on_read_input_reg, NULL, 0, 0},
+    {MODBUS_RTU_HOLDING_REG, BOOT_MODBUS_HOLD_REG_PAGE_NUMBER, 1, MODBUS_REG_MAP_ACCESS_RW,
+        &boot_modbus.page_number, NULL, NULL, 0, 0},
+};
+
+
 /*
  * Общие функции.
  */
@@ -52,89 +85,60 @@ static bootloader_modbus_t boot_modbus;
 
 
 /*
- * Каллбэки Modbus.
+ * Реализация каллбэков Modbus.
  */
 
-// Чтение флага.
-modbus_rtu_error_t boot_modbus_on_read_coil(uint16_t address, modbus_rtu_coil_value_t* value)
+// Чтение флага стирания страницы.
+static modbus_rtu_error_t boot_modbus_on_read_page_erase(uint16_t address, uint16_t* value)
 {
-    switch(address){
-        default:
-            return MODBUS_RTU_ERROR_INVALID_ADDRESS;
-        case BOOT_MODBUS_COIL_PAGE_ERASE:
-            *value = MODBUS_RTU_COIL_OFF;
-            break;
-    }
+    (void)address;
     
-    return MODBUS_RTU_ERROR_NONE;
-}
-
-// Запись флага.
-modbus_rtu_error_t boot_modbus_on_write_coil(uint16_t address, modbus_rtu_coil_value_t value)
-{
-    switch(address){
-        default:
-            return MODBUS_RTU_ERROR_INVALID_ADDRESS;
-        case BOOT_MODBUS_COIL_PAGE_ERASE:
-            if(value == MODBUS_RTU_COIL_ON){
-                if(!flash_unlock()) return MODBUS_RTU_ERROR_NONRECOVERABLE;
-                if(!flash_page_erase(flash_page_address(boot_modbus.page_number))){
-                    flash_lock();
-                    return MODBUS_RTU_ERROR_NONRECOVERABLE;
-                }
-                flash_lock();
-            }
-            break;
-        case BOOT_MODBUS_COIL_RUN_APP:
-            if(value == MODBUS_RTU_COIL_ON){
-                if(!boot_modbus.run_app_callback) return MODBUS_RTU_ERROR_NONRECOVERABLE;
-                boot_modbus.run_app_callback();
-            }
-            break;
-    }
+    *value = 0;
     
     return MODBUS_RTU_ERROR_NONE;
 }
 
-// Чтение регистра ввода.
-modbus_rtu_error_t boot_modbus_on_read_input_reg(uint16_t address, uint16_t* value)
+// Запись флага стирания страницы.
+static modbus_rtu_error_t boot_modbus_on_write_page_erase(uint16_t address, uint16_t value)
 {
-    switch(address){
-        default:
-            return MODBUS_RTU_ERROR_INVALID_ADDRESS;
-        case BOOT_MODBUS_INPUT_REG_FLASH_SIZE:
-            *value = flash_size();
-            break;
-        case BOOT_MODBUS_INPUT_REG_FLASH_PAGE_SIZE:
-            *value = flash_page_size_bytes();
-            break;
+    (void)address;
+    
+    if(value){
+        if(!flash_unlock()) return MODBUS_RTU_ERROR_NONRECOVERABLE;
+        if(!flash_page_erase(flash_page_address(boot_modbus.page_number))){
+            flash_lock();
+            return MODBUS_RTU_ERROR_NONRECOVERABLE;
+        }
+        flash_lock();
     }
     
     return MODBUS_RTU_ERROR_NONE;
 }
 
-// Чтение регистра хранения.
-modbus_rtu_error_t boot_modbus_on_read_hold_reg(uint16_t address, uint16_t* value)
+// Запись флага запуска приложения.
+static modbus_rtu_error_t boot_modbus_on_write_run_app(uint16_t address, uint16_t value)
 {
-    switch(address){
-        default:
-            return MODBUS_RTU_ERROR_INVALID_ADDRESS;
-        case BOOT_MODBUS_HOLD_REG_PAGE_NUMBER:
-            *value = boot_modbus.page_number;
-            break;
+    (void)address;
+    
+    if(value){
+        if(!boot_modbus.run_app_callback) return MODBUS_RTU_ERROR_NONRECOVERABLE;
+        boot_modbus.run_app_callback();
     }
     
     return MODBUS_RTU_ERROR_NONE;
 }
 
-// Запись регистра хранения.
-modbus_rtu_error_t boot_modbus_on_write_hold_reg(uint16_t address, uint16_t value)
+// Чтение регистров ввода.
+static modbus_rtu_error_t boot_modbus_on_read_input_reg(uint16_t address, uint16_t* value)
 {
     switch(address){
         default:
             return MODBUS_RTU_ERROR_INVALID_ADDRESS;
-        case BOOT_MODBUS_HOLD_REG_PAGE_NUMBER:
-            boot_modbus.page_number = value;
+        case BOOT_MODBUS_INPUT_REG_FLASH_SIZE:
+            *value = flash_size();
+            break;
+        case BOOT_MODBUS_INPUT_REG_FLASH_PAGE_SIZE:
+            *value = flash_page_size_bytes();
             break;
     }
     
@@ -189,7 +193,8 @@ err_t bootloader_modbus_init(void)
 {
     memset(&boot_modbus, 0x0, sizeof(bootloader_modbus_t));
     
-    return E_NO_ERROR;
+    return modbus_reg_map_init(&boot_modbus.reg_map, boot_modbus_reg_map_entries,
+                               BOOT_MODBUS_REG_MAP_ENTRIES_COUNT, boot_modbus.reg_map_index);
 }
 
 void bootloader_modbus_set_run_app_callback(bootloader_run_app_callback_t callback)
@@ -201,11 +206,7 @@ err_t bootloader_modbus_setup_modbus(modbus_rtu_t* modbus)
 {
     if(modbus == NULL) return E_NULL_POINTER;
     
-    modbus_rtu_set_read_coil_callback(modbus, boot_modbus_on_read_coil);
-    modbus_rtu_set_write_coil_callback(modbus, boot_modbus_on_write_coil);
-    modbus_rtu_set_read_input_reg_callback(modbus, boot_modbus_on_read_input_reg);
-    modbus_rtu_set_read_holding_reg_callback(modbus, boot_modbus_on_read_hold_reg);
-    modbus_rtu_set_write_holding_reg_callback(modbus, boot_modbus_on_write_hold_reg);
+    modbus_rtu_set_reg_map(modbus, &boot_modbus.reg_map);
     modbus_rtu_set_read_file_record_callback(modbus, boot_modbus_rtu_on_read_file_record);
     modbus_rtu_set_write_file_record_callback(modbus, boot_modbus_rtu_on_write_file_record);
     
@@ -17,8 +17,10 @@ static usart_bus_t usart_bus;
 
 //! Modbus.
 static modbus_rtu_t modbus;
+//! Число буферов приёма сообщений Modbus.
+#define MODBUS_RX_MESSAGES_COUNT 2
 //! Сообщения Modbus.
-static modbus_rtu_message_t modbus_rx_msg, modbus_tx_msg;
+static modbus_rtu_message_t modbus_rx_msgs[MODBUS_RX_MESSAGES_COUNT], modbus_tx_msg;
 
 
 // Приоритеты прерываний.
@@ -173,6 +175,13 @@ static bool usart_rx_callback(void)
     return modbus_rtu_usart_rx_callback(&modbus);
 }
 
+static bool usart_rx_progress_callback(void)
+{
+    modbus_rtu_usart_rx_progress(&modbus);
+    
+    return true;
+}
+
 static bool usart_tx_callback(void)
 {
     return modbus_rtu_usart_tx_callback(&modbus);
@@ -367,6 +376,7 @@ static void init_usart_bus(void)
     usart_bus_set_tx_callback(&usart_bus, usart_tx_callback);
     usart_bus_set_tc_callback(&usart_bus, usart_tc_callback);
     usart_bus_set_rx_byte_callback(&usart_bus, usart_rx_byte_callback);
+    usart_bus_set_rx_progress_callback(&usart_bus, usart_rx_progress_callback);
     
     usart_bus_set_idle_mode(&usart_bus, USART_IDLE_MODE_END_RX);
 }
@@ -387,11 +397,14 @@ static void init_modbus(void)
     
     modbus_is.address = 0x1;
     
-    modbus_is.rx_message = &modbus_rx_msg;
+    modbus_is.rx_message = &modbus_rx_msgs[0];
     modbus_is.tx_message = &modbus_tx_msg;
     
     modbus_rtu_init(&modbus, &modbus_is);
     
+    // Приём следующего запроса во время записи во флеш-память.
+    modbus_rtu_set_rx_messages(&modbus, modbus_rx_msgs, MODBUS_RX_MESSAGES_COUNT);
+    
     modbus_rtu_set_msg_recv_callback(&modbus, modbus_on_msg_recv);
     modbus_rtu_set_msg_sent_callback(&modbus, modbus_on_msg_sent);
     
@@ -594,8 +607,9 @@ int main(void)
     
     for(;!bootloader_done;){
         
-        // Если приняли сообщение.
-        if(bootloader_modbus_msg){
+        // Если приняли сообщение и завершена
+        // передача ответа на предыдущее.
+        if(bootloader_modbus_msg && !usart_bus_tx_busy(&usart_bus)){
 
             bootloader_modbus_msg = false;
 
@@ -603,6 +617,14 @@ int main(void)
             if(modbus_rtu_dispatch(&modbus) != E_NO_ERROR){
                 modbus_rs485_set_input();
             }
+            
+            // Сообщения, принятые во время обработки.
+            if(modbus_rtu_rx_messages_pending(&modbus) != 0){
+                bootloader_modbus_msg = true;
+            }
+        }else{
+            // Вычисление CRC принимаемого сообщения.
+            modbus_rtu_usart_rx_progress(&modbus);
         }
         
 #ifdef BOOTLOADER_USE_LEDS
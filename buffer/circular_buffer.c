@@ -3,20 +3,107 @@
 #include "utils/utils.h"
 
 
+#ifdef USE_CIRCULAR_BUFFER_SPSC
+
+//! Барьер памяти между данными и индексами буфера.
+#ifdef __arm__
+#define CIRCULAR_BUFFER_BARRIER() __asm__ volatile ("dmb" ::: "memory")
+#else
+#define CIRCULAR_BUFFER_BARRIER() __sync_synchronize()
+#endif
+
+/**
+ * Округляет размер вниз до степени двойки.
+ * @param size Размер.
+ * @return Степень двойки, не превышающая размер.
+ */
+static size_t circular_buffer_pow2_floor(size_t size)
+{
+    size_t res = 1;
+    
+    if(size == 0) return 0;
+    
+    while(res <= size / 2) res <<= 1;
+    
+    return res;
+}
+
+//! Получает смещение в памяти буфера по индексу.
+#define CIRCULAR_BUFFER_OFFSET(buffer, index) ((index) & ((buffer)->size - 1))
+
+//! Получает размер данных в буфере.
+#define CIRCULAR_BUFFER_COUNT(buffer) ((buffer)->put - (buffer)->get)
+
+#else
+
+#define CIRCULAR_BUFFER_BARRIER()
+
+#define CIRCULAR_BUFFER_OFFSET(buffer, index) (index)
+
+#define CIRCULAR_BUFFER_COUNT(buffer) ((buffer)->count)
+
+#endif
+
+/**
+ * Сдвигает индекс записи после помещения данных.
+ * @param buffer Кольцевой буфер.
+ * @param size Размер данных.
+ */
+ALWAYS_INLINE static void circular_buffer_advance_put(circular_buffer_t* buffer, size_t size)
+{
+    // Данные должны быть записаны до изменения индекса.
+    CIRCULAR_BUFFER_BARRIER();
+    
+#ifdef USE_CIRCULAR_BUFFER_SPSC
+    buffer->put += size;
+#else
+    size_t put = buffer->put + size;
+    if(put >= buffer->size) put -= buffer->size;
+    buffer->put = put;
+    buffer->count += size;
+#endif
+}
+
+/**
+ * Сдвигает индекс чтения после получения данных.
+ * @param buffer Кольцевой буфер.
+ * @param size Размер данных.
+ */
+ALWAYS_INLINE static void circular_buffer_advance_get(circular_buffer_t* buffer, size_t size)
+{
+    // Данные должны быть прочитаны до изменения индекса.
+    CIRCULAR_BUFFER_BARRIER();
+    
+#ifdef USE_CIRCULAR_BUFFER_SPSC
+    buffer->get += size;
+#else
+    size_t get = buffer->get + size;
+    if(get >= buffer->size) get -= buffer->size;
+    buffer->get = get;
+    buffer->count -= size;
+#endif
+}
+
 void circular_buffer_init(circular_buffer_t* buffer, uint8_t* ptr, size_t size)
 {
     buffer->ptr = ptr;
     buffer->put = 0;
     buffer->get = 0;
+#ifdef USE_CIRCULAR_BUFFER_SPSC
+    buffer->size = circular_buffer_pow2_floor(size);
+#else
     buffer->size = size;
     buffer->count = 0;
+#endif
 }
 
 void circular_buffer_reset(circular_buffer_t* buffer)
 {
     buffer->put = 0;
     buffer->get = 0;
+#ifndef USE_CIRCULAR_BUFFER_SPSC
     buffer->count = 0;
+#endif
 }
 
 bool circular_buffer_valid(circular_buffer_t* buffer)
@@ -31,45 +118,46 @@ size_t circular_buffer_size(circular_buffer_t* buffer)
 
 size_t circular_buffer_free_size(circular_buffer_t* buffer)
 {
-    return buffer->size - buffer->count;
+    return buffer->size - CIRCULAR_BUFFER_COUNT(buffer);
 }
 
 size_t circular_buffer_avail_size(circular_buffer_t* buffer)
 {
-    return buffer->count;
+    return CIRCULAR_BUFFER_COUNT(buffer);
 }
 
 size_t circular_buffer_put(circular_buffer_t* buffer, uint8_t data)
 {
-    if(buffer->count == buffer->size) return 0;
+    if(CIRCULAR_BUFFER_COUNT(buffer) == buffer->size) return 0;
     
-    buffer->ptr[buffer->put] = data;
+    buffer->ptr[CIRCULAR_BUFFER_OFFSET(buffer, buffer->put)] = data;
     
-    CYCLIC_INC(buffer->put, 0, buffer->size);
-    
-    buffer->count ++;
+    circular_buffer_advance_put(buffer, 1);
     
     return 1;
 }
 
 size_t circular_buffer_get(circular_buffer_t* buffer, uint8_t* data)
 {
-    if(buffer->count == 0) return 0;
+    if(CIRCULAR_BUFFER_COUNT(buffer) == 0) return 0;
     
-    *data = buffer->ptr[buffer->get];
+    // Индекс записи должен быть прочитан до данных.
+    CIRCULAR_BUFFER_BARRIER();
     
-    CYCLIC_INC(buffer->get, 0, buffer->size);
+    *data = buffer->ptr[CIRCULAR_BUFFER_OFFSET(buffer, buffer->get)];
     
-    buffer->count --;
+    circular_buffer_advance_get(buffer, 1);
     
     return 1;
 }
 
 size_t circular_buffer_peek(circular_buffer_t* buffer, uint8_t* data)
 {
-    if(buffer->count == 0) return 0;
+    if(CIRCULAR_BUFFER_COUNT(buffer) == 0) return 0;
+    
+    CIRCULAR_BUFFER_BARRIER();
     
-    *data = buffer->ptr[buffer->get];
+    *data = buffer->ptr[CIRCULAR_BUFFER_OFFSET(buffer, buffer->get)];
     
     return 1;
 }
@@ -77,22 +165,105 @@ size_t circular_buffer_peek(circular_buffer_t* buffer, uint8_t* data)
 size_t circular_buffer_write(circular_buffer_t* buffer, const uint8_t* data, size_t size)
 {
     // Если места недостаточно или размер данных равен 0 - возврат 0.
-    if(buffer->size - buffer->count < size || size == 0) return 0;
+    if(buffer->size - CIRCULAR_BUFFER_COUNT(buffer) < size || size == 0) return 0;
     
-    size_t n;
-    for(n = 0; n < size; n ++) circular_buffer_put(buffer, *data ++);
+    size_t offset = CIRCULAR_BUFFER_OFFSET(buffer, buffer->put);
+    size_t n = MIN(size, buffer->size - offset);
+    
+    memcpy(&buffer->ptr[offset], data, n);
+    if(n < size) memcpy(buffer->ptr, data + n, size - n);
+    
+    circular_buffer_advance_put(buffer, size);
     
     return size;
 }
 
 size_t circular_buffer_read(circular_buffer_t* buffer, uint8_t* data, size_t size)
 {
+    size_t count = CIRCULAR_BUFFER_COUNT(buffer);
+    
     // Если в буфере нет данных, или размер данных равен 0 - возврат 0.
-    if(buffer->count == 0 || size == 0) return 0;
+    if(count == 0 || size == 0) return 0;
+    
+    if(size > count) size = count;
+    
+    // Индекс записи должен быть прочитан до данных.
+    CIRCULAR_BUFFER_BARRIER();
+    
+    size_t offset = CIRCULAR_BUFFER_OFFSET(buffer, buffer->get);
+    size_t n = MIN(size, buffer->size - offset);
+    
+    memcpy(data, &buffer->ptr[offset], n);
+    if(n < size) memcpy(data + n, buffer->ptr, size - n);
+    
+    circular_buffer_advance_get(buffer, size);
     
-    size_t n;
-    for(n = 0; n < size; n ++) circular_buffer_get(buffer, data ++);
+    return size;
+}
+
+/**
+ * Получает размер непрерывной области для записи.
+ * @param buffer Кольцевой буфер.
+ * @return Размер области.
+ */
+static size_t circular_buffer_write_region_size(circular_buffer_t* buffer)
+{
+    size_t offset = CIRCULAR_BUFFER_OFFSET(buffer, buffer->put);
+    
+    return MIN(buffer->size - CIRCULAR_BUFFER_COUNT(buffer), buffer->size - offset);
+}
+
+/**
+ * Получает размер непрерывной области для чтения.
+ * @param buffer Кольцевой буфер.
+ * @return Размер области.
+ */
+static size_t circular_buffer_read_region_size(circular_buffer_t* buffer)
+{
+    size_t offset = CIRCULAR_BUFFER_OFFSET(buffer, buffer->get);
+    
+    return MIN(CIRCULAR_BUFFER_COUNT(buffer), buffer->size - offset);
+}
+
+size_t circular_buffer_write_acquire(circular_buffer_t* buffer, uint8_t** ptr)
+{
+    size_t size = circular_buffer_write_region_size(buffer);
+    
+    if(ptr) *ptr = &buffer->ptr[CIRCULAR_BUFFER_OFFSET(buffer, buffer->put)];
     
     return size;
 }
 
+size_t circular_buffer_write_commit(circular_buffer_t* buffer, size_t size)
+{
+    size = MIN(size, circular_buffer_write_region_size(buffer));
+    
+    if(size == 0) return 0;
+    
+    circular_buffer_advance_put(buffer, size);
+    
+    return size;
+}
+
+size_t circular_buffer_read_acquire(circular_buffer_t* buffer, const uint8_t** ptr)
+{
+    size_t size = circular_buffer_read_region_size(buffer);
+    
+    // Индекс записи должен быть прочитан до данных.
+    CIRCULAR_BUFFER_BARRIER();
+    
+    if(ptr) *ptr = &buffer->ptr[CIRCULAR_BUFFER_OFFSET(buffer, buffer->get)];
+    
+    return size;
+}
+
+size_t circular_buffer_read_commit(circular_buffer_t* buffer, size_t size)
+{
+    size = MIN(size, circular_buffer_read_region_size(buffer));
+    
+    if(size == 0) return 0;
+    
+    circular_buffer_advance_get(buffer, size);
+    
+    return size;
+}
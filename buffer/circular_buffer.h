@@ -1,6 +1,15 @@
 /**
  * @file circular_buffer.h
  * Функции для работы с кольцевым буфером.
+ * При определении USE_CIRCULAR_BUFFER_SPSC буфер работает
+ * без блокировок при одном производителе и одном потребителе
+ * (например, прерывание и главный цикл): размер буфера
+ * округляется вниз до степени двойки, индексы записи и чтения
+ * изменяются без ограничения и приводятся маской, каждый из них
+ * изменяется только своей стороной после барьера памяти.
+ * Функции сброса в этом режиме не потокобезопасны.
+ * Без USE_CIRCULAR_BUFFER_SPSC одновременный доступ
+ * из прерывания и главного цикла требует критической секции.
  */
 
 #ifndef CIRCULAR_BUFFER_H
@@ -20,7 +29,9 @@ typedef struct _CircularBuffer {
     size_t size;
     volatile size_t put;
     volatile size_t get;
+#ifndef USE_CIRCULAR_BUFFER_SPSC
     volatile size_t count;
+#endif
 }circular_buffer_t;
 
 
@@ -29,6 +40,7 @@ typedef struct _CircularBuffer {
  * @param buffer Кольцевой буфер.
  * @param ptr Указатель на память для буфера.
  * @param size Размер буфера.
+ * В режиме USE_CIRCULAR_BUFFER_SPSC округляется вниз до степени двойки.
  */
 EXTERN void circular_buffer_init(circular_buffer_t* buffer, uint8_t* ptr, size_t size);
 
@@ -96,6 +108,7 @@ EXTERN size_t circular_buffer_peek(circular_buffer_t* buffer, uint8_t* data);
  * @param data Данные.
  * @param size Размер данных.
  * @return Число помещённых данных в кольцевой буфер (ноль если места недостаточно).
+ * Данные копируются не более чем двумя вызовами memcpy.
  */
 EXTERN size_t circular_buffer_write(circular_buffer_t* buffer, const uint8_t* data, size_t size);
 
@@ -105,8 +118,49 @@ EXTERN size_t circular_buffer_write(circular_buffer_t* buffer, const uint8_t* da
  * @param data Указатель на данные.
  * @param size Размер данных.
  * @return  Число полученных данных из кольцевого буфера (ноль если нет данных).
+ * Данные копируются не более чем двумя вызовами memcpy.
  */
 EXTERN size_t circular_buffer_read(circular_buffer_t* buffer, uint8_t* data, size_t size);
 
+/**
+ * Получает наибольшую непрерывную область для записи.
+ * Позволяет записывать данные непосредственно в память
+ * буфера (например, с помощью DMA), после записи
+ * данные помещаются в буфер вызовом circular_buffer_write_commit.
+ * @param buffer Кольцевой буфер.
+ * @param ptr Указатель на начало области.
+ * @return Размер области (ноль если места нет).
+ */
+EXTERN size_t circular_buffer_write_acquire(circular_buffer_t* buffer, uint8_t** ptr);
+
+/**
+ * Помещает в буфер данные, записанные в область
+ * полученную circular_buffer_write_acquire.
+ * @param buffer Кольцевой буфер.
+ * @param size Размер записанных данных.
+ * @return Число помещённых данных (не более размера области).
+ */
+EXTERN size_t circular_buffer_write_commit(circular_buffer_t* buffer, size_t size);
+
+/**
+ * Получает наибольшую непрерывную область для чтения.
+ * Позволяет обрабатывать данные непосредственно в памяти
+ * буфера, после обработки данные извлекаются из буфера
+ * вызовом circular_buffer_read_commit.
+ * @param buffer Кольцевой буфер.
+ * @param ptr Указатель на начало области.
+ * @return Размер области (ноль если нет данных).
+ */
+EXTERN size_t circular_buffer_read_acquire(circular_buffer_t* buffer, const uint8_t** ptr);
+
+/**
+ * Извлекает из буфера данные области,
+ * полученной circular_buffer_read_acquire.
+ * @param buffer Кольцевой буфер.
+ * @param size Размер обработанных данных.
+ * @return Число извлечённых данных (не более размера области).
+ */
+EXTERN size_t circular_buffer_read_commit(circular_buffer_t* buffer, size_t size);
+
 #endif	/* CIRCULAR_BUFFER_H */
 
@@ -0,0 +1,63 @@
+#include "coroutine.h"
+#include <stddef.h>
+
+
+void coroutine_init(coroutine_t* co)
+{
+    coroutine_instance_init(co, scheduler_default(), timers_default());
+}
+
+void coroutine_instance_init(coroutine_t* co, scheduler_t* scheduler, timers_t* timers)
+{
+    co->state = 0;
+    co->scheduler = scheduler;
+    co->timers = timers;
+    co->tid = INVALID_TASK_ID;
+    co->timer = INVALID_TIMER_ID;
+    co->sleeping = false;
+}
+
+static void* coroutine_wakeup(void* arg)
+{
+    coroutine_t* co = (coroutine_t*)arg;
+    
+    co->sleeping = false;
+    
+    if(co->tid != INVALID_TASK_ID) scheduler_instance_resume_task(co->scheduler, co->tid);
+    
+    return NULL;
+}
+
+bool coroutine_sleep(coroutine_t* co, const struct timeval* tv)
+{
+    if(co->timer != INVALID_TIMER_ID){
+        // Задача могла быть возобновлена до срабатывания таймера.
+        if(co->sleeping) return false;
+        
+        co->timer = INVALID_TIMER_ID;
+        co->tid = INVALID_TASK_ID;
+        
+        return true;
+    }
+    
+    struct timeval tv_start;
+    gettimeofday(&tv_start, NULL);
+    timeradd(&tv_start, tv, &tv_start);
+    
+    co->sleeping = true;
+    co->tid = scheduler_instance_current_task_id(co->scheduler);
+    
+    // Приостановка до запуска таймера исключает
+    // потерю возобновления при быстром срабатывании.
+    if(co->tid != INVALID_TASK_ID) scheduler_instance_suspend_task(co->scheduler, co->tid);
+    
+    co->timer = timers_instance_add_timer(co->timers, coroutine_wakeup, &tv_start, NULL, co, NULL);
+    
+    if(co->timer == INVALID_TIMER_ID){
+        co->sleeping = false;
+        if(co->tid != INVALID_TASK_ID) scheduler_instance_resume_task(co->scheduler, co->tid);
+        co->tid = INVALID_TASK_ID;
+    }
+    
+    return false;
+}
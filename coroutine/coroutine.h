@@ -0,0 +1,125 @@
+/**
+ * @file coroutine.h Библиотека сопрограмм.
+ * Сопрограммы без собственного стека для планировщика задач.
+ * Функция задачи-сопрограммы может прерывать выполнение
+ * (уступать управление), ожидать завершения будущего
+ * или истечения времени, после чего её выполнение
+ * продолжается планировщиком с точки прерывания.
+ * Значения локальных переменных между прерываниями
+ * не сохраняются, состояние следует хранить в
+ * структуре аргумента задачи.
+ * Два макроса прерывания не могут находиться на одной строке,
+ * внутри сопрограммы нельзя использовать оператор switch,
+ * содержащий макросы прерывания.
+ */
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/time.h>
+#include "scheduler/scheduler.h"
+#include "timers/timers.h"
+#include "future/future.h"
+#include "defs/defs.h"
+
+
+//! Тип точки продолжения сопрограммы.
+typedef uint32_t coroutine_state_t;
+
+//! Структура сопрограммы.
+typedef struct _Coroutine {
+    coroutine_state_t state; //!< Точка продолжения.
+    scheduler_t* scheduler; //!< Планировщик сопрограммы.
+    timers_t* timers; //!< Таймеры сопрограммы.
+    task_id_t tid; //!< Идентификатор задачи, ожидающей таймер.
+    timer_id_t timer; //!< Идентификатор таймера ожидания.
+    volatile bool sleeping; //!< Флаг ожидания таймера.
+} coroutine_t;
+
+/**
+ * Начало тела сопрограммы.
+ * @param co Сопрограмма.
+ */
+#define COROUTINE_BEGIN(co) switch((co)->state){ case 0:
+
+/**
+ * Конец тела сопрограммы.
+ * Завершает сопрограмму, следующий запуск начнётся с начала.
+ * @param co Сопрограмма.
+ * @param result Результат задачи.
+ */
+#define COROUTINE_END(co, result) } (co)->state = 0; return (result)
+
+/**
+ * Завершает сопрограмму.
+ * @param co Сопрограмма.
+ * @param result Результат задачи.
+ */
+#define COROUTINE_EXIT(co, result) do{ (co)->state = 0; return (result); }while(0)
+
+/**
+ * Уступает управление другим задачам.
+ * @param co Сопрограмма.
+ */
+#define COROUTINE_YIELD(co) do{ (co)->state = __LINE__; return TASK_YIELD; case __LINE__:; }while(0)
+
+/**
+ * Ожидает выполнения условия, уступая управление.
+ * @param co Сопрограмма.
+ * @param cond Условие.
+ */
+#define COROUTINE_WAIT_UNTIL(co, cond) do{ (co)->state = __LINE__; case __LINE__: if(!(cond)) return TASK_YIELD; }while(0)
+
+/**
+ * Ожидает, пока выполняется условие, уступая управление.
+ * @param co Сопрограмма.
+ * @param cond Условие.
+ */
+#define COROUTINE_WAIT_WHILE(co, cond) COROUTINE_WAIT_UNTIL(co, !(cond))
+
+/**
+ * Ожидает завершения будущего.
+ * @param co Сопрограмма.
+ * @param future Будущее.
+ */
+#define COROUTINE_AWAIT(co, future) COROUTINE_WAIT_UNTIL(co, future_done(future))
+
+/**
+ * Ожидает истечения времени.
+ * На время ожидания задача приостанавливается.
+ * @param co Сопрограмма.
+ * @param tv Время ожидания (struct timeval*).
+ */
+#define COROUTINE_SLEEP(co, tv) COROUTINE_WAIT_UNTIL(co, coroutine_sleep(co, tv))
+
+/**
+ * Инициализирует сопрограмму, выполняемую
+ * планировщиком и таймерами по-умолчанию.
+ * @param co Сопрограмма.
+ */
+EXTERN void coroutine_init(coroutine_t* co);
+
+/**
+ * Инициализирует сопрограмму, выполняемую
+ * заданными планировщиком и таймерами.
+ * @param co Сопрограмма.
+ * @param scheduler Планировщик.
+ * @param timers Таймеры.
+ */
+EXTERN void coroutine_instance_init(coroutine_t* co, scheduler_t* scheduler, timers_t* timers);
+
+/**
+ * Выполняет шаг ожидания истечения времени.
+ * При первом вызове запускает таймер и приостанавливает
+ * текущую задачу, возобновляемую по срабатыванию таймера.
+ * При отсутствии свободных таймеров запуск повторяется
+ * при следующем вызове.
+ * @param co Сопрограмма.
+ * @param tv Время ожидания.
+ * @return Флаг истечения времени.
+ */
+EXTERN bool coroutine_sleep(coroutine_t* co, const struct timeval* tv);
+
+#endif /* COROUTINE_H */
@@ -18,6 +18,8 @@
 
 #define PACKED __attribute__((packed))
 
+#define UNUSED __attribute__((unused))
+
 #define STRING(s) #s
 #define MAKE_STRING(s) STRING(s)
 #define CONCAT_SIMPLE(a, ...) a ## __VA_ARGS__
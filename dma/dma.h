@@ -91,6 +91,19 @@ EXTERN bool dma_channel_trylock(DMA_Channel_TypeDef* dma_channel);
  */
 EXTERN err_t dma_channel_unlock(DMA_Channel_TypeDef* dma_channel);
 
+/**
+ * Устанавливает адрес памяти канала DMA.
+ * Может быть переопределена заголовком МК.
+ * @param dma_channel Канал DMA.
+ * @param address Адрес памяти.
+ */
+#ifndef dma_channel_set_memory_address
+ALWAYS_INLINE static void dma_channel_set_memory_address(DMA_Channel_TypeDef* dma_channel, void* address)
+{
+    dma_channel->CMAR = (uint32_t)address;
+}
+#endif
+
 /**
  * Деинициализирует канал DMA.
  * @param dma_channel Канал DMA.
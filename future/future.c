@@ -1,12 +1,24 @@
 #include "future.h"
 #include <stddef.h>
 #include "utils/utils.h"
+#include "utils/critical.h"
+
+#ifndef __arm__
+#include <pthread.h>
+
+//! Мьютекс ожидания будущих на хосте.
+static pthread_mutex_t future_mutex = PTHREAD_MUTEX_INITIALIZER;
+//! Условная переменная ожидания будущих на хосте.
+static pthread_cond_t future_cond = PTHREAD_COND_INITIALIZER;
+#endif
 
 void future_init(future_t* future)
 {
     future->result = NULL;
     future->done = false;
     future->running = false;
+    future->callback = NULL;
+    future->callback_arg = NULL;
 }
 
 void* future_result(const future_t* future)
@@ -47,12 +59,142 @@ void future_start(future_t* future)
 
 void future_finish(future_t* future, void* result)
 {
+#ifndef __arm__
+    pthread_mutex_lock(&future_mutex);
+#endif
+    
+    CRITICAL_ENTER();
+    
     future->done = true;
     future->running = false;
     future->result = result;
+    
+    future_callback_t callback = future->callback;
+    void* callback_arg = future->callback_arg;
+    
+    CRITICAL_EXIT();
+    
+#ifdef __arm__
+    // Пробуждение ожидающего в future_wait.
+    __asm__ volatile ("sev");
+#else
+    pthread_cond_broadcast(&future_cond);
+    pthread_mutex_unlock(&future_mutex);
+#endif
+    
+    if(callback) callback(future, callback_arg);
 }
 
 void future_wait(const future_t* future)
 {
-    WAIT_WHILE_TRUE(future_running(future));
+#ifdef __arm__
+    // Событие, установленное в future_finish между проверкой
+    // и WFE, не даёт заснуть и повторяет проверку.
+    while(future_running(future)){
+        __asm__ volatile ("wfe");
+    }
+#else
+    pthread_mutex_lock(&future_mutex);
+    
+    while(future_running(future)){
+        pthread_cond_wait(&future_cond, &future_mutex);
+    }
+    
+    pthread_mutex_unlock(&future_mutex);
+#endif
+}
+
+void future_set_callback(future_t* future, future_callback_t callback, void* arg)
+{
+#ifndef __arm__
+    // Согласование с future_finish из другого потока.
+    pthread_mutex_lock(&future_mutex);
+#endif
+    
+    CRITICAL_ENTER();
+    
+    future->callback = callback;
+    future->callback_arg = arg;
+    
+    bool done = future->done;
+    
+    CRITICAL_EXIT();
+    
+#ifndef __arm__
+    pthread_mutex_unlock(&future_mutex);
+#endif
+    
+    if(done && callback) callback(future, arg);
+}
+
+static void future_then_callback(future_t* future, void* arg)
+{
+    future_then_t* then = (future_then_t*)arg;
+    
+    void* result = future_result(future);
+    
+    if(then->proc) result = then->proc(result);
+    
+    future_finish(then->next, result);
+}
+
+err_t future_then(future_t* future, future_then_t* then, future_proc_t proc, future_t* next)
+{
+    if(future == NULL || then == NULL || next == NULL) return E_NULL_POINTER;
+    
+    then->proc = proc;
+    then->next = next;
+    
+    future_init(next);
+    future_start(next);
+    
+    future_set_callback(future, future_then_callback, then);
+    
+    return E_NO_ERROR;
+}
+
+static void future_all_callback(future_t* future, void* arg)
+{
+    (void)future;
+    
+    future_all_t* all = (future_all_t*)arg;
+    
+#ifndef __arm__
+    pthread_mutex_lock(&future_mutex);
+#endif
+    
+    CRITICAL_ENTER();
+    
+    size_t remaining = -- all->remaining;
+    
+    CRITICAL_EXIT();
+    
+#ifndef __arm__
+    pthread_mutex_unlock(&future_mutex);
+#endif
+    
+    if(remaining == 0) future_finish(all->future, NULL);
+}
+
+err_t future_when_all(future_all_t* all, future_t** futures, size_t count, future_t* future)
+{
+    if(all == NULL || future == NULL) return E_NULL_POINTER;
+    if(futures == NULL && count != 0) return E_NULL_POINTER;
+    
+    all->future = future;
+    // Дополнительная единица исключает завершение до
+    // установки продолжений всех будущих.
+    all->remaining = count + 1;
+    
+    future_init(future);
+    future_start(future);
+    
+    size_t i;
+    for(i = 0; i < count; i ++){
+        future_set_callback(futures[i], future_all_callback, all);
+    }
+    
+    future_all_callback(future, all);
+    
+    return E_NO_ERROR;
 }
@@ -1,14 +1,40 @@
 /**
  * @file future.h
  * Библиотека для работы с ещё не наступившем событием.
+ * По завершении будущего вызывается установленная
+ * функция продолжения, на её основе реализованы
+ * цепочки будущих (future_then) и ожидание завершения
+ * нескольких будущих (future_when_all).
+ * Ожидание завершения на целевой платформе выполняется
+ * в режиме пониженного энергопотребления (WFE),
+ * на хосте - с помощью условной переменной.
  */
 
 #ifndef FUTURE_H
 #define	FUTURE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "errors/errors.h"
 #include "defs/defs.h"
 
+struct _Future;
+
+/**
+ * Тип функции продолжения будущего.
+ * Вызывается в контексте завершившего будущее кода.
+ * @param future Завершённое будущее.
+ * @param arg Аргумент.
+ */
+typedef void (*future_callback_t)(struct _Future* future, void* arg);
+
+/**
+ * Тип функции обработки результата в цепочке будущих.
+ * @param result Результат предыдущего будущего.
+ * @return Результат следующего будущего.
+ */
+typedef void* (*future_proc_t)(void* result);
+
 /**
  * Структура будущего.
  */
@@ -19,8 +45,24 @@ typedef struct _Future {
     volatile bool done;
     //! Флаг выполнения.
     volatile bool running;
+    //! Функция продолжения.
+    future_callback_t callback;
+    //! Аргумент функции продолжения.
+    void* callback_arg;
 }future_t;
 
+//! Звено цепочки будущих.
+typedef struct _Future_Then {
+    future_proc_t proc; //!< Функция обработки результата.
+    future_t* next; //!< Следующее будущее.
+} future_then_t;
+
+//! Ожидание завершения нескольких будущих.
+typedef struct _Future_All {
+    future_t* future; //!< Будущее, завершаемое по завершении всех.
+    volatile size_t remaining; //!< Число незавершённых будущих.
+} future_all_t;
+
 /**
  * Инициализирует будущее.
  * Незавершённое, невыполняющееся, с нулевым результатом.
@@ -89,5 +131,50 @@ EXTERN void future_finish(future_t* future, void* result);
  */
 EXTERN void future_wait(const future_t* future);
 
+/**
+ * Устанавливает функцию продолжения будущего.
+ * Функция вызывается при завершении будущего
+ * (см. future_finish), если будущее уже завершено -
+ * вызывается немедленно.
+ * Будущее имеет одну функцию продолжения,
+ * ранее установленная функция заменяется.
+ * Функция сбрасывается при инициализации будущего,
+ * поэтому её следует устанавливать после запуска
+ * задачи или таймера, использующих будущее.
+ * @param future Будущее.
+ * @param callback Функция продолжения.
+ * @param arg Аргумент функции продолжения.
+ */
+EXTERN void future_set_callback(future_t* future, future_callback_t callback, void* arg);
+
+/**
+ * Продолжает будущее следующим.
+ * Следующее будущее инициализируется и запускается,
+ * поэтому его можно ожидать сразу, а цепочка
+ * строится от первого будущего к последнему.
+ * По завершении будущего функция обработки вызывается
+ * с результатом будущего, и следующее будущее
+ * завершается с её результатом.
+ * @param future Будущее.
+ * @param then Звено цепочки, должно существовать до завершения.
+ * @param proc Функция обработки результата.
+ * @param next Следующее будущее.
+ * @return Код ошибки.
+ */
+EXTERN err_t future_then(future_t* future, future_then_t* then, future_proc_t proc, future_t* next);
+
+/**
+ * Ожидает завершения нескольких будущих.
+ * Результирующее будущее запускается и завершается
+ * с нулевым результатом по завершении всех будущих.
+ * Использует функции продолжения будущих.
+ * @param all Структура ожидания, должна существовать до завершения.
+ * @param futures Массив будущих.
+ * @param count Число будущих.
+ * @param future Результирующее будущее.
+ * @return Код ошибки.
+ */
+EXTERN err_t future_when_all(future_all_t* all, future_t** futures, size_t count, future_t* future);
+
 #endif	/* FUTURE_H */
 
@@ -109,6 +109,18 @@ bool font_get_char_bitmap_position(const font_t* font, font_char_t c, const font
     return true;
 }
 
+bool font_monospaced(const font_t* font)
+{
+    if(font->bitmaps == NULL) return true;
+    
+    size_t i;
+    for(i = 0; i < font->bitmaps_count; i ++){
+        if(font->bitmaps[i].char_descrs) return false;
+    }
+    
+    return true;
+}
+
 size_t font_utf8_size(const char* c)
 {
     unsigned char first_c = *c;
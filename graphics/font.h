@@ -202,6 +202,15 @@ EXTERN bool font_get_char_position(const font_t* font, font_char_t c, rect_t* re
  */
 EXTERN bool font_get_char_bitmap_position(const font_t* font, font_char_t c, const font_bitmap_t** font_bitmap, rect_t* rect, point_t* offset);
 
+/**
+ * Получает флаг моноширинности шрифта.
+ * Шрифт моноширинный, если ни одна из его
+ * битовых карт не содержит дескрипторов символов.
+ * @param font Шрифт.
+ * @return Флаг моноширинности шрифта.
+ */
+EXTERN bool font_monospaced(const font_t* font);
+
 /**
  * Получает ширину символа шрифта.
  * @param font Шрифт.
@@ -41,6 +41,9 @@ err_t painter_init(painter_t* painter, graphics_t* graphics)
     painter->scissor_enabled = false;
     point_init(&painter->offset_point);
     painter->offset_enabled = false;
+#ifdef USE_PAINTER_PIXELS_COUNTER
+    painter->pixels_count = 0;
+#endif
 
     return E_NO_ERROR;
 }
@@ -60,6 +63,9 @@ static ALWAYS_INLINE void painter_put_pixel(painter_t* painter, graphics_pos_t x
     if(painter->offset_enabled)
         { x += point_x(&painter->offset_point); y += point_y(&painter->offset_point); }
     if(painter->scissor_enabled && !rect_contains(&painter->scissor_rect, x, y)) return;
+#ifdef USE_PAINTER_PIXELS_COUNTER
+    painter->pixels_count ++;
+#endif
     switch(painter->mode){
         default:
         case PAINTER_MODE_SET:
@@ -399,6 +405,10 @@ static bool painter_fast_fillrect_impl(painter_t* painter, graphics_pos_t left,
     
     if(left > right || top > bottom) return true;
     
+#ifdef USE_PAINTER_PIXELS_COUNTER
+    painter->pixels_count += (uint32_t)(right - left + 1) * (uint32_t)(bottom - top + 1);
+#endif
+    
     return graphics_fast_fillrect(painter_graphics(painter), left, top,
                                   right, bottom, painter_brush_color(painter));
 }
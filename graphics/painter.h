@@ -103,6 +103,9 @@ typedef struct _Painter {
     bool scissor_enabled; //!< Разрешённость проверки пикселов на вхождение в область отсечения.
     point_t offset_point; //!< Смещение рисуемых пикселов.
     bool offset_enabled; //!< Разрешённость смещения рисуемых пикселов.
+#ifdef USE_PAINTER_PIXELS_COUNTER
+    uint32_t pixels_count; //!< Число нарисованных пикселов.
+#endif
 } painter_t;
 
 /**
@@ -547,6 +550,27 @@ static ALWAYS_INLINE graphics_color_t painter_get_pixel(const painter_t* painter
     return graphics_get_pixel(painter->graphics, x, y);
 }
 
+#ifdef USE_PAINTER_PIXELS_COUNTER
+/**
+ * Получает число нарисованных пикселов.
+ * @param painter Рисовальщик.
+ * @return Число нарисованных пикселов.
+ */
+static ALWAYS_INLINE uint32_t painter_pixels_count(const painter_t* painter)
+{
+    return painter->pixels_count;
+}
+
+/**
+ * Сбрасывает число нарисованных пикселов.
+ * @param painter Рисовальщик.
+ */
+static ALWAYS_INLINE void painter_reset_pixels_count(painter_t* painter)
+{
+    painter->pixels_count = 0;
+}
+#endif
+
 /**
  * Сбрасывает буфер изображения в устройство.
  * Имеет смысл лишь для виртуального
@@ -305,5 +305,18 @@ ALWAYS_INLINE static void rect_clip(rect_t* rect, const rect_t* border_rect)
     if(rect->bottom > border_rect->bottom) rect->bottom = border_rect->bottom;
 }
 
+/**
+ * Расширяет прямоугольную область до объединения с другой областью.
+ * @param rect Прямоугольная область.
+ * @param other_rect Добавляемая прямоугольная область.
+ */
+ALWAYS_INLINE static void rect_union(rect_t* rect, const rect_t* other_rect)
+{
+    if(rect->left   > other_rect->left)   rect->left   = other_rect->left;
+    if(rect->top    > other_rect->top)    rect->top    = other_rect->top;
+    if(rect->right  < other_rect->right)  rect->right  = other_rect->right;
+    if(rect->bottom < other_rect->bottom) rect->bottom = other_rect->bottom;
+}
+
 #endif	/* RECT_H */
 
@@ -2,7 +2,14 @@
 #include "gui_widget.h"
 #include "graphics/rect.h"
 #include "input/key_input.h"
+#include "utils/utils.h"
+#include "utils/critical.h"
+#include <string.h>
 
+#ifdef USE_GUI_PROFILER
+#include <stdio.h>
+#include "utils/cycles.h"
+#endif
 
 
 err_t gui_init(gui_t* gui, graphics_t* graphics, gui_theme_t* theme)
@@ -14,6 +21,20 @@ err_t gui_init(gui_t* gui, graphics_t* graphics, gui_theme_t* theme)
     gui->theme = theme;
     gui->root_widget = NULL;
     
+    memset(&gui->input_queue, 0x0, sizeof(gui_input_queue_t));
+    gui->repaint_deferred = false;
+    gui->repaint_pending = false;
+    rect_init(&gui->repaint_rect);
+    
+#ifdef USE_GUI_PROFILER
+    memset(&gui->frame_stats, 0x0, sizeof(gui_paint_stats_t));
+    gui->frame_start = 0;
+    gui->frame_cycles = 0;
+    gui->frames_count = 0;
+    
+    cycles_init();
+#endif
+    
     return E_NO_ERROR;
 }
 
@@ -196,3 +217,288 @@ void gui_key_released(gui_t* gui, keycode_t key)
     
     gui_widget_key_event(gui->focus_widget, &event);
 }
+
+ALWAYS_INLINE static size_t gui_input_queue_prev_index(size_t index)
+{
+    return (index == 0) ? (GUI_INPUT_QUEUE_SIZE - 1) : (index - 1);
+}
+
+static gui_input_t* gui_input_queue_last(gui_input_queue_t* queue)
+{
+    if(queue->count == 0) return NULL;
+    return &queue->inputs[gui_input_queue_prev_index(queue->put)];
+}
+
+static gui_input_t* gui_input_queue_prev_last(gui_input_queue_t* queue)
+{
+    if(queue->count < 2) return NULL;
+    return &queue->inputs[gui_input_queue_prev_index(gui_input_queue_prev_index(queue->put))];
+}
+
+static void gui_input_queue_drop_last(gui_input_queue_t* queue)
+{
+    queue->put = gui_input_queue_prev_index(queue->put);
+    queue->count --;
+}
+
+static bool gui_input_queue_push(gui_input_queue_t* queue, gui_input_type_t type, keycode_t key, int16_t count)
+{
+    if(queue->count >= GUI_INPUT_QUEUE_SIZE){
+        queue->overruns ++;
+        return false;
+    }
+    
+    gui_input_t* input = &queue->inputs[queue->put];
+    
+    input->type = type;
+    input->key = key;
+    input->count = count;
+    
+    CYCLIC_INC(queue->put, 0, GUI_INPUT_QUEUE_SIZE);
+    queue->count ++;
+    
+    return true;
+}
+
+static bool gui_input_queue_take(gui_input_queue_t* queue, gui_input_t* input)
+{
+    bool res = false;
+    
+    CRITICAL_ENTER();
+    
+    if(queue->count != 0){
+        memcpy(input, &queue->inputs[queue->get], sizeof(gui_input_t));
+        CYCLIC_INC(queue->get, 0, GUI_INPUT_QUEUE_SIZE);
+        queue->count --;
+        res = true;
+    }
+    
+    CRITICAL_EXIT();
+    
+    return res;
+}
+
+bool gui_post_key_pressed(gui_t* gui, keycode_t key)
+{
+    gui_input_queue_t* queue = &gui->input_queue;
+    bool res = true;
+    
+    CRITICAL_ENTER();
+    
+    gui_input_t* last = gui_input_queue_last(queue);
+    
+    // Повторное нажатие удерживаемой клавиши.
+    if(last && last->type == GUI_INPUT_KEY_PRESS && last->key == key && last->count < INT16_MAX){
+        last->count ++;
+    }else{
+        res = gui_input_queue_push(queue, GUI_INPUT_KEY_PRESS, key, 1);
+    }
+    
+    CRITICAL_EXIT();
+    
+    return res;
+}
+
+bool gui_post_key_released(gui_t* gui, keycode_t key)
+{
+    gui_input_queue_t* queue = &gui->input_queue;
+    bool res = true;
+    
+    CRITICAL_ENTER();
+    
+    gui_input_t* last = gui_input_queue_last(queue);
+    
+    if(last && last->type == GUI_INPUT_KEY_PRESS && last->key == key && last->count == 1){
+        gui_input_t* prev = gui_input_queue_prev_last(queue);
+        // Серия нажатий одной клавиши.
+        if(prev && prev->type == GUI_INPUT_KEY_CLICK && prev->key == key && prev->count < INT16_MAX){
+            prev->count ++;
+            gui_input_queue_drop_last(queue);
+        }else{
+            last->type = GUI_INPUT_KEY_CLICK;
+        }
+    }else{
+        res = gui_input_queue_push(queue, GUI_INPUT_KEY_RELEASE, key, 1);
+    }
+    
+    CRITICAL_EXIT();
+    
+    return res;
+}
+
+static bool gui_post_focus_move(gui_t* gui, int16_t delta)
+{
+    gui_input_queue_t* queue = &gui->input_queue;
+    bool res = true;
+    
+    CRITICAL_ENTER();
+    
+    gui_input_t* last = gui_input_queue_last(queue);
+    
+    if(last && last->type == GUI_INPUT_FOCUS_MOVE && ABS(last->count + delta) <= INT16_MAX){
+        last->count += delta;
+        // Перемещения взаимно скомпенсировались.
+        if(last->count == 0) gui_input_queue_drop_last(queue);
+    }else{
+        res = gui_input_queue_push(queue, GUI_INPUT_FOCUS_MOVE, 0, delta);
+    }
+    
+    CRITICAL_EXIT();
+    
+    return res;
+}
+
+bool gui_post_focus_next(gui_t* gui)
+{
+    return gui_post_focus_move(gui, 1);
+}
+
+bool gui_post_focus_prev(gui_t* gui)
+{
+    return gui_post_focus_move(gui, -1);
+}
+
+void gui_set_key_repeat(gui_t* gui, uint32_t delay, uint32_t period)
+{
+    gui->input_queue.repeat_delay = delay;
+    gui->input_queue.repeat_period = period;
+    if(delay == 0) gui->input_queue.repeat_active = false;
+}
+
+static void gui_key_repeat_start(gui_input_queue_t* queue, keycode_t key, uint32_t time)
+{
+    if(queue->repeat_delay == 0) return;
+    
+    queue->repeat_key = key;
+    queue->repeat_time = time + queue->repeat_delay;
+    queue->repeat_active = true;
+}
+
+static void gui_key_repeat_stop(gui_input_queue_t* queue, keycode_t key)
+{
+    if(queue->repeat_active && queue->repeat_key == key){
+        queue->repeat_active = false;
+    }
+}
+
+static void gui_dispatch_input(gui_t* gui, const gui_input_t* input, uint32_t time)
+{
+    int16_t i;
+    
+    switch(input->type){
+        case GUI_INPUT_KEY_PRESS:
+            for(i = 0; i < input->count; i ++){
+                gui_key_pressed(gui, input->key);
+            }
+            gui_key_repeat_start(&gui->input_queue, input->key, time);
+            break;
+        case GUI_INPUT_KEY_RELEASE:
+            gui_key_released(gui, input->key);
+            gui_key_repeat_stop(&gui->input_queue, input->key);
+            break;
+        case GUI_INPUT_KEY_CLICK:
+            for(i = 0; i < input->count; i ++){
+                gui_key_pressed(gui, input->key);
+                gui_key_released(gui, input->key);
+            }
+            gui_key_repeat_stop(&gui->input_queue, input->key);
+            break;
+        case GUI_INPUT_FOCUS_MOVE:
+            for(i = input->count; i > 0; i --){
+                gui_focus_next_widget(gui);
+            }
+            for(i = input->count; i < 0; i ++){
+                gui_focus_prev_widget(gui);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+size_t gui_process_events(gui_t* gui, uint32_t time)
+{
+    gui_input_queue_t* queue = &gui->input_queue;
+    gui_input_t input;
+    size_t count = 0;
+    
+    gui->repaint_deferred = true;
+    
+    while(gui_input_queue_take(queue, &input)){
+        gui_dispatch_input(gui, &input, time);
+        count ++;
+    }
+    
+    if(queue->repeat_active && (int32_t)(time - queue->repeat_time) >= 0){
+        queue->repeat_time = time + queue->repeat_period;
+        gui_key_pressed(gui, queue->repeat_key);
+        count ++;
+    }
+    
+    gui->repaint_deferred = false;
+    
+    if(gui->repaint_pending){
+        gui->repaint_pending = false;
+        gui_repaint(gui, &gui->repaint_rect);
+    }
+    
+    return count;
+}
+
+#ifdef USE_GUI_PROFILER
+
+uint32_t gui_profiler_cycles(void)
+{
+    return cycles_get();
+}
+
+void gui_profiler_begin_frame(gui_t* gui)
+{
+    memset(&gui->frame_stats, 0x0, sizeof(gui_paint_stats_t));
+    
+    gui_widget_t* widget = gui_first_widget(gui->root_widget);
+    
+    while(widget){
+        gui_widget_reset_paint_stats(widget);
+        widget = gui_next_widget(widget);
+    }
+    
+    gui->frame_start = gui_profiler_cycles();
+}
+
+void gui_profiler_end_frame(gui_t* gui)
+{
+    gui->frame_cycles = gui_profiler_cycles() - gui->frame_start;
+    gui->frames_count ++;
+}
+
+void gui_profiler_dump(gui_t* gui)
+{
+    const gui_paint_stats_t* stats = NULL;
+    
+    printf("%8s %8s %10s %10s %10s\r\n", "id", "type", "repaints", "pixels", "cycles");
+    
+    gui_widget_t* widget = gui_first_widget(gui->root_widget);
+    
+    while(widget){
+        stats = gui_widget_paint_stats(widget);
+        if(stats->repaints != 0){
+            printf("%8d %8d %10lu %10lu %10lu\r\n",
+                    (int)gui_widget_id(widget), (int)gui_widget_type_id(widget),
+                    (unsigned long)stats->repaints, (unsigned long)stats->pixels,
+                    (unsigned long)stats->cycles);
+        }
+        widget = gui_next_widget(widget);
+    }
+    
+    stats = &gui->frame_stats;
+    
+    printf("%17s %10lu %10lu %10lu\r\n", "total",
+            (unsigned long)stats->repaints, (unsigned long)stats->pixels,
+            (unsigned long)stats->cycles);
+    printf("%17s %10lu %10s %10lu\r\n", "frame",
+            (unsigned long)gui->frames_count, "",
+            (unsigned long)gui->frame_cycles);
+}
+
+#endif //USE_GUI_PROFILER
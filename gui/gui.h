@@ -48,12 +48,78 @@ typedef struct _Gui_Theme {
 typedef struct _Gui_Widget gui_widget_t;
 #endif //GUI_WIDGET_TYPE_DEFINED
 
+//! Размер очереди событий ввода.
+#ifndef GUI_INPUT_QUEUE_SIZE
+#define GUI_INPUT_QUEUE_SIZE 16
+#endif
+
+//! Тип события ввода в очереди.
+typedef enum _Gui_Input_Type {
+    GUI_INPUT_KEY_PRESS = 0, //!< Нажатие клавиши.
+    GUI_INPUT_KEY_RELEASE, //!< Отпускание клавиши.
+    GUI_INPUT_KEY_CLICK, //!< Нажатие и отпускание клавиши.
+    GUI_INPUT_FOCUS_MOVE //!< Перемещение фокуса.
+} gui_input_type_t;
+
+/**
+ * Структура события ввода в очереди.
+ * Повторяющиеся события объединяются в одно
+ * с числом повторений count, для перемещения
+ * фокуса count - смещение фокуса со знаком.
+ */
+typedef struct _Gui_Input {
+    uint8_t type; //!< Тип события.
+    keycode_t key; //!< Код клавиши.
+    int16_t count; //!< Число повторений.
+} gui_input_t;
+
+//! Структура очереди событий ввода.
+typedef struct _Gui_Input_Queue {
+    gui_input_t inputs[GUI_INPUT_QUEUE_SIZE]; //!< События.
+    volatile size_t put; //!< Индекс добавления.
+    volatile size_t get; //!< Индекс извлечения.
+    volatile size_t count; //!< Число событий.
+    volatile uint32_t overruns; //!< Число потерянных при переполнении событий.
+    uint32_t repeat_delay; //!< Задержка до начала автоповтора, 0 - автоповтор запрещён.
+    uint32_t repeat_period; //!< Период автоповтора.
+    uint32_t repeat_time; //!< Время следующего автоповтора.
+    keycode_t repeat_key; //!< Клавиша автоповтора.
+    bool repeat_active; //!< Флаг удержания клавиши автоповтора.
+} gui_input_queue_t;
+
+#ifdef USE_GUI_PROFILER
+#ifndef USE_PAINTER_PIXELS_COUNTER
+#error gui profiler need defined USE_PAINTER_PIXELS_COUNTER!
+#endif
+
+/**
+ * Структура статистики отрисовки.
+ * Время измеряется в тактах счётчика DWT
+ * на целевой платформе и в наносекундах на хосте.
+ */
+typedef struct _Gui_Paint_Stats {
+    uint32_t repaints; //!< Число вызовов обработчика перерисовки.
+    uint32_t pixels; //!< Число нарисованных пикселов.
+    uint32_t cycles; //!< Время выполнения обработчиков перерисовки.
+} gui_paint_stats_t;
+#endif
+
 //! Структура графического интерфейса.
 typedef struct _Gui {
     graphics_t* graphics; //!< Графический буфер.
     gui_theme_t* theme; //!< Тема оформления.
     gui_widget_t* root_widget; //!< Корневой виджет.
     gui_widget_t* focus_widget; //!< Виджет в фокусе.
+    gui_input_queue_t input_queue; //!< Очередь событий ввода.
+    bool repaint_deferred; //!< Флаг отложенной перерисовки.
+    bool repaint_pending; //!< Флаг наличия отложенной перерисовки.
+    rect_t repaint_rect; //!< Область отложенной перерисовки.
+#ifdef USE_GUI_PROFILER
+    gui_paint_stats_t frame_stats; //!< Статистика отрисовки кадра.
+    uint32_t frame_start; //!< Время начала кадра.
+    uint32_t frame_cycles; //!< Длительность последнего кадра.
+    uint32_t frames_count; //!< Число кадров.
+#endif
 } gui_t;
 
 #define MAKE_GUI(arg_graphics, arg_theme)\
@@ -204,5 +270,130 @@ EXTERN void gui_key_pressed(gui_t* gui, keycode_t key);
  */
 EXTERN void gui_key_released(gui_t* gui, keycode_t key);
 
+/**
+ * Помещает нажатие клавиши в очередь событий.
+ * Может вызываться из прерывания.
+ * @param gui Графический интерфейс.
+ * @param key Код клавиши.
+ * @return true, если событие помещено в очередь, иначе false.
+ */
+EXTERN bool gui_post_key_pressed(gui_t* gui, keycode_t key);
+
+/**
+ * Помещает отпускание клавиши в очередь событий.
+ * Может вызываться из прерывания.
+ * @param gui Графический интерфейс.
+ * @param key Код клавиши.
+ * @return true, если событие помещено в очередь, иначе false.
+ */
+EXTERN bool gui_post_key_released(gui_t* gui, keycode_t key);
+
+/**
+ * Помещает перемещение фокуса на следующий виджет в очередь событий.
+ * Может вызываться из прерывания.
+ * @param gui Графический интерфейс.
+ * @return true, если событие помещено в очередь, иначе false.
+ */
+EXTERN bool gui_post_focus_next(gui_t* gui);
+
+/**
+ * Помещает перемещение фокуса на предыдущий виджет в очередь событий.
+ * Может вызываться из прерывания.
+ * @param gui Графический интерфейс.
+ * @return true, если событие помещено в очередь, иначе false.
+ */
+EXTERN bool gui_post_focus_prev(gui_t* gui);
+
+/**
+ * Устанавливает параметры автоповтора удерживаемой клавиши.
+ * @param gui Графический интерфейс.
+ * @param delay Задержка до начала автоповтора, 0 для запрета автоповтора.
+ * @param period Период автоповтора.
+ */
+EXTERN void gui_set_key_repeat(gui_t* gui, uint32_t delay, uint32_t period);
+
+/**
+ * Получает число потерянных при переполнении очереди событий.
+ * @param gui Графический интерфейс.
+ * @return Число потерянных событий.
+ */
+ALWAYS_INLINE static uint32_t gui_input_overruns(gui_t* gui)
+{
+    return gui->input_queue.overruns;
+}
+
+/**
+ * Обрабатывает накопленные в очереди события
+ * и генерирует автоповтор удерживаемой клавиши.
+ * Перерисовка виджетов, запрошенная при обработке,
+ * выполняется однократно после обработки всех событий.
+ * Должна вызываться из главного цикла.
+ * @param gui Графический интерфейс.
+ * @param time Текущее время в единицах задержки автоповтора.
+ * @return Число обработанных событий.
+ */
+EXTERN size_t gui_process_events(gui_t* gui, uint32_t time);
+
+#ifdef USE_GUI_PROFILER
+
+/**
+ * Получает текущее значение счётчика времени профилировщика.
+ * На целевой платформе - такты DWT, на хосте - наносекунды.
+ * @return Значение счётчика времени.
+ */
+EXTERN uint32_t gui_profiler_cycles(void);
+
+/**
+ * Начинает кадр профилирования.
+ * Сбрасывает статистику кадра и всех виджетов.
+ * @param gui Графический интерфейс.
+ */
+EXTERN void gui_profiler_begin_frame(gui_t* gui);
+
+/**
+ * Завершает кадр профилирования.
+ * @param gui Графический интерфейс.
+ */
+EXTERN void gui_profiler_end_frame(gui_t* gui);
+
+/**
+ * Получает статистику отрисовки текущего кадра.
+ * @param gui Графический интерфейс.
+ * @return Статистика отрисовки кадра.
+ */
+ALWAYS_INLINE static const gui_paint_stats_t* gui_profiler_frame_stats(gui_t* gui)
+{
+    return &gui->frame_stats;
+}
+
+/**
+ * Получает длительность последнего завершённого кадра.
+ * @param gui Графический интерфейс.
+ * @return Длительность кадра.
+ */
+ALWAYS_INLINE static uint32_t gui_profiler_frame_cycles(gui_t* gui)
+{
+    return gui->frame_cycles;
+}
+
+/**
+ * Получает число завершённых кадров.
+ * @param gui Графический интерфейс.
+ * @return Число кадров.
+ */
+ALWAYS_INLINE static uint32_t gui_profiler_frames_count(gui_t* gui)
+{
+    return gui->frames_count;
+}
+
+/**
+ * Выводит таблицу статистики отрисовки
+ * виджетов и кадра через printf.
+ * @param gui Графический интерфейс.
+ */
+EXTERN void gui_profiler_dump(gui_t* gui);
+
+#endif //USE_GUI_PROFILER
+
 #endif	/* GUI_H */
 
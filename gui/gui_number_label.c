@@ -1,7 +1,9 @@
 #include "gui_number_label.h"
 #include <stdio.h>
+#include <string.h>
 #include "utils/utils.h"
 #include "graphics/painter.h"
+#include "graphics/font.h"
 
 err_t gui_number_label_init(gui_number_label_t* label, gui_t* gui)
 {
@@ -17,15 +19,22 @@ err_t gui_number_label_init_parent(gui_number_label_t* label, gui_t* gui, gui_wi
     label->number = 0;
     label->format = GUI_NUMBER_LABEL_DEC;
     label->decimals = GUI_NUMBER_LABEL_DECIMALS_MAX;
+    label->text[0] = 0;
+    label->text_x = 0;
+    label->text_y = 0;
+    label->text_font = NULL;
+    label->text_valid = false;
     
     return E_NO_ERROR;
 }
 
+static void gui_number_label_repaint_text(gui_number_label_t* label);
+
 void gui_number_label_set_number(gui_number_label_t* label, int number)
 {
     if(label->number == number) return;
     label->number = number;
-    gui_widget_repaint(GUI_WIDGET(label), NULL);
+    gui_number_label_repaint_text(label);
 }
 
 void gui_number_label_set_format(gui_number_label_t* label, gui_number_label_format_t format)
@@ -42,8 +51,6 @@ void gui_number_label_set_decimals(gui_number_label_t* label, int decimals)
     }
 }
 
-//#define NUMBER_BUFFER_LEN 12 //-2 147 483 648
-#define NUMBER_BUFFER_LEN 19 //-2 147 483 648.123 456
 #define NUMBER_FORMAT_LEN 8 //%d.%06d
 
 static int gui_number_label_get_f32_fract(gui_number_label_t* label)
@@ -57,29 +64,15 @@ static int gui_number_label_get_f32_fract(gui_number_label_t* label)
     return fixed32_get_fract_by_denom((int64_t)fixed_abs(label->number), denom);
 }
 
-void gui_number_label_on_repaint(gui_number_label_t* label, const rect_t* rect)
+static void gui_number_label_format_text(gui_number_label_t* label, char* num_buffer)
 {
-    gui_widget_on_repaint(GUI_WIDGET(label), rect);
-    
-    gui_theme_t* theme = gui_theme(gui_object_gui(GUI_OBJECT(label)));
-    
-    painter_t painter;
-    
-    gui_widget_begin_paint(GUI_WIDGET(label), &painter, rect);
-    
-    painter_set_pen(&painter, PAINTER_PEN_SOLID);
-    painter_set_pen_color(&painter, theme->font_color);
-    painter_set_font(&painter, theme->widget_font);
-    painter_set_source_image_mode(&painter, PAINTER_SOURCE_IMAGE_MODE_BITMAP);
-    
-    char num_buffer[NUMBER_BUFFER_LEN];
     switch(label->format){
         default:
         case GUI_NUMBER_LABEL_DEC:
-            snprintf(num_buffer, NUMBER_BUFFER_LEN, "%d", label->number);
+            snprintf(num_buffer, GUI_NUMBER_LABEL_TEXT_LEN, "%d", label->number);
             break;
         case GUI_NUMBER_LABEL_HEX:
-            snprintf(num_buffer, NUMBER_BUFFER_LEN, "0x%x", label->number);
+            snprintf(num_buffer, GUI_NUMBER_LABEL_TEXT_LEN, "0x%x", label->number);
             break;
         case GUI_NUMBER_LABEL_FIX:{
             char num_format[NUMBER_FORMAT_LEN];
@@ -87,13 +80,178 @@ void gui_number_label_on_repaint(gui_number_label_t* label, const rect_t* rect)
             if(label->decimals != 0){
                 int fract_part = gui_number_label_get_f32_fract(label);
                 snprintf(num_format, NUMBER_FORMAT_LEN, "%%d.%%0%dd", (int)label->decimals);
-                snprintf(num_buffer, NUMBER_BUFFER_LEN, num_format, int_part, fract_part);
+                snprintf(num_buffer, GUI_NUMBER_LABEL_TEXT_LEN, num_format, int_part, fract_part);
             }else{
-                snprintf(num_buffer, NUMBER_BUFFER_LEN, "%d", int_part);
+                snprintf(num_buffer, GUI_NUMBER_LABEL_TEXT_LEN, "%d", int_part);
             }
             }
             break;
     }
+}
+
+/**
+ * Получает ширину знакоместа символа
+ * с учётом расстояния между символами.
+ * @param font Шрифт.
+ * @param c Символ.
+ * @return Ширина знакоместа.
+ */
+static graphics_size_t gui_number_label_char_width(const font_t* font, char c)
+{
+    rect_t char_rect;
+    point_t char_offset;
+    
+    if(!font_get_char_position(font, (font_char_t)(unsigned char)c, &char_rect, &char_offset)) return 0;
+    
+    return rect_width(&char_rect) + point_x(&char_offset) + font_hspace(font);
+}
+
+/**
+ * Получает ширину первых count символов текста.
+ * @param font Шрифт.
+ * @param text Текст.
+ * @param count Число символов.
+ * @return Ширина текста.
+ */
+static graphics_size_t gui_number_label_text_width(const font_t* font, const char* text, size_t count)
+{
+    graphics_size_t width = 0;
+    size_t i;
+    
+    for(i = 0; i < count; i ++){
+        width += gui_number_label_char_width(font, text[i]);
+    }
+    
+    return width;
+}
+
+/**
+ * Перерисовывает область метки.
+ * Координаты задаются относительно метки.
+ */
+static void gui_number_label_repaint_area(gui_number_label_t* label, const point_t* point,
+                                          graphics_pos_t left, graphics_pos_t top,
+                                          graphics_pos_t right, graphics_pos_t bottom)
+{
+    if(right < left || bottom < top) return;
+    
+    rect_t rect;
+    rect_init_position(&rect, point_x(point) + left, point_y(point) + top,
+                              point_x(point) + right, point_y(point) + bottom);
+    
+    gui_widget_repaint(GUI_WIDGET(label), &rect);
+}
+
+/**
+ * Перерисовывает изменившуюся часть текста метки.
+ * Сравнивает новый текст с последним отрисованным.
+ * При неизменной ширине текста и моноширинном шрифте
+ * перерисовываются только отличающиеся знакоместа,
+ * при неизменной ширине текста и пропорциональном шрифте -
+ * отрезок от первого до последнего отличающегося символа,
+ * иначе - объединение старого и нового текста.
+ * @param label Метка.
+ */
+static void gui_number_label_repaint_text(gui_number_label_t* label)
+{
+    gui_widget_t* widget = GUI_WIDGET(label);
+    
+    if(!gui_widget_visible(widget)) return;
+    
+    const font_t* font = gui_theme(gui_object_gui(GUI_OBJECT(label)))->widget_font;
+    
+    if(!label->text_valid || label->text_font != font || font == NULL){
+        gui_widget_repaint(widget, NULL);
+        return;
+    }
+    
+    char text[GUI_NUMBER_LABEL_TEXT_LEN];
+    gui_number_label_format_text(label, text);
+    
+    size_t len = strlen(text);
+    size_t old_len = strlen(label->text);
+    
+    // Общее начало текста.
+    size_t prefix = 0;
+    while(prefix < len && prefix < old_len && text[prefix] == label->text[prefix]) prefix ++;
+    
+    if(prefix == len && prefix == old_len) return;
+    
+    // Общий конец текста.
+    size_t suffix = 0;
+    while(suffix < len - prefix && suffix < old_len - prefix &&
+          text[len - suffix - 1] == label->text[old_len - suffix - 1]) suffix ++;
+    
+    graphics_pos_t width = (graphics_pos_t)gui_number_label_text_width(font, text, len);
+    graphics_pos_t old_width = (graphics_pos_t)gui_number_label_text_width(font, label->text, old_len);
+    
+    graphics_pos_t height = (graphics_pos_t)gui_widget_height(widget);
+    
+    point_t point;
+    gui_widget_screen_position(widget, &point);
+    
+    // Текст сместился.
+    if(width != old_width){
+        graphics_pos_t x = ((graphics_pos_t)gui_widget_width(widget) - width) / 2;
+        
+        gui_number_label_repaint_area(label, &point,
+                MIN(x, label->text_x), 0,
+                MAX(x + width, label->text_x + old_width) - 1, height - 1);
+        return;
+    }
+    
+    graphics_pos_t x = label->text_x + (graphics_pos_t)gui_number_label_text_width(font, text, prefix);
+    
+    if(!font_monospaced(font) || len != old_len){
+        gui_number_label_repaint_area(label, &point,
+                x, 0,
+                label->text_x + (graphics_pos_t)gui_number_label_text_width(font, text, len - suffix) - 1, height - 1);
+        return;
+    }
+    
+    // Моноширинный шрифт - перерисовка отличающихся знакомест.
+    graphics_pos_t top = label->text_y;
+    graphics_pos_t bottom = label->text_y + (graphics_pos_t)font_char_height(font) - 1;
+    graphics_pos_t cells_x = x;
+    bool cells_changed = false;
+    size_t i;
+    
+    for(i = prefix; i < len - suffix; i ++){
+        if(text[i] != label->text[i]){
+            if(!cells_changed){
+                cells_x = x;
+                cells_changed = true;
+            }
+        }else if(cells_changed){
+            gui_number_label_repaint_area(label, &point, cells_x, top, x - 1, bottom);
+            cells_changed = false;
+        }
+        x += (graphics_pos_t)gui_number_label_char_width(font, text[i]);
+    }
+    
+    if(cells_changed){
+        gui_number_label_repaint_area(label, &point, cells_x, top, x - 1, bottom);
+    }
+}
+
+void gui_number_label_on_repaint(gui_number_label_t* label, const rect_t* rect)
+{
+    gui_widget_on_repaint(GUI_WIDGET(label), rect);
+    
+    gui_theme_t* theme = gui_theme(gui_object_gui(GUI_OBJECT(label)));
+    
+    painter_t painter;
+    
+    gui_widget_begin_paint(GUI_WIDGET(label), &painter, rect);
+    
+    painter_set_pen(&painter, PAINTER_PEN_SOLID);
+    painter_set_pen_color(&painter, theme->font_color);
+    painter_set_font(&painter, theme->widget_font);
+    painter_set_source_image_mode(&painter, PAINTER_SOURCE_IMAGE_MODE_BITMAP);
+    
+    char num_buffer[GUI_NUMBER_LABEL_TEXT_LEN];
+    gui_number_label_format_text(label, num_buffer);
+    
     graphics_pos_t number_x, number_y;
     painter_string_size(&painter, num_buffer, (graphics_size_t*)&number_x, (graphics_size_t*)&number_y);
     
@@ -103,4 +261,10 @@ void gui_number_label_on_repaint(gui_number_label_t* label, const rect_t* rect)
     painter_draw_string(&painter, number_x, number_y, num_buffer);
     
     gui_widget_end_paint(GUI_WIDGET(label), &painter);
+    
+    memcpy(label->text, num_buffer, GUI_NUMBER_LABEL_TEXT_LEN);
+    label->text_x = number_x;
+    label->text_y = number_y;
+    label->text_font = theme->widget_font;
+    label->text_valid = true;
 }
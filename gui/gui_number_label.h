@@ -22,11 +22,19 @@ typedef struct _Gui_Number_Label gui_number_label_t;
 //! Зеначение идентификатора типа числовой метки.
 #define GUI_NUMBER_LABEL_TYPE_ID 2
 
+//! Размер буфера текста числа (-2 147 483 648.123 456).
+#define GUI_NUMBER_LABEL_TEXT_LEN 19
+
 struct _Gui_Number_Label {
     gui_widget_t super; //!< Суперкласс.
     int number; //!< Отображаемое число.
     gui_number_label_format_t format; //!< Формат числа.
     size_t decimals; //!< Число знаков дробной части для формата с фиксированной запятой.
+    char text[GUI_NUMBER_LABEL_TEXT_LEN]; //!< Последний отрисованный текст.
+    graphics_pos_t text_x; //!< Координата X последнего отрисованного текста.
+    graphics_pos_t text_y; //!< Координата Y последнего отрисованного текста.
+    const font_t* text_font; //!< Шрифт последнего отрисованного текста.
+    bool text_valid; //!< Флаг наличия отрисованного текста.
 };
 
 //! Приводит указатель label к типу числовой метки.
@@ -64,6 +72,9 @@ ALWAYS_INLINE static int gui_number_label_number(gui_number_label_t* label)
 
 /**
  * Устанавливает число метки.
+ * Перерисовываются только изменившиеся символы:
+ * для моноширинного шрифта - отличающиеся знакоместа,
+ * иначе - минимальный отрезок текста.
  * @param label Метка.
  * @param number Число метки.
  */
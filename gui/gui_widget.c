@@ -1,6 +1,9 @@
 #include "gui_widget.h"
 #include "utils/utils.h"
 #include "graphics/painter.h"
+#ifdef USE_GUI_PROFILER
+#include <string.h>
+#endif
 
 
 static widget_id_t next_widget_id = 1;
@@ -25,9 +28,37 @@ void gui_widget_repaint_event(gui_widget_t* widget, gui_repaint_event_t* event)
     if(gui_widget_width(widget) == 0 || gui_widget_height(widget) == 0) return;
     
     rect_t* rect = NULL;
-    if(event) rect = &event->rect;
+    bool paint = true;
     
-    if(widget->on_repaint) widget->on_repaint(widget, rect);
+    if(event){
+        rect = &event->rect;
+        
+        // Видимая область виджета не пересекается с областью перерисовки.
+        rect_t widget_rect;
+        gui_widget_screen_visible_position(widget, NULL, &widget_rect);
+        rect_clip(&widget_rect, rect);
+        if(rect_left(&widget_rect) > rect_right(&widget_rect) ||
+           rect_top(&widget_rect) > rect_bottom(&widget_rect)) paint = false;
+    }
+    
+    if(paint && widget->on_repaint){
+#ifdef USE_GUI_PROFILER
+        uint32_t cycles = gui_profiler_cycles();
+#endif
+        
+        widget->on_repaint(widget, rect);
+        
+#ifdef USE_GUI_PROFILER
+        cycles = gui_profiler_cycles() - cycles;
+        
+        gui_t* gui = gui_widget_gui(widget);
+        
+        widget->paint_stats.repaints ++;
+        widget->paint_stats.cycles += cycles;
+        gui->frame_stats.repaints ++;
+        gui->frame_stats.cycles += cycles;
+#endif
+    }
     
     list_foreach2_second(&GUI_OBJECT(widget)->childs, gui_wdiget_foreach_childs_repaint, event);
 }
@@ -63,6 +94,9 @@ err_t gui_widget_init_parent(gui_widget_t* widget, gui_t* gui, gui_widget_t* par
     widget->on_repaint = gui_widget_on_repaint;
     widget->on_key_press = gui_widget_on_key_press;
     widget->on_key_release = gui_widget_on_key_release;
+#ifdef USE_GUI_PROFILER
+    gui_widget_reset_paint_stats(widget);
+#endif
     
     return E_NO_ERROR;
 }
@@ -321,6 +355,20 @@ void gui_widget_repaint(gui_widget_t* widget, const rect_t* rect)
         gui_widget_screen_rect(widget, &widget_rect);
         gui_repaint_event_init_rect(&event, &widget_rect);
     }
+    
+    gui_t* gui = gui_widget_gui(widget);
+    
+    // Перерисовка будет выполнена после обработки очереди событий.
+    if(gui->repaint_deferred){
+        if(gui->repaint_pending){
+            rect_union(&gui->repaint_rect, &event.rect);
+        }else{
+            rect_copy(&gui->repaint_rect, &event.rect);
+            gui->repaint_pending = true;
+        }
+        return;
+    }
+    
     gui_widget_repaint_event(widget, &event);
 }
 
@@ -397,5 +445,21 @@ err_t gui_widget_end_paint(gui_widget_t* widget, painter_t* painter)
     
     painter_flush(painter);
     
+#ifdef USE_GUI_PROFILER
+    uint32_t pixels = painter_pixels_count(painter);
+    
+    widget->paint_stats.pixels += pixels;
+    gui_widget_gui(widget)->frame_stats.pixels += pixels;
+    
+    painter_reset_pixels_count(painter);
+#endif
+    
     return E_NO_ERROR;
 }
+
+#ifdef USE_GUI_PROFILER
+void gui_widget_reset_paint_stats(gui_widget_t* widget)
+{
+    memset(&widget->paint_stats, 0x0, sizeof(gui_paint_stats_t));
+}
+#endif
@@ -43,6 +43,9 @@ struct _Gui_Widget {
     rect_t rect; //!< Прямоугольная область окна.
     gui_border_t border; //!< Тип границы виджета.
     graphics_color_t back_color; //!< Цвет фона виджета.
+#ifdef USE_GUI_PROFILER
+    gui_paint_stats_t paint_stats; //!< Статистика отрисовки виджета.
+#endif
     /**
      * Обработчик изменения размера.
      * @param widget Виджет.
@@ -531,5 +534,23 @@ ALWAYS_INLINE static gui_widget_t* gui_widget_prev_child(gui_widget_t* cur_child
     return GUI_WIDGET(gui_object_prev_child(GUI_OBJECT(cur_child)));
 }
 
+#ifdef USE_GUI_PROFILER
+/**
+ * Получает статистику отрисовки виджета.
+ * @param widget Виджет.
+ * @return Статистика отрисовки виджета.
+ */
+ALWAYS_INLINE static const gui_paint_stats_t* gui_widget_paint_stats(gui_widget_t* widget)
+{
+    return &widget->paint_stats;
+}
+
+/**
+ * Сбрасывает статистику отрисовки виджета.
+ * @param widget Виджет.
+ */
+EXTERN void gui_widget_reset_paint_stats(gui_widget_t* widget);
+#endif
+
 #endif	/* GUI_WIDGET_H */
 
@@ -0,0 +1,348 @@
+/**
+ * @file bench.c Измерение производительности Modbus RTU на модели линии.
+ * 1. Число запросов в секунду и задержка ответа ведущий-ведомый
+ * для каждой функции в реальном времени.
+ * 2. Время обработки запроса ведомым (modbus_rtu_dispatch)
+ * для каждой функции в моделируемом времени.
+ * 3. Время обработки прерывания IDLE ведомым при вычислении
+ * CRC принятого сообщения целиком и по мере приёма
+ * (прерывание половины передачи DMA и главный цикл
+ * каждые BENCH_POLL_BYTES байт), а также суммарное
+ * время вычисления CRC по мере приёма.
+ * Использование: bench [скорость, бод] [длительность на функцию, мс].
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "modbus_host.h"
+#include "modbus/modbus_rtu_master.h"
+
+
+//! Скорость по-умолчанию.
+#define BENCH_BAUD_DEFAULT 115200
+//! Длительность измерения функции по-умолчанию, мс.
+#define BENCH_DURATION_MS_DEFAULT 200
+
+//! Число запросов измерения обработки.
+#define BENCH_DISPATCH_ITERATIONS 20000
+
+//! Период главного цикла ведомого, байт.
+#define BENCH_POLL_BYTES 16
+
+//! Число регистров и флагов запросов.
+#define BENCH_REGS_COUNT 123
+#define BENCH_RW_REGS_COUNT 100
+#define BENCH_BITS_COUNT 1968
+
+
+/*
+ * Запросы в реальном времени.
+ */
+
+static modbus_rtu_master_t master;
+
+static uint16_t regs[BENCH_REGS_COUNT];
+static uint16_t rw_regs[BENCH_RW_REGS_COUNT];
+static uint8_t bits[BENCH_BITS_COUNT / 8];
+static uint16_t mask_reg[2] = {0x00ff, 0x5500};
+
+//! Число успешных выполнений запроса.
+static uint32_t requests_ok = 0;
+
+static void on_request_done(modbus_rtu_master_request_t* request)
+{
+    if(request->status == MODBUS_RTU_MASTER_STATUS_OK) requests_ok ++;
+}
+
+//! Запросы, по одному на измерение.
+static modbus_rtu_master_request_t requests[] = {
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_COILS_STATUS,
+     .reg_address = 0, .count = BENCH_BITS_COUNT, .data = bits, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_DISCR_INPUTS,
+     .reg_address = 0, .count = BENCH_BITS_COUNT, .data = bits, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_HOLDING_REGS,
+     .reg_address = 0, .count = BENCH_REGS_COUNT, .data = regs, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_INPUT_REGS,
+     .reg_address = 0, .count = BENCH_REGS_COUNT, .data = regs, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_WRITE_SINGLE_REG,
+     .reg_address = 10, .count = 1, .data = regs, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_WRITE_MULTIPLE_COILS,
+     .reg_address = 0, .count = BENCH_BITS_COUNT, .data = bits, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_WRITE_MULTIPLE_REGS,
+     .reg_address = 0, .count = BENCH_REGS_COUNT, .data = regs, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_CHANGE_REG,
+     .reg_address = 15, .count = 1, .data = mask_reg, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS,
+     .reg_address = 0, .count = BENCH_RW_REGS_COUNT, .data = rw_regs, .write_address = 0,
+     .write_count = BENCH_RW_REGS_COUNT, .write_data = rw_regs, .callback = on_request_done},
+};
+
+#define REQUESTS_COUNT (sizeof(requests) / sizeof(requests[0]))
+
+static modbus_rtu_master_slave_stats_t stats[1];
+
+static void on_master_msg_recv(void)
+{
+    modbus_rtu_master_msg_recv(&master);
+}
+
+static void on_master_msg_sent(void)
+{
+    modbus_rtu_master_msg_sent(&master);
+}
+
+/**
+ * Выполняет запрос без паузы в течение заданного времени.
+ * @return Код ошибки.
+ */
+static err_t bench_request(modbus_rtu_master_request_t* request, uint32_t baud, uint32_t duration_ms)
+{
+    modbus_rtu_master_init_t master_is;
+    err_t err;
+    
+    err = modbus_host_init(baud, true);
+    if(err != E_NO_ERROR) return err;
+    
+    modbus_host_set_master_callbacks(on_master_msg_recv, on_master_msg_sent);
+    
+    memset(stats, 0x0, sizeof(stats));
+    
+    master_is.modbus = modbus_host_master();
+    master_is.timers = NULL;
+    master_is.requests = request;
+    master_is.requests_count = 1;
+    master_is.stats = stats;
+    master_is.stats_count = 1;
+    master_is.baud = baud;
+    master_is.timeout_us = 0;
+    master_is.turnaround_us = 0;
+    master_is.retries = 0;
+    
+    err = modbus_rtu_master_init(&master, &master_is);
+    if(err != E_NO_ERROR) return err;
+    
+    requests_ok = 0;
+    
+    err = modbus_rtu_master_start(&master);
+    if(err != E_NO_ERROR) return err;
+    
+    uint64_t start_ns = usart_sim_time_ns();
+    uint64_t end_ns = start_ns + (uint64_t)duration_ms * 1000000;
+    uint64_t now_ns;
+    
+    do{
+        now_ns = usart_sim_time_ns();
+        modbus_host_process(now_ns);
+    }while(now_ns < end_ns);
+    
+    modbus_rtu_master_stop(&master);
+    
+    const modbus_rtu_master_slave_stats_t* s = modbus_rtu_master_slave_stats(&master, MODBUS_HOST_SLAVE_ADDRESS);
+    
+    printf("  %02x   %8.1f   %8u   %8u   %8u\n", request->func,
+           (double)requests_ok * 1000 / duration_ms, s->responses,
+           modbus_rtu_master_slave_stats_latency_avg(s), s->timeouts + s->invalid_responses);
+    
+    return E_NO_ERROR;
+}
+
+
+/*
+ * Обработка запросов в моделируемом времени.
+ */
+
+//! Время модели.
+static uint64_t now_ns = 1;
+
+static void put_u16(uint8_t* data, uint16_t value)
+{
+    data[0] = value >> 8;
+    data[1] = value & 0xff;
+}
+
+/**
+ * Формирует запрос к ведомому.
+ * @return Размер кадра.
+ */
+static size_t bench_make_frame(modbus_rtu_message_t* msg, modbus_rtu_func_t func)
+{
+    uint8_t* data = msg->adu.data_and_crc;
+    size_t size = 4;
+    size_t bytes;
+    
+    memset(msg, 0x0, sizeof(modbus_rtu_message_t));
+    
+    msg->adu.address = MODBUS_HOST_SLAVE_ADDRESS;
+    msg->adu.func = func;
+    
+    switch(func){
+        case MODBUS_RTU_FUNC_READ_COILS_STATUS:
+        case MODBUS_RTU_FUNC_READ_DISCR_INPUTS:
+            put_u16(&data[0], 0);
+            put_u16(&data[2], BENCH_BITS_COUNT);
+            break;
+        case MODBUS_RTU_FUNC_READ_HOLDING_REGS:
+        case MODBUS_RTU_FUNC_READ_INPUT_REGS:
+            put_u16(&data[0], 0);
+            put_u16(&data[2], BENCH_REGS_COUNT);
+            break;
+        case MODBUS_RTU_FUNC_WRITE_SINGLE_COIL:
+            put_u16(&data[0], 10);
+            put_u16(&data[2], 0xff00);
+            break;
+        case MODBUS_RTU_FUNC_WRITE_SINGLE_REG:
+            put_u16(&data[0], 10);
+            put_u16(&data[2], 0x1234);
+            break;
+        case MODBUS_RTU_FUNC_WRITE_MULTIPLE_COILS:
+            bytes = BENCH_BITS_COUNT / 8;
+            put_u16(&data[0], 0);
+            put_u16(&data[2], BENCH_BITS_COUNT);
+            data[4] = bytes;
+            memset(&data[5], 0xa5, bytes);
+            size = 5 + bytes;
+            break;
+        case MODBUS_RTU_FUNC_WRITE_MULTIPLE_REGS:
+            bytes = BENCH_REGS_COUNT * 2;
+            put_u16(&data[0], 0);
+            put_u16(&data[2], BENCH_REGS_COUNT);
+            data[4] = bytes;
+            memset(&data[5], 0x5a, bytes);
+            size = 5 + bytes;
+            break;
+        case MODBUS_RTU_FUNC_READ_SLAVE_ID:
+            size = 0;
+            break;
+        case MODBUS_RTU_FUNC_CHANGE_REG:
+            put_u16(&data[0], 15);
+            put_u16(&data[2], 0x00ff);
+            put_u16(&data[4], 0x5500);
+            size = 6;
+            break;
+        case MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS:
+            bytes = BENCH_RW_REGS_COUNT * 2;
+            put_u16(&data[0], 0);
+            put_u16(&data[2], BENCH_RW_REGS_COUNT);
+            put_u16(&data[4], 0);
+            put_u16(&data[6], BENCH_RW_REGS_COUNT);
+            data[8] = bytes;
+            memset(&data[9], 0x3c, bytes);
+            size = 9 + bytes;
+            break;
+        default:
+            break;
+    }
+    
+    msg->data_size = size;
+    modbus_rtu_message_calc_crc(msg);
+    
+    return size + MODBUS_RTU_FIELDS_CRC_SIZE;
+}
+
+//! Результаты измерения обработки запроса.
+typedef struct _Bench_Dispatch_Result {
+    uint64_t dispatch_ns; //!< Время обработки запроса.
+    uint64_t idle_ns; //!< Время прерывания IDLE.
+    uint64_t progress_ns; //!< Время вычисления CRC по мере приёма.
+} bench_dispatch_result_t;
+
+/**
+ * Передаёт ведомому запрос заданное число раз.
+ * @return Код ошибки.
+ */
+static err_t bench_dispatch(modbus_rtu_func_t func, bool rx_progress, bench_dispatch_result_t* result)
+{
+    modbus_rtu_message_t msg;
+    uint8_t* frame = (uint8_t*)&msg.adu;
+    size_t size = bench_make_frame(&msg, func);
+    usart_sim_port_t* port;
+    uint64_t byte_ns;
+    err_t err;
+    size_t i;
+    int it;
+    
+    err = modbus_host_init(BENCH_BAUD_DEFAULT, rx_progress);
+    if(err != E_NO_ERROR) return err;
+    
+    port = modbus_host_slave_port();
+    byte_ns = port->byte_time_ns;
+    now_ns = 1;
+    
+    for(it = 0; it < BENCH_DISPATCH_ITERATIONS; it ++){
+        for(i = 0; i < size; i ++){
+            now_ns += byte_ns;
+            usart_sim_rx_byte(port, frame[i], now_ns);
+            if((i % BENCH_POLL_BYTES) == BENCH_POLL_BYTES - 1){
+                modbus_host_process(now_ns);
+            }
+        }
+    
+        now_ns += byte_ns * 2;
+        modbus_host_process(now_ns);
+        now_ns += byte_ns * (MODBUS_RTU_PACKET_SIZE_MAX + 4);
+        modbus_host_process(now_ns);
+    }
+    
+    if(modbus_host_dispatch_count() != BENCH_DISPATCH_ITERATIONS) return E_STATE;
+    
+    result->dispatch_ns = modbus_host_dispatch_time_ns() / modbus_host_dispatch_count();
+    result->idle_ns = modbus_host_idle_time_ns() / modbus_host_idle_count();
+    result->progress_ns = modbus_host_progress_time_ns() / BENCH_DISPATCH_ITERATIONS;
+    
+    return E_NO_ERROR;
+}
+
+//! Функции измерения обработки.
+static const modbus_rtu_func_t dispatch_funcs[] = {
+    MODBUS_RTU_FUNC_READ_COILS_STATUS, MODBUS_RTU_FUNC_READ_DISCR_INPUTS,
+    MODBUS_RTU_FUNC_READ_HOLDING_REGS, MODBUS_RTU_FUNC_READ_INPUT_REGS,
+    MODBUS_RTU_FUNC_WRITE_SINGLE_COIL, MODBUS_RTU_FUNC_WRITE_SINGLE_REG,
+    MODBUS_RTU_FUNC_WRITE_MULTIPLE_COILS, MODBUS_RTU_FUNC_WRITE_MULTIPLE_REGS,
+    MODBUS_RTU_FUNC_READ_SLAVE_ID, MODBUS_RTU_FUNC_CHANGE_REG,
+    MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS,
+};
+
+#define DISPATCH_FUNCS_COUNT (sizeof(dispatch_funcs) / sizeof(dispatch_funcs[0]))
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = argc > 1 ? (uint32_t)atol(argv[1]) : BENCH_BAUD_DEFAULT;
+    uint32_t duration_ms = argc > 2 ? (uint32_t)atol(argv[2]) : BENCH_DURATION_MS_DEFAULT;
+    bench_dispatch_result_t whole, progress;
+    modbus_rtu_message_t msg;
+    size_t i;
+    
+    if(baud == 0 || duration_ms == 0){
+        printf("invalid arguments\n");
+        return 2;
+    }
+    
+    printf("loopback %u baud, %u ms per function\n", baud, duration_ms);
+    printf("func  requests/s  responses  latency,us  errors\n");
+    
+    for(i = 0; i < REQUESTS_COUNT; i ++){
+        if(bench_request(&requests[i], baud, duration_ms) != E_NO_ERROR){
+            printf("request %02x failed\n", requests[i].func);
+            return 1;
+        }
+    }
+    
+    printf("\nslave, %u requests per function, ns per request\n", BENCH_DISPATCH_ITERATIONS);
+    printf("func  bytes  dispatch  idle(whole)  idle(progress)  progress\n");
+    
+    for(i = 0; i < DISPATCH_FUNCS_COUNT; i ++){
+        if(bench_dispatch(dispatch_funcs[i], false, &whole) != E_NO_ERROR ||
+           bench_dispatch(dispatch_funcs[i], true, &progress) != E_NO_ERROR){
+            printf("dispatch %02x failed\n", dispatch_funcs[i]);
+            return 1;
+        }
+    
+        printf("  %02x  %5u  %8u  %11u  %14u  %8u\n", dispatch_funcs[i],
+               (unsigned)bench_make_frame(&msg, dispatch_funcs[i]),
+               (unsigned)whole.dispatch_ns, (unsigned)whole.idle_ns,
+               (unsigned)progress.idle_ns, (unsigned)progress.progress_ns);
+    }
+    
+    return 0;
+}
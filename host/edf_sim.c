@@ -0,0 +1,311 @@
+/**
+ * @file edf_sim.c Проверка планирования EDF (USE_SCHEDULER_EDF)
+ * на моделируемых часах таймеров (USE_TIMERS_SIM_CLOCK).
+ * Время выполнения задания моделируется продвижением часов
+ * timers_instance_sim_advance в функции задачи, простой
+ * планировщика - продвижением на один тик.
+ * Проверяются порядок запуска заданий (выбранное задание
+ * имеет наименьший абсолютный срок среди готовых, задачи
+ * с приоритетами не запускаются при готовых заданиях EDF)
+ * и число нарушений сроков deadline_misses планировщика,
+ * сравниваемое с независимо вычисленным тестом.
+ * Использование: edf_sim.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scheduler/scheduler.h"
+#include "timers/timers.h"
+
+#ifndef USE_SCHEDULER_EDF
+#error edf_sim requires USE_SCHEDULER_EDF
+#endif
+
+#ifndef USE_TIMERS_SIM_CLOCK
+#error edf_sim requires USE_TIMERS_SIM_CLOCK
+#endif
+
+
+//! Наибольшее число задач EDF случая проверки.
+#define EDF_SIM_TASKS_MAX 3
+
+//! Размер журнала порядка запуска.
+#define EDF_SIM_LOG_SIZE 16
+
+//! Ожидание хотя бы одного нарушения срока.
+#define EDF_SIM_MISSES_ANY (-1)
+
+
+//! Параметры задачи EDF.
+typedef struct _Edf_Sim_Task_Params {
+    char name; //!< Имя задачи в журнале.
+    scheduler_time_t period; //!< Период, 0 - однократная задача.
+    scheduler_time_t deadline; //!< Относительный срок.
+    scheduler_time_t cost; //!< Время выполнения задания.
+} edf_sim_task_params_t;
+
+//! Случай проверки.
+typedef struct _Edf_Sim_Case {
+    const char* name; //!< Название.
+    edf_sim_task_params_t tasks[EDF_SIM_TASKS_MAX]; //!< Задачи EDF, период и срок 0 - нет задачи.
+    bool prio_task; //!< Добавить однократную задачу с приоритетом.
+    scheduler_time_t duration; //!< Время моделирования.
+    const char* order; //!< Ожидаемый порядок запуска, NULL - не проверяется.
+    int misses; //!< Ожидаемое число нарушений сроков либо EDF_SIM_MISSES_ANY.
+} edf_sim_case_t;
+
+/**
+ * Случаи проверки.
+ * Однократные задачи добавляются не по порядку сроков.
+ * Загрузка периодических задач: 0.2 + 0.25 + 0.2 = 0.65
+ * и 0.6 + 0.5 = 1.1 (перегрузка).
+ */
+static const edf_sim_case_t cases[] = {
+    {"one-shot order", {{'A', 0, 30, 1}, {'B', 0, 10, 1}, {'C', 0, 20, 1}},
+        true, 10, "BCAP", 0},
+    {"one-shot misses", {{'A', 0, 12, 4}, {'B', 0, 6, 4}, {'C', 0, 3, 4}},
+        false, 20, "CBA", 2},
+    {"periodic, U=0.65", {{'A', 10, 10, 2}, {'B', 20, 20, 5}, {'C', 50, 50, 10}},
+        false, 1000, NULL, 0},
+    {"periodic, U=1.1", {{'A', 10, 10, 6}, {'B', 20, 20, 10}},
+        false, 1000, NULL, EDF_SIM_MISSES_ANY},
+};
+
+#define CASES_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+
+//! Состояние задачи EDF в модели теста.
+typedef struct _Edf_Sim_Task {
+    const edf_sim_task_params_t* params; //!< Параметры.
+    task_id_t tid; //!< Идентификатор задачи.
+    scheduler_time_t first_release; //!< Время готовности первого задания.
+    uint32_t jobs; //!< Число выполненных заданий.
+    uint32_t misses; //!< Число нарушений сроков.
+} edf_sim_task_t;
+
+static TASKS_BUFFER(tasks_buffer, EDF_SIM_TASKS_MAX + 1);
+static TASKS_EDF_HEAP_BUFFER(ready_heap, EDF_SIM_TASKS_MAX);
+static TASKS_EDF_HEAP_BUFFER(pending_heap, EDF_SIM_TASKS_MAX);
+static scheduler_t scheduler;
+
+static TIMERS_BUFFER(timers_buffer, 1);
+static timers_t timers;
+
+static edf_sim_task_t sim_tasks[EDF_SIM_TASKS_MAX];
+static size_t sim_tasks_count;
+
+//! Журнал порядка запуска.
+static char order_log[EDF_SIM_LOG_SIZE];
+static size_t order_log_size;
+//! Число нарушений порядка EDF.
+static uint32_t order_errors;
+
+static scheduler_time_t edf_sim_get_time(void)
+{
+    return (scheduler_time_t)timers_sim_get_ticks();
+}
+
+static void edf_sim_log(char name)
+{
+    if(order_log_size < EDF_SIM_LOG_SIZE - 1) order_log[order_log_size ++] = name;
+}
+
+//! Проверяет, завершены ли все задания однократной задачи.
+static bool edf_sim_task_done(const edf_sim_task_t* sim_task)
+{
+    return sim_task->params->period == 0 && sim_task->jobs != 0;
+}
+
+static scheduler_time_t edf_sim_task_release(const edf_sim_task_t* sim_task)
+{
+    return sim_task->first_release + sim_task->jobs * sim_task->params->period;
+}
+
+static scheduler_time_t edf_sim_task_abs_deadline(const edf_sim_task_t* sim_task)
+{
+    return edf_sim_task_release(sim_task) + sim_task->params->deadline;
+}
+
+//! Проверяет готовность задания задачи в заданное время.
+static bool edf_sim_task_ready(const edf_sim_task_t* sim_task, scheduler_time_t time)
+{
+    return !edf_sim_task_done(sim_task) && edf_sim_task_release(sim_task) <= time;
+}
+
+static void* edf_sim_task_proc(void* arg)
+{
+    edf_sim_task_t* sim_task = (edf_sim_task_t*)arg;
+    scheduler_time_t start = edf_sim_get_time();
+    scheduler_time_t abs_deadline = edf_sim_task_abs_deadline(sim_task);
+    size_t i;
+    
+    edf_sim_log(sim_task->params->name);
+    
+    if(!edf_sim_task_ready(sim_task, start)) order_errors ++;
+    
+    // Среди готовых заданий нет заданий с более ранним сроком.
+    for(i = 0; i < sim_tasks_count; i ++){
+        if(&sim_tasks[i] == sim_task) continue;
+        if(edf_sim_task_ready(&sim_tasks[i], start) &&
+           edf_sim_task_abs_deadline(&sim_tasks[i]) < abs_deadline){
+            order_errors ++;
+        }
+    }
+    
+    timers_instance_sim_advance(&timers, sim_task->params->cost);
+    
+    if(edf_sim_get_time() > abs_deadline) sim_task->misses ++;
+    sim_task->jobs ++;
+    
+    return NULL;
+}
+
+static void* edf_sim_prio_task_proc(void* arg)
+{
+    (void)arg;
+    
+    scheduler_time_t time = edf_sim_get_time();
+    size_t i;
+    
+    edf_sim_log('P');
+    
+    // Задачи с приоритетами запускаются только без готовых заданий EDF.
+    for(i = 0; i < sim_tasks_count; i ++){
+        if(edf_sim_task_ready(&sim_tasks[i], time)) order_errors ++;
+    }
+    
+    timers_instance_sim_advance(&timers, 1);
+    
+    return NULL;
+}
+
+static void edf_sim_init(void)
+{
+    timers_init_t is;
+    
+    is.buffer = timers_buffer;
+    is.count = 1;
+    is.get_ticks_callback = timers_sim_get_ticks;
+    is.setup_deadline_callback = timers_sim_setup_deadline;
+    is.slack = 0;
+    
+    timers_instance_init(&timers, &is);
+}
+
+/**
+ * Выполняет случай проверки.
+ * @return Число ошибок.
+ */
+static int edf_sim_run_case(const edf_sim_case_t* c)
+{
+    uint32_t model_misses = 0;
+    int errors = 0;
+    size_t i;
+    
+    scheduler_instance_init(&scheduler, tasks_buffer, EDF_SIM_TASKS_MAX + 1);
+    scheduler_instance_edf_init(&scheduler, ready_heap, pending_heap, EDF_SIM_TASKS_MAX, edf_sim_get_time);
+    
+    order_log_size = 0;
+    order_errors = 0;
+    sim_tasks_count = 0;
+    
+    scheduler_time_t start = edf_sim_get_time();
+    
+    if(c->prio_task){
+        scheduler_instance_add_task(&scheduler, edf_sim_prio_task_proc, 0, NULL, TASK_RUN_ONCE, NULL);
+    }
+    
+    for(i = 0; i < EDF_SIM_TASKS_MAX; i ++){
+        const edf_sim_task_params_t* params = &c->tasks[i];
+    
+        if(params->period == 0 && params->deadline == 0) break;
+    
+        edf_sim_task_t* sim_task = &sim_tasks[sim_tasks_count ++];
+    
+        sim_task->params = params;
+        sim_task->first_release = start;
+        sim_task->jobs = 0;
+        sim_task->misses = 0;
+        sim_task->tid = scheduler_instance_add_edf_task(&scheduler, edf_sim_task_proc, sim_task,
+                                params->period, params->deadline, NULL);
+    
+        if(sim_task->tid == INVALID_TASK_ID){
+            printf("FAIL: %s: add task %c failed\n", c->name, params->name);
+            return 1;
+        }
+    }
+    
+    while(edf_sim_get_time() - start < c->duration){
+        if(!scheduler_instance_process(&scheduler)){
+            timers_instance_sim_advance(&timers, 1);
+        }
+    }
+    
+    order_log[order_log_size] = '\0';
+    
+    for(i = 0; i < sim_tasks_count; i ++){
+        model_misses += sim_tasks[i].misses;
+        // Дескриптор выполненной однократной задачи освобождён.
+        if(sim_tasks[i].params->period == 0) continue;
+        
+        uint32_t task_misses = scheduler_instance_edf_task_misses(&scheduler, sim_tasks[i].tid);
+        
+        if(task_misses != sim_tasks[i].misses){
+            printf("FAIL: %s: task %c: %u misses, expected %u\n", c->name, sim_tasks[i].params->name,
+                   (unsigned)task_misses, (unsigned)sim_tasks[i].misses);
+            errors ++;
+        }
+        // Без нарушений сроков выполнены все задания,
+        // готовые раньше окончания моделирования.
+        if(c->misses == 0 && sim_tasks[i].jobs != c->duration / sim_tasks[i].params->period){
+            printf("FAIL: %s: task %c: %u jobs\n", c->name, sim_tasks[i].params->name,
+                   (unsigned)sim_tasks[i].jobs);
+            errors ++;
+        }
+    }
+    
+    uint32_t misses = scheduler_instance_edf_misses(&scheduler);
+    
+    printf("%-18s  %-8s  %6u  %12u\n", c->name, c->order ? order_log : "-",
+           (unsigned)misses, (unsigned)order_errors);
+    
+    if(c->order && strcmp(order_log, c->order) != 0){
+        printf("FAIL: %s: order %s, expected %s\n", c->name, order_log, c->order);
+        errors ++;
+    }
+    if(order_errors != 0){
+        printf("FAIL: %s: %u jobs dispatched out of deadline order\n", c->name, (unsigned)order_errors);
+        errors ++;
+    }
+    if(misses != model_misses){
+        printf("FAIL: %s: %u misses, expected %u\n", c->name,
+               (unsigned)misses, (unsigned)model_misses);
+        errors ++;
+    }
+    if(c->misses == EDF_SIM_MISSES_ANY ? misses == 0 : misses != (uint32_t)c->misses){
+        printf("FAIL: %s: unexpected misses count %u\n", c->name, (unsigned)misses);
+        errors ++;
+    }
+    
+    return errors;
+}
+
+int main(void)
+{
+    int errors = 0;
+    size_t i;
+    
+    edf_sim_init();
+    
+    printf("EDF scheduler on simulated clock\n");
+    printf("case                order     misses  order errors\n");
+    
+    for(i = 0; i < CASES_COUNT; i ++){
+        errors += edf_sim_run_case(&cases[i]);
+    }
+    
+    printf(errors ? "FAILED\n" : "OK\n");
+    
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file fuzz.c Фаззер приёма и обработки кадров Modbus RTU.
+ * Случайные кадры передаются ведомому стенда побайтно
+ * через модель линии, с моделируемым временем,
+ * вычислением CRC по мере приёма и целиком при IDLE,
+ * обработкой главного цикла посреди кадра и искажениями:
+ * неверной CRC, разрывом кадра паузой, посторонним адресом.
+ * Проверяется, что целый кадр с верной CRC принимается
+ * и на адресованный ведомому запрос передаётся ответ,
+ * принимаемый ведущим, а искажённый кадр ответа не вызывает.
+ * При сборке с AddressSanitizer данные сообщения
+ * за пределами принятого кадра недоступны обработчикам.
+ * Использование: fuzz [число итераций] [начальное значение ГПСЧ].
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "modbus_host.h"
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#define FUZZ_POISON(addr, size) ASAN_POISON_MEMORY_REGION(addr, size)
+#define FUZZ_UNPOISON(addr, size) ASAN_UNPOISON_MEMORY_REGION(addr, size)
+#else
+#define FUZZ_POISON(addr, size) do{ (void)(addr); (void)(size); }while(0)
+#define FUZZ_UNPOISON(addr, size) do{ (void)(addr); (void)(size); }while(0)
+#endif
+
+
+//! Число итераций по-умолчанию.
+#define FUZZ_ITERATIONS_DEFAULT 200000
+
+//! Скорость модели линии.
+#define FUZZ_BAUD 115200
+
+//! Функции, выбираемые преимущественно.
+static const uint8_t funcs[] = {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x0b, 0x0c, 0x0f, 0x10,
+    0x11, 0x14, 0x15, 0x16, 0x17, 0x18, 0x2b, 0x41, 0x80, 0xff
+};
+
+//! Число ответов, принятых ведущим.
+static uint32_t master_received = 0;
+
+//! Статистика ответов по функциям.
+static uint32_t func_ok[256];
+static uint32_t func_exc[256];
+
+//! Время модели.
+static uint64_t now_ns = 1;
+
+static void on_master_msg_recv(void)
+{
+    master_received ++;
+}
+
+static void fail(const char* what, unsigned seed, long iteration, const uint8_t* frame, size_t size)
+{
+    size_t i;
+    
+    printf("FAIL: %s (seed %u, iteration %ld)\nframe:", what, seed, iteration);
+    for(i = 0; i < size; i ++) printf(" %02x", frame[i]);
+    printf("\n");
+    
+    exit(1);
+}
+
+/**
+ * Заполняет данные кадра.
+ * @return Размер данных.
+ */
+static size_t fuzz_gen_data(uint8_t func, uint8_t* data)
+{
+    size_t n = rand() % (MODBUS_RTU_DATA_SIZE_MAX + 1);
+    size_t i;
+    
+    if(rand() & 1) n = rand() % 16;
+    
+    for(i = 0; i < n; i ++) data[i] = (rand() % 3) ? rand() : (rand() % 3);
+    
+    // Структурированные подзапросы файловых записей.
+    if((func == MODBUS_RTU_FUNC_READ_FILE || func == MODBUS_RTU_FUNC_WRITE_FILE) && (rand() & 1)){
+        size_t p = 1;
+        uint8_t* r;
+        uint16_t len;
+        size_t d;
+    
+        while(p + 7 <= MODBUS_RTU_DATA_SIZE_MAX && (rand() % 5)){
+            r = &data[p];
+            len = (rand() & 1) ? rand() % 8 : rand() % 130;
+            r[0] = (rand() % 8) ? 6 : rand();
+            r[1] = 0; r[2] = rand();
+            r[3] = 0; r[4] = rand() % 50;
+            r[5] = len >> 8; r[6] = len;
+            p += 7;
+            if(func == MODBUS_RTU_FUNC_WRITE_FILE){
+                d = (rand() % 4) ? len * 2 : rand() % 64;
+                if(p + d > MODBUS_RTU_DATA_SIZE_MAX) d = MODBUS_RTU_DATA_SIZE_MAX - p;
+                memset(&data[p], 0x33, d);
+                p += d;
+            }
+        }
+        n = p;
+        data[0] = (rand() % 8) ? n - 1 : rand();
+    }
+    
+    // Адреса и число в пределах карты регистров.
+    if(n >= 4 && (rand() & 1)){
+        data[0] = 0;
+        data[1] = rand() % MODBUS_HOST_REGS_COUNT;
+        data[2] = 0;
+        data[3] = rand() % 16;
+    }
+    
+    return n;
+}
+
+static void fuzz_poison_rx_messages(modbus_rtu_t* modbus, size_t size)
+{
+    size_t i;
+    
+    for(i = 0; i < modbus->rx_messages_count; i ++){
+        uint8_t* adu = (uint8_t*)&modbus->rx_messages[i].adu;
+        FUZZ_POISON(adu + size, sizeof(modbus_rtu_adu_t) - size);
+    }
+}
+
+static void fuzz_unpoison_rx_messages(modbus_rtu_t* modbus)
+{
+    size_t i;
+    
+    for(i = 0; i < modbus->rx_messages_count; i ++){
+        FUZZ_UNPOISON(&modbus->rx_messages[i].adu, sizeof(modbus_rtu_adu_t));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : FUZZ_ITERATIONS_DEFAULT;
+    unsigned seed = argc > 2 ? (unsigned)atol(argv[2]) : (unsigned)time(NULL);
+    
+    srand(seed);
+    printf("seed %u\n", seed);
+    
+    if(modbus_host_init(FUZZ_BAUD, true) != E_NO_ERROR){
+        printf("modbus_host_init failed\n");
+        return 2;
+    }
+    
+    modbus_host_set_master_callbacks(on_master_msg_recv, NULL);
+    
+    modbus_rtu_t* slave = modbus_host_slave();
+    modbus_rtu_t* master = modbus_host_master();
+    usart_sim_port_t* port = modbus_host_slave_port();
+    usart_bus_t* usart = modbus_host_slave_usart();
+    uint64_t byte_ns = port->byte_time_ns;
+    
+    modbus_rtu_message_t msg;
+    uint8_t* frame = (uint8_t*)&msg.adu;
+    long it;
+    
+    for(it = 0; it < iterations; it ++){
+        // Способ вычисления CRC меняется между кадрами.
+        if((it & 0xff) == 0){
+            modbus_host_set_rx_progress(rand() & 1);
+        }
+    
+        int addr_kind = rand() % 8;
+        modbus_rtu_address_t address = (addr_kind == 0) ? MODBUS_RTU_ADDRESS_BROADCAST :
+                                       (addr_kind == 1) ? (2 + rand() % 200) : MODBUS_HOST_SLAVE_ADDRESS;
+        modbus_rtu_func_t func = (rand() % 8) ? funcs[rand() % sizeof(funcs)] : (modbus_rtu_func_t)rand();
+    
+        msg.adu.address = address;
+        msg.adu.func = func;
+        msg.data_size = fuzz_gen_data(func, msg.adu.data_and_crc);
+        modbus_rtu_message_calc_crc(&msg);
+    
+        size_t size = msg.data_size + MODBUS_RTU_FIELDS_CRC_SIZE;
+        bool corrupt = (rand() % 8) == 0;
+        bool split = (rand() % 32) == 0;
+        size_t split_pos = 1 + rand() % (size - 1);
+    
+        if(corrupt) frame[rand() % size] ^= 1 << (rand() % 8);
+    
+        uint32_t slave_tx_bytes = port->tx_bytes;
+        uint32_t received = master_received;
+    
+        fuzz_unpoison_rx_messages(slave);
+    
+        size_t i;
+        for(i = 0; i < size; i ++){
+            now_ns += byte_ns;
+            // Разрыв кадра паузой, либо задержка менее байта.
+            if(split && i == split_pos){
+                now_ns += byte_ns * 3;
+            }else if((rand() % 16) == 0){
+                now_ns += rand() % byte_ns;
+            }
+            usart_sim_rx_byte(port, frame[i], now_ns);
+            // Главный цикл посреди кадра.
+            if((rand() % 8) == 0){
+                modbus_host_process(now_ns);
+            }
+        }
+    
+        fuzz_poison_rx_messages(slave, size);
+    
+        // Пауза, обработка, передача и приём ответа.
+        now_ns += byte_ns * 2;
+        modbus_host_process(now_ns);
+        now_ns += byte_ns * (MODBUS_RTU_PACKET_SIZE_MAX + 2);
+        modbus_host_process(now_ns);
+        now_ns += byte_ns * 2;
+        modbus_host_process(now_ns);
+    
+        fuzz_unpoison_rx_messages(slave);
+    
+        uint32_t reply_size = port->tx_bytes - slave_tx_bytes;
+        bool replied = reply_size != 0;
+    
+        if(reply_size > MODBUS_RTU_PACKET_SIZE_MAX) fail("reply too long", seed, it, frame, size);
+        if(usart_bus_tx_busy(usart)) fail("reply not finished", seed, it, frame, size);
+    
+        bool expect_reply = !corrupt && !split && address == MODBUS_HOST_SLAVE_ADDRESS;
+    
+        if(expect_reply && !replied) fail("no reply", seed, it, frame, size);
+        if(!corrupt && !split && address != MODBUS_HOST_SLAVE_ADDRESS && replied) fail("reply to foreign frame", seed, it, frame, size);
+    
+        if(replied && !split){
+            if(master_received != received + 1) fail("reply not received by master", seed, it, frame, size);
+    
+            modbus_rtu_message_t* reply = modbus_rtu_rx_message(master);
+            modbus_rtu_func_t reply_func = modbus_rtu_message_func(reply);
+    
+            if(modbus_rtu_message_address(reply) != MODBUS_HOST_SLAVE_ADDRESS ||
+               (reply_func & 0x7f) != (func & 0x7f)){
+                fail("reply does not match request", seed, it, frame, size);
+            }
+    
+            if(reply_func & 0x80){
+                func_exc[func] ++;
+            }else{
+                func_ok[func] ++;
+            }
+        }
+    }
+    
+    uint32_t other_exc = 0;
+    int f;
+    for(f = 0; f < 256; f ++){
+        if(func_ok[f]){
+            printf("func %02x ok %u exception %u\n", f, func_ok[f], func_exc[f]);
+        }else{
+            other_exc += func_exc[f];
+        }
+    }
+    printf("other funcs exception %u\n", other_exc);
+    
+    printf("slave rx overruns %u, master replies %u\n", modbus_rtu_rx_overruns(slave), master_received);
+    printf("OK\n");
+    
+    return 0;
+}
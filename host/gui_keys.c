@@ -0,0 +1,253 @@
+/**
+ * @file gui_keys.c Профилирование отрисовки GUI на хосте.
+ * Экран из нескольких виджетов рисуется в буфер в памяти,
+ * нажатия клавиш сценария помещаются в очередь
+ * через gui_post_key_pressed/gui_post_key_released,
+ * каждый вызов gui_process_events - отдельный кадр профилировщика.
+ * Выводятся время и статистика каждого кадра,
+ * сводка по кадрам и таблицы gui_profiler_dump
+ * кадра полной перерисовки и последнего кадра сценария.
+ * Использование: gui_keys [число повторов сценария].
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gui/gui.h"
+#include "gui/gui_widget.h"
+#include "gui/gui_label.h"
+#include "gui/gui_button.h"
+#include "gui/gui_checkbox.h"
+#include "gui/gui_spinbox.h"
+#include "graphics/graphics.h"
+#include "graphics/font.h"
+#include "graphics/font_5x8_utf8.h"
+#include "input/keys.h"
+
+#ifndef USE_GUI_PROFILER
+#error gui_keys requires USE_GUI_PROFILER
+#endif
+
+
+//! Число повторов сценария по-умолчанию.
+#define GUI_KEYS_REPEATS_DEFAULT 10
+
+//! Размер экрана.
+#define GUI_KEYS_WIDTH 320
+#define GUI_KEYS_HEIGHT 240
+
+//! Интервал между кадрами в единицах времени GUI.
+#define GUI_KEYS_FRAME_TIME 20
+
+
+//! Действие сценария.
+typedef enum _Gui_Keys_Action {
+    GUI_KEYS_PRESS = 0, //!< Нажатие клавиши.
+    GUI_KEYS_RELEASE, //!< Отпускание клавиши.
+    GUI_KEYS_CLICK, //!< Нажатие и отпускание в одном кадре.
+    GUI_KEYS_FOCUS_NEXT //!< Перемещение фокуса.
+} gui_keys_action_t;
+
+//! Шаг сценария - один кадр.
+typedef struct _Gui_Keys_Step {
+    gui_keys_action_t action; //!< Действие.
+    keycode_t key; //!< Клавиша.
+    const char* name; //!< Описание шага.
+} gui_keys_step_t;
+
+/**
+ * Сценарий: обход виджетов и изменение их значений.
+ * Фокус первого шага повтора переходит со спинбокса на кнопку.
+ */
+static const gui_keys_step_t script[] = {
+    {GUI_KEYS_FOCUS_NEXT, 0, "focus button"},
+    {GUI_KEYS_PRESS, KEY_ENTER, "button press"},
+    {GUI_KEYS_RELEASE, KEY_ENTER, "button release"},
+    {GUI_KEYS_FOCUS_NEXT, 0, "focus checkbox"},
+    {GUI_KEYS_CLICK, KEY_SPACE, "checkbox toggle"},
+    {GUI_KEYS_FOCUS_NEXT, 0, "focus spinbox"},
+    {GUI_KEYS_CLICK, KEY_UP, "spinbox up"},
+    {GUI_KEYS_CLICK, KEY_UP, "spinbox up"},
+    {GUI_KEYS_CLICK, KEY_DOWN, "spinbox down"},
+};
+
+#define SCRIPT_STEPS_COUNT (sizeof(script) / sizeof(script[0]))
+
+
+//! Буфер изображения.
+static uint8_t framebuffer[GUI_KEYS_WIDTH * GUI_KEYS_HEIGHT * 2];
+static graphics_t graphics;
+
+//! Шрифт - символы ASCII.
+static const font_bitmap_t font_bitmaps[] = {
+    make_font_bitmap(0x20, 0x7f, (const uint8_t*)font_5x8_utf8_part0_data,
+                     FONT_5X8_UTF8_PART0_WIDTH, FONT_5X8_UTF8_PART0_HEIGHT, GRAPHICS_FORMAT_BW_1_V),
+};
+static const font_t font = make_font(font_bitmaps, 1, 5, 8, 1, 1);
+
+static gui_theme_t theme = MAKE_GUI_THEME(
+        GRAPHICS_COLOR_RGB_565(0, 0, 0), GRAPHICS_COLOR_RGB_565(31, 63, 31),
+        GRAPHICS_COLOR_RGB_565(4, 8, 4), GRAPHICS_COLOR_RGB_565(8, 16, 8),
+        GRAPHICS_COLOR_RGB_565(16, 32, 16), GRAPHICS_COLOR_RGB_565(31, 63, 31),
+        GRAPHICS_COLOR_RGB_565(31, 48, 0), GRAPHICS_COLOR_RGB_565(0, 32, 31),
+        &font, &font);
+
+static gui_t gui;
+static gui_widget_t root;
+static gui_label_t label;
+static gui_button_t button;
+static gui_checkbox_t checkbox;
+static gui_spinbox_t spinbox;
+
+//! Число нажатий кнопки.
+static int clicks = 0;
+
+static void on_button_clicked(gui_button_t* btn)
+{
+    (void)btn;
+    
+    clicks ++;
+}
+
+static void gui_keys_init_screen(void)
+{
+    graphics_init(&graphics, framebuffer, GUI_KEYS_WIDTH, GUI_KEYS_HEIGHT, GRAPHICS_FORMAT_RGB_565);
+    gui_init(&gui, &graphics, &theme);
+    
+    gui_widget_init(&root, &gui);
+    gui_widget_resize(&root, GUI_KEYS_WIDTH, GUI_KEYS_HEIGHT);
+    gui_set_root_widget(&gui, &root);
+    
+    gui_label_init_parent(&label, &gui, &root);
+    gui_label_set_text(&label, "Settings");
+    gui_widget_move(GUI_WIDGET(&label), 10, 10);
+    gui_widget_resize(GUI_WIDGET(&label), 300, 20);
+    gui_widget_set_visible(GUI_WIDGET(&label), true);
+    
+    gui_button_init_parent(&button, &gui, &root);
+    gui_button_set_text(&button, "Apply");
+    gui_button_set_on_clicked(&button, on_button_clicked);
+    gui_widget_move(GUI_WIDGET(&button), 10, 40);
+    gui_widget_resize(GUI_WIDGET(&button), 100, 30);
+    gui_widget_set_visible(GUI_WIDGET(&button), true);
+    
+    gui_checkbox_init_parent(&checkbox, &gui, &root);
+    gui_checkbox_set_text(&checkbox, "Enable");
+    gui_widget_move(GUI_WIDGET(&checkbox), 10, 80);
+    gui_widget_resize(GUI_WIDGET(&checkbox), 150, 20);
+    gui_widget_set_visible(GUI_WIDGET(&checkbox), true);
+    
+    gui_spinbox_init_parent(&spinbox, &gui, &root);
+    gui_spinbox_set_range(&spinbox, 0, 100);
+    gui_widget_move(GUI_WIDGET(&spinbox), 10, 110);
+    gui_widget_resize(GUI_WIDGET(&spinbox), 100, 30);
+    gui_widget_set_visible(GUI_WIDGET(&spinbox), true);
+    
+    gui_widget_set_visible(&root, true);
+}
+
+static void gui_keys_post(const gui_keys_step_t* step)
+{
+    switch(step->action){
+        case GUI_KEYS_PRESS:
+            gui_post_key_pressed(&gui, step->key);
+            break;
+        case GUI_KEYS_RELEASE:
+            gui_post_key_released(&gui, step->key);
+            break;
+        case GUI_KEYS_CLICK:
+            gui_post_key_pressed(&gui, step->key);
+            gui_post_key_released(&gui, step->key);
+            break;
+        case GUI_KEYS_FOCUS_NEXT:
+            gui_post_focus_next(&gui);
+            break;
+    }
+}
+
+static void gui_keys_print_frame(uint32_t frame, const char* name)
+{
+    const gui_paint_stats_t* stats = gui_profiler_frame_stats(&gui);
+    
+    printf("%5u  %-16s %10lu %8lu %8lu\n", (unsigned)frame, name,
+           (unsigned long)gui_profiler_frame_cycles(&gui),
+           (unsigned long)stats->repaints, (unsigned long)stats->pixels);
+}
+
+int main(int argc, char** argv)
+{
+    int repeats = argc > 1 ? atoi(argv[1]) : GUI_KEYS_REPEATS_DEFAULT;
+    uint32_t time = 0;
+    uint32_t frame = 0;
+    uint32_t frame_ns;
+    uint32_t max_ns = 0;
+    uint32_t max_frame = 0;
+    size_t max_step = 0;
+    uint64_t sum_ns = 0;
+    size_t i;
+    int r;
+    
+    if(repeats <= 0){
+        printf("invalid arguments\n");
+        return 2;
+    }
+    
+    gui_keys_init_screen();
+    
+    printf("gui %ux%u, %u steps x %d repeats, time in ns\n", GUI_KEYS_WIDTH, GUI_KEYS_HEIGHT,
+           (unsigned)SCRIPT_STEPS_COUNT, repeats);
+    
+    // Кадр полной перерисовки экрана.
+    gui_profiler_begin_frame(&gui);
+    gui_repaint(&gui, NULL);
+    gui_profiler_end_frame(&gui);
+    frame ++;
+    
+    printf("\nfull repaint:\n");
+    gui_profiler_dump(&gui);
+    
+    printf("\nframe  step                    ns repaints   pixels\n");
+    
+    for(r = 0; r < repeats; r ++){
+        for(i = 0; i < SCRIPT_STEPS_COUNT; i ++){
+            gui_keys_post(&script[i]);
+    
+            gui_profiler_begin_frame(&gui);
+            gui_process_events(&gui, time);
+            gui_profiler_end_frame(&gui);
+    
+            time += GUI_KEYS_FRAME_TIME;
+    
+            frame_ns = gui_profiler_frame_cycles(&gui);
+            sum_ns += frame_ns;
+            if(frame_ns > max_ns){
+                max_ns = frame_ns;
+                max_frame = frame;
+                max_step = i;
+            }
+            // Кадры первого прохода сценария выводятся полностью.
+            if(r == 0) gui_keys_print_frame(frame, script[i].name);
+    
+            frame ++;
+        }
+    }
+    
+    printf("\nframes %u, avg %lu ns, max %lu ns (frame %u, %s)\n",
+           (unsigned)(frame - 1), (unsigned long)(sum_ns / (frame - 1)),
+           (unsigned long)max_ns, (unsigned)max_frame, script[max_step].name);
+    printf("button clicks %d, checkbox %s, spinbox %d\n", clicks,
+           gui_checkbox_checked(&checkbox) ? "on" : "off", gui_spinbox_value(&spinbox));
+    printf("\nlast frame:\n");
+    gui_profiler_dump(&gui);
+    
+    if(gui_input_overruns(&gui) != 0){
+        printf("FAIL: %lu input events lost\n", (unsigned long)gui_input_overruns(&gui));
+        return 1;
+    }
+    if(clicks != repeats){
+        printf("FAIL: %d button clicks\n", clicks);
+        return 1;
+    }
+    
+    return 0;
+}
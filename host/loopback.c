@@ -0,0 +1,234 @@
+/**
+ * @file loopback.c Ведущий и ведомый Modbus RTU на модели линии.
+ * Ведущий периодически опрашивает ведомого всеми
+ * поддерживаемыми функциями и отсутствующего ведомого,
+ * после чего проверяются данные ведомого и статистика.
+ * Отдельно проверяется запись в карту регистров
+ * нескольких диапазонов с масштабированием.
+ * Использование: loopback [скорость, бод] [длительность, мс].
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "modbus_host.h"
+#include "modbus/modbus_rtu_master.h"
+#include "modbus/modbus_reg_map.h"
+
+
+//! Скорость по-умолчанию.
+#define LOOPBACK_BAUD_DEFAULT 115200
+//! Длительность по-умолчанию, мс.
+#define LOOPBACK_DURATION_MS_DEFAULT 1000
+
+//! Адрес отсутствующего ведомого.
+#define LOOPBACK_ABSENT_ADDRESS 2
+
+static modbus_rtu_master_t master;
+
+static uint16_t read_regs[4];
+static uint16_t write_regs[2] = {0x1111, 0x2222};
+static uint16_t single_reg[1] = {0x5a5a};
+static uint16_t mask_reg[2] = {0x00ff, 0x5500};
+static uint16_t rw_read_regs[3];
+static const uint16_t rw_write_regs[2] = {0xabcd, 0x1234};
+static uint8_t read_coils[2];
+static uint8_t write_coils[2] = {0xa5, 0x01};
+static uint8_t read_dins[1];
+static uint16_t read_input_regs[2];
+static uint16_t absent_regs[1];
+
+//! Число выполнений запросов по результатам.
+static uint32_t results[MODBUS_RTU_MASTER_STATUS_SEND_ERROR + 1];
+
+static void on_request_done(modbus_rtu_master_request_t* request)
+{
+    results[request->status] ++;
+}
+
+static modbus_rtu_master_request_t requests[] = {
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_HOLDING_REGS,
+     .reg_address = 0, .count = 4, .data = read_regs, .period = {0, 20000}, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_WRITE_MULTIPLE_REGS,
+     .reg_address = 10, .count = 2, .data = write_regs, .period = {0, 50000}, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_WRITE_SINGLE_REG,
+     .reg_address = 12, .count = 1, .data = single_reg, .period = {0, 50000}, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_CHANGE_REG,
+     .reg_address = 15, .count = 1, .data = mask_reg, .period = {0, 100000}, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS,
+     .reg_address = 4, .count = 3, .data = rw_read_regs, .write_address = 5, .write_count = 2,
+     .write_data = rw_write_regs, .period = {0, 100000}, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_WRITE_MULTIPLE_COILS,
+     .reg_address = 100, .count = 9, .data = write_coils, .period = {0, 50000}, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_COILS_STATUS,
+     .reg_address = 100, .count = 9, .data = read_coils, .period = {0, 20000}, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_DISCR_INPUTS,
+     .reg_address = 0, .count = 8, .data = read_dins, .period = {0, 50000}, .callback = on_request_done},
+    {.address = MODBUS_HOST_SLAVE_ADDRESS, .func = MODBUS_RTU_FUNC_READ_INPUT_REGS,
+     .reg_address = 1, .count = 2, .data = read_input_regs, .period = {0, 50000}, .callback = on_request_done},
+    {.address = LOOPBACK_ABSENT_ADDRESS, .func = MODBUS_RTU_FUNC_READ_HOLDING_REGS,
+     .reg_address = 0, .count = 1, .data = absent_regs, .period = {0, 200000}, .callback = on_request_done},
+};
+
+#define REQUESTS_COUNT (sizeof(requests) / sizeof(requests[0]))
+
+static modbus_rtu_master_slave_stats_t stats[2];
+
+static void on_master_msg_recv(void)
+{
+    modbus_rtu_master_msg_recv(&master);
+}
+
+static void on_master_msg_sent(void)
+{
+    modbus_rtu_master_msg_sent(&master);
+}
+
+//! Число ошибок проверки.
+static int errors = 0;
+
+static void check(bool cond, const char* what)
+{
+    if(!cond){
+        printf("FAIL: %s\n", what);
+        errors ++;
+    }
+}
+
+/**
+ * Проверяет запись блока, охватывающего несколько диапазонов
+ * карты регистров, и изменение регистра по маскам.
+ */
+static void check_reg_map(void)
+{
+    static uint16_t plain[2];
+    static int16_t scaled10[2];
+    static int16_t scaled100[2];
+    static uint16_t read_only[1];
+    static const modbus_reg_map_entry_t entries[] = {
+        {MODBUS_RTU_HOLDING_REG, 0, 2, MODBUS_REG_MAP_ACCESS_RW, plain, NULL, NULL, 0, 0},
+        {MODBUS_RTU_HOLDING_REG, 2, 2, MODBUS_REG_MAP_ACCESS_RW, scaled10, NULL, NULL, 1, 10},
+        {MODBUS_RTU_HOLDING_REG, 4, 2, MODBUS_REG_MAP_ACCESS_RW, scaled100, NULL, NULL, 1, 100},
+        {MODBUS_RTU_HOLDING_REG, 6, 1, MODBUS_REG_MAP_ACCESS_READ, read_only, NULL, NULL, 0, 0},
+    };
+    static MODBUS_REG_MAP_INDEX_BUFFER(index, 4);
+    
+    modbus_reg_map_t map;
+    
+    static const uint16_t invalid_values[6] = {1, 2, 3, 4, 5, 400};
+    static const uint16_t valid_values[6] = {1, 2, 3, 4, 5, 6};
+    
+    check(modbus_reg_map_init(&map, entries, 4, index) == E_NO_ERROR, "reg map init");
+    
+    // 400 * 100 не умещается в int16_t - не записывается весь блок.
+    check(modbus_reg_map_write_regs(&map, MODBUS_RTU_HOLDING_REG, 0, 6, invalid_values) == MODBUS_RTU_ERROR_INVALID_DATA,
+          "reg map invalid scaled write error");
+    check(plain[0] == 0 && plain[1] == 0 && scaled10[0] == 0 && scaled10[1] == 0 &&
+          scaled100[0] == 0 && scaled100[1] == 0, "reg map invalid scaled write is all-or-nothing");
+    
+    check(modbus_reg_map_write_regs(&map, MODBUS_RTU_HOLDING_REG, 0, 6, valid_values) == MODBUS_RTU_ERROR_NONE,
+          "reg map scaled write");
+    check(plain[0] == 1 && plain[1] == 2 && scaled10[0] == 30 && scaled10[1] == 40 &&
+          scaled100[0] == 500 && scaled100[1] == 600, "reg map scaled write values");
+    
+    check(modbus_reg_map_change_reg(&map, 0, 0x0000, 0x1234) == MODBUS_RTU_ERROR_NONE && plain[0] == 0x1234,
+          "reg map change reg");
+    check(modbus_reg_map_change_reg(&map, 2, 0xfff0, 0x0005) == MODBUS_RTU_ERROR_NONE && scaled10[0] == 50,
+          "reg map change scaled reg");
+    check(modbus_reg_map_change_reg(&map, 6, 0x0000, 0x0001) == MODBUS_RTU_ERROR_INVALID_ADDRESS && read_only[0] == 0,
+          "reg map change read-only reg");
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = argc > 1 ? (uint32_t)atol(argv[1]) : LOOPBACK_BAUD_DEFAULT;
+    uint32_t duration_ms = argc > 2 ? (uint32_t)atol(argv[2]) : LOOPBACK_DURATION_MS_DEFAULT;
+    
+    if(baud == 0){
+        printf("invalid baud\n");
+        return 2;
+    }
+    
+    if(modbus_host_init(baud, true) != E_NO_ERROR){
+        printf("modbus_host_init failed\n");
+        return 2;
+    }
+    
+    modbus_host_set_master_callbacks(on_master_msg_recv, on_master_msg_sent);
+    
+    modbus_rtu_master_init_t master_is;
+    
+    master_is.modbus = modbus_host_master();
+    master_is.timers = NULL;
+    master_is.requests = requests;
+    master_is.requests_count = REQUESTS_COUNT;
+    master_is.stats = stats;
+    master_is.stats_count = 2;
+    master_is.baud = baud;
+    master_is.timeout_us = 0;
+    master_is.turnaround_us = 0;
+    master_is.retries = 1;
+    
+    if(modbus_rtu_master_init(&master, &master_is) != E_NO_ERROR ||
+       modbus_rtu_master_start(&master) != E_NO_ERROR){
+        printf("master start failed\n");
+        return 2;
+    }
+    
+    uint64_t start_ns = usart_sim_time_ns();
+    uint64_t end_ns = start_ns + (uint64_t)duration_ms * 1000000;
+    uint64_t now_ns;
+    
+    do{
+        now_ns = usart_sim_time_ns();
+        modbus_host_process(now_ns);
+    }while(now_ns < end_ns);
+    
+    modbus_rtu_master_stop(&master);
+    
+    const modbus_rtu_master_slave_stats_t* s;
+    modbus_rtu_address_t address;
+    
+    for(address = MODBUS_HOST_SLAVE_ADDRESS; address <= LOOPBACK_ABSENT_ADDRESS; address ++){
+        s = modbus_rtu_master_slave_stats(&master, address);
+        printf("slave %u: requests %u responses %u exceptions %u timeouts %u invalid %u retries %u failures %u"
+               " latency min %u avg %u max %u us\n",
+               address, s->requests, s->responses, s->exceptions, s->timeouts, s->invalid_responses,
+               s->retries, s->failures, s->responses ? s->latency_min_us : 0,
+               modbus_rtu_master_slave_stats_latency_avg(s), s->latency_max_us);
+    }
+    
+    printf("results: ok %u exception %u timeout %u invalid %u send error %u\n",
+           results[MODBUS_RTU_MASTER_STATUS_OK], results[MODBUS_RTU_MASTER_STATUS_EXCEPTION],
+           results[MODBUS_RTU_MASTER_STATUS_TIMEOUT], results[MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE],
+           results[MODBUS_RTU_MASTER_STATUS_SEND_ERROR]);
+    printf("slave rx overruns %u, line bytes %u\n",
+           modbus_rtu_rx_overruns(modbus_host_slave()), modbus_host_slave_port()->rx_bytes);
+    
+    uint16_t* holding_regs = modbus_host_holding_regs();
+    uint8_t* coils = modbus_host_coils();
+    
+    s = modbus_rtu_master_slave_stats(&master, MODBUS_HOST_SLAVE_ADDRESS);
+    check(s->responses > 0, "slave responses");
+    check(s->exceptions == 0 && s->timeouts == 0 && s->invalid_responses == 0 && s->failures == 0, "slave errors");
+    
+    s = modbus_rtu_master_slave_stats(&master, LOOPBACK_ABSENT_ADDRESS);
+    check(s->responses == 0 && s->failures > 0, "absent slave failures");
+    
+    check(read_regs[0] == 0 && read_regs[1] == 1 && read_regs[2] == 2 && read_regs[3] == 3, "read holding regs");
+    check(holding_regs[10] == 0x1111 && holding_regs[11] == 0x2222, "write multiple regs");
+    check(holding_regs[12] == 0x5a5a, "write single reg");
+    check(holding_regs[15] == ((15 & 0x00ff) | (0x5500 & ~0x00ff)), "mask write reg");
+    check(holding_regs[5] == 0xabcd && holding_regs[6] == 0x1234, "read/write regs write");
+    check(rw_read_regs[0] == 4 && rw_read_regs[1] == 0xabcd && rw_read_regs[2] == 0x1234, "read/write regs read");
+    check(coils[100] == 1 && coils[101] == 0 && coils[107] == 1 && coils[108] == 1, "write coils");
+    check(read_coils[0] == 0xa5 && read_coils[1] == 0x01, "read coils");
+    check(read_dins[0] == 0xaa, "read discrete inputs");
+    check(read_input_regs[0] == 0x8001 && read_input_regs[1] == 0x8002, "read input regs");
+    
+    check_reg_map();
+    
+    printf(errors ? "FAILED\n" : "OK\n");
+    
+    return errors ? 1 : 0;
+}
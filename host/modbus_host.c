@@ -0,0 +1,368 @@
+#include "modbus_host.h"
+#include "modbus/modbus_reg_map.h"
+#include "timers/timers.h"
+#include <string.h>
+
+
+//! Число таймеров стенда.
+#define MODBUS_HOST_TIMERS_COUNT 8
+
+
+//! Тип узла стенда.
+typedef struct _Modbus_Host_Node {
+    usart_sim_port_t port; //!< Порт модели.
+    usart_bus_t usart; //!< Шина USART.
+    modbus_rtu_t modbus; //!< Протокол Modbus RTU.
+    modbus_rtu_message_t rx_messages[MODBUS_HOST_RX_MESSAGES_COUNT]; //!< Сообщения для приёма.
+    modbus_rtu_message_t tx_message; //!< Сообщение для передачи.
+} modbus_host_node_t;
+
+//! Ведущий.
+static modbus_host_node_t master;
+//! Ведомый.
+static modbus_host_node_t slave;
+
+//! Флаг приёма сообщения ведомым.
+static volatile bool slave_msg = false;
+//! Флаг вычисления CRC по мере приёма ведомым.
+static bool slave_rx_progress = false;
+
+//! Таймеры стенда.
+static TIMERS_BUFFER(timers_buffer, MODBUS_HOST_TIMERS_COUNT);
+//! Время срабатывания аппаратного таймера, 0 - таймер не запущен.
+static uint64_t timer_deadline_ns = 0;
+
+//! Каллбэки ведущего.
+static modbus_rtu_msg_recv_callback_t master_recv_callback = NULL;
+static modbus_rtu_msg_sent_callback_t master_sent_callback = NULL;
+
+//! Время обработки прерываний ведомого.
+static uint64_t slave_idle_time_ns = 0;
+static uint64_t slave_progress_time_ns = 0;
+static uint32_t slave_idle_count = 0;
+//! Время обработки сообщений ведомым.
+static uint64_t slave_dispatch_time_ns = 0;
+static uint32_t slave_dispatch_count = 0;
+
+//! Данные ведомого.
+static uint16_t holding_regs[MODBUS_HOST_REGS_COUNT];
+static uint16_t input_regs[MODBUS_HOST_REGS_COUNT];
+static uint8_t coils[MODBUS_HOST_BITS_COUNT];
+static uint8_t dins[MODBUS_HOST_BITS_COUNT];
+
+//! Карта регистров ведомого.
+static const modbus_reg_map_entry_t slave_reg_map_entries[] = {
+    {MODBUS_RTU_COIL, 0, MODBUS_HOST_BITS_COUNT, MODBUS_REG_MAP_ACCESS_RW, coils, NULL, NULL, 0, 0},
+    {MODBUS_RTU_DISCR_INPUT, 0, MODBUS_HOST_BITS_COUNT, MODBUS_REG_MAP_ACCESS_READ, dins, NULL, NULL, 0, 0},
+    {MODBUS_RTU_HOLDING_REG, 0, MODBUS_HOST_REGS_COUNT, MODBUS_REG_MAP_ACCESS_RW, holding_regs, NULL, NULL, 0, 0},
+    {MODBUS_RTU_INPUT_REG, 0, MODBUS_HOST_REGS_COUNT, MODBUS_REG_MAP_ACCESS_READ, input_regs, NULL, NULL, 0, 0},
+};
+
+//! Число диапазонов карты регистров.
+#define SLAVE_REG_MAP_ENTRIES_COUNT (sizeof(slave_reg_map_entries) / sizeof(slave_reg_map_entries[0]))
+
+static MODBUS_REG_MAP_INDEX_BUFFER(slave_reg_map_index, SLAVE_REG_MAP_ENTRIES_COUNT);
+static modbus_reg_map_t slave_reg_map;
+
+//! Идентификатор ведомого.
+static const char slave_id_data[] = "modbus host";
+
+
+/*
+ * Каллбэки ведущего.
+ */
+
+static bool master_usart_rx_byte_callback(uint8_t byte)
+{
+    return modbus_rtu_usart_rx_byte_callback(&master.modbus, byte);
+}
+
+static bool master_usart_rx_callback(void)
+{
+    return modbus_rtu_usart_rx_callback(&master.modbus);
+}
+
+static bool master_usart_tx_callback(void)
+{
+    return modbus_rtu_usart_tx_callback(&master.modbus);
+}
+
+static void master_on_msg_recv(void)
+{
+    if(master_recv_callback) master_recv_callback();
+}
+
+static void master_on_msg_sent(void)
+{
+    if(master_sent_callback) master_sent_callback();
+}
+
+
+/*
+ * Каллбэки ведомого.
+ */
+
+static bool slave_usart_rx_byte_callback(uint8_t byte)
+{
+    return modbus_rtu_usart_rx_byte_callback(&slave.modbus, byte);
+}
+
+static bool slave_usart_rx_callback(void)
+{
+    uint64_t t = usart_sim_time_ns();
+    
+    bool res = modbus_rtu_usart_rx_callback(&slave.modbus);
+    
+    slave_idle_time_ns += usart_sim_time_ns() - t;
+    slave_idle_count ++;
+    
+    return res;
+}
+
+static void slave_rx_progress_timed(void)
+{
+    uint64_t t = usart_sim_time_ns();
+    
+    modbus_rtu_usart_rx_progress(&slave.modbus);
+    
+    slave_progress_time_ns += usart_sim_time_ns() - t;
+}
+
+static bool slave_usart_rx_progress_callback(void)
+{
+    slave_rx_progress_timed();
+    
+    return true;
+}
+
+static bool slave_usart_tx_callback(void)
+{
+    return modbus_rtu_usart_tx_callback(&slave.modbus);
+}
+
+static void slave_on_msg_recv(void)
+{
+    slave_msg = true;
+}
+
+static modbus_rtu_error_t slave_report_slave_id(modbus_rtu_slave_id_t* slave_id)
+{
+    slave_id->id = MODBUS_HOST_SLAVE_ADDRESS;
+    slave_id->status = MODBUS_RTU_RUN_STATUS_ON;
+    slave_id->data = slave_id_data;
+    slave_id->data_size = sizeof(slave_id_data);
+    
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+
+/*
+ * Таймер.
+ */
+
+static void setup_timer(const struct timeval* tv_time)
+{
+    timer_deadline_ns = usart_sim_time_ns() + (uint64_t)tv_time->tv_sec * 1000000000 + (uint64_t)tv_time->tv_usec * 1000;
+}
+
+
+/*
+ * Инициализация.
+ */
+
+static err_t modbus_host_node_init(modbus_host_node_t* node, uint32_t baud, modbus_rtu_mode_t mode, modbus_rtu_address_t address)
+{
+    usart_bus_init_t usart_is;
+    modbus_rtu_init_t modbus_is;
+    err_t err;
+    
+    usart_sim_port_init(&node->port, baud);
+    usart_sim_port_bus_init(&node->port, &usart_is);
+    
+    err = usart_bus_init(&node->usart, &usart_is);
+    if(err != E_NO_ERROR) return err;
+    
+    usart_sim_port_attach(&node->port, &node->usart);
+    
+    usart_bus_set_idle_mode(&node->usart, USART_IDLE_MODE_END_RX);
+    
+    modbus_is.usart = &node->usart;
+    modbus_is.mode = mode;
+    modbus_is.address = address;
+    modbus_is.rx_message = &node->rx_messages[0];
+    modbus_is.tx_message = &node->tx_message;
+    
+    return modbus_rtu_init(&node->modbus, &modbus_is);
+}
+
+err_t modbus_host_init(uint32_t baud, bool rx_progress)
+{
+    timers_init_t timers_is;
+    err_t err;
+    size_t i;
+    
+    for(i = 0; i < MODBUS_HOST_REGS_COUNT; i ++){
+        holding_regs[i] = i;
+        input_regs[i] = 0x8000 | i;
+    }
+    for(i = 0; i < MODBUS_HOST_BITS_COUNT; i ++){
+        coils[i] = 0;
+        dins[i] = i & 0x1;
+    }
+    
+    slave_msg = false;
+    modbus_host_reset_times();
+    
+    timers_is.buffer = timers_buffer;
+    timers_is.count = MODBUS_HOST_TIMERS_COUNT;
+    timers_is.setup_timer_callback = setup_timer;
+    
+    timer_deadline_ns = 0;
+    
+    err = timers_init(&timers_is);
+    if(err != E_NO_ERROR) return err;
+    
+    // Ведущий.
+    err = modbus_host_node_init(&master, baud, MODBUS_RTU_MODE_MASTER, 0);
+    if(err != E_NO_ERROR) return err;
+    
+    usart_bus_set_rx_byte_callback(&master.usart, master_usart_rx_byte_callback);
+    usart_bus_set_rx_callback(&master.usart, master_usart_rx_callback);
+    usart_bus_set_tx_callback(&master.usart, master_usart_tx_callback);
+    
+    modbus_rtu_set_msg_recv_callback(&master.modbus, master_on_msg_recv);
+    modbus_rtu_set_msg_sent_callback(&master.modbus, master_on_msg_sent);
+    
+    // Ведомый.
+    err = modbus_host_node_init(&slave, baud, MODBUS_RTU_MODE_SLAVE, MODBUS_HOST_SLAVE_ADDRESS);
+    if(err != E_NO_ERROR) return err;
+    
+    usart_bus_set_rx_byte_callback(&slave.usart, slave_usart_rx_byte_callback);
+    usart_bus_set_rx_callback(&slave.usart, slave_usart_rx_callback);
+    usart_bus_set_tx_callback(&slave.usart, slave_usart_tx_callback);
+    
+    modbus_host_set_rx_progress(rx_progress);
+    
+    err = modbus_rtu_set_rx_messages(&slave.modbus, slave.rx_messages, MODBUS_HOST_RX_MESSAGES_COUNT);
+    if(err != E_NO_ERROR) return err;
+    
+    modbus_rtu_set_msg_recv_callback(&slave.modbus, slave_on_msg_recv);
+    modbus_rtu_set_report_slave_id_callback(&slave.modbus, slave_report_slave_id);
+    
+    err = modbus_reg_map_init(&slave_reg_map, slave_reg_map_entries, SLAVE_REG_MAP_ENTRIES_COUNT, slave_reg_map_index);
+    if(err != E_NO_ERROR) return err;
+    
+    modbus_rtu_set_reg_map(&slave.modbus, &slave_reg_map);
+    
+    usart_sim_connect(&master.port, &slave.port);
+    
+    return E_NO_ERROR;
+}
+
+void modbus_host_process(uint64_t now_ns)
+{
+    usart_sim_process(&master.port, now_ns);
+    
+    // Прерывание таймера.
+    if(timer_deadline_ns != 0 && now_ns >= timer_deadline_ns){
+        timer_deadline_ns = 0;
+        timers_timer_handler();
+    }
+    
+    // Главный цикл ведомого.
+    if(slave_msg && !usart_bus_tx_busy(&slave.usart)){
+        slave_msg = false;
+    
+        uint64_t t = usart_sim_time_ns();
+    
+        modbus_rtu_dispatch(&slave.modbus);
+    
+        slave_dispatch_time_ns += usart_sim_time_ns() - t;
+        slave_dispatch_count ++;
+    
+        if(modbus_rtu_rx_messages_pending(&slave.modbus) != 0){
+            slave_msg = true;
+        }
+    }else if(slave_rx_progress){
+        // Вычисление CRC принимаемого сообщения.
+        slave_rx_progress_timed();
+    }
+}
+
+void modbus_host_set_rx_progress(bool rx_progress)
+{
+    slave_rx_progress = rx_progress;
+    
+    usart_bus_set_rx_progress_callback(&slave.usart, rx_progress ? slave_usart_rx_progress_callback : NULL);
+}
+
+modbus_rtu_t* modbus_host_master(void)
+{
+    return &master.modbus;
+}
+
+modbus_rtu_t* modbus_host_slave(void)
+{
+    return &slave.modbus;
+}
+
+usart_sim_port_t* modbus_host_slave_port(void)
+{
+    return &slave.port;
+}
+
+usart_bus_t* modbus_host_slave_usart(void)
+{
+    return &slave.usart;
+}
+
+void modbus_host_set_master_callbacks(modbus_rtu_msg_recv_callback_t recv_callback,
+                                      modbus_rtu_msg_sent_callback_t sent_callback)
+{
+    master_recv_callback = recv_callback;
+    master_sent_callback = sent_callback;
+}
+
+uint16_t* modbus_host_holding_regs(void)
+{
+    return holding_regs;
+}
+
+uint8_t* modbus_host_coils(void)
+{
+    return coils;
+}
+
+uint64_t modbus_host_idle_time_ns(void)
+{
+    return slave_idle_time_ns;
+}
+
+uint64_t modbus_host_progress_time_ns(void)
+{
+    return slave_progress_time_ns;
+}
+
+uint32_t modbus_host_idle_count(void)
+{
+    return slave_idle_count;
+}
+
+uint64_t modbus_host_dispatch_time_ns(void)
+{
+    return slave_dispatch_time_ns;
+}
+
+uint32_t modbus_host_dispatch_count(void)
+{
+    return slave_dispatch_count;
+}
+
+void modbus_host_reset_times(void)
+{
+    slave_idle_time_ns = 0;
+    slave_progress_time_ns = 0;
+    slave_idle_count = 0;
+    slave_dispatch_time_ns = 0;
+    slave_dispatch_count = 0;
+}
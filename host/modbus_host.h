@@ -0,0 +1,145 @@
+/**
+ * @file modbus_host.h Стенд Modbus RTU на модели USART.
+ * Ведущий и ведомый работают с драйвером usart_bus
+ * через пару соединённых портов модели usart_sim.
+ * Ведомый обслуживает карту регистров:
+ * MODBUS_HOST_REGS_COUNT регистров хранения и ввода,
+ * MODBUS_HOST_BITS_COUNT флагов и дискретных входов.
+ * Принятые ведомым сообщения обрабатываются
+ * в modbus_host_process, как в главном цикле МК.
+ */
+
+#ifndef MODBUS_HOST_H
+#define MODBUS_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "usart_sim.h"
+#include "modbus/modbus_rtu.h"
+
+
+//! Адрес ведомого стенда.
+#define MODBUS_HOST_SLAVE_ADDRESS 1
+
+//! Число регистров хранения и ввода ведомого.
+#define MODBUS_HOST_REGS_COUNT 128
+
+//! Число флагов и дискретных входов ведомого.
+#define MODBUS_HOST_BITS_COUNT 2048
+
+//! Число буферов приёма сообщений ведомого.
+#define MODBUS_HOST_RX_MESSAGES_COUNT 2
+
+
+/**
+ * Инициализирует стенд.
+ * @param baud Скорость линии, бод.
+ * @param rx_progress Флаг вычисления CRC по мере приёма ведомым,
+ * см. modbus_host_set_rx_progress.
+ * @return Код ошибки.
+ */
+EXTERN err_t modbus_host_init(uint32_t baud, bool rx_progress);
+
+/**
+ * Обрабатывает события модели до заданного
+ * момента и принятые ведомым сообщения.
+ * @param now_ns Текущее время, нс.
+ */
+EXTERN void modbus_host_process(uint64_t now_ns);
+
+/**
+ * Устанавливает вычисление CRC по мере приёма ведомым:
+ * из прерывания половины передачи DMA и в modbus_host_process,
+ * как в главном цикле МК. Иначе CRC вычисляется
+ * целиком при IDLE. Устанавливается между сообщениями.
+ * @param rx_progress Флаг вычисления CRC по мере приёма.
+ */
+EXTERN void modbus_host_set_rx_progress(bool rx_progress);
+
+/**
+ * Получает протокол Modbus RTU ведущего.
+ * @return Протокол ведущего.
+ */
+EXTERN modbus_rtu_t* modbus_host_master(void);
+
+/**
+ * Получает протокол Modbus RTU ведомого.
+ * @return Протокол ведомого.
+ */
+EXTERN modbus_rtu_t* modbus_host_slave(void);
+
+/**
+ * Получает порт модели ведомого.
+ * @return Порт ведомого.
+ */
+EXTERN usart_sim_port_t* modbus_host_slave_port(void);
+
+/**
+ * Получает шину USART ведомого.
+ * @return Шина ведомого.
+ */
+EXTERN usart_bus_t* modbus_host_slave_usart(void);
+
+/**
+ * Устанавливает каллбэки ведущего.
+ * Вызываются из каллбэков приёма и передачи
+ * сообщения протокола ведущего.
+ * @param recv_callback Каллбэк приёма сообщения.
+ * @param sent_callback Каллбэк передачи сообщения.
+ */
+EXTERN void modbus_host_set_master_callbacks(modbus_rtu_msg_recv_callback_t recv_callback,
+                                             modbus_rtu_msg_sent_callback_t sent_callback);
+
+/**
+ * Получает регистры хранения ведомого.
+ * @return Регистры хранения.
+ */
+EXTERN uint16_t* modbus_host_holding_regs(void);
+
+/**
+ * Получает флаги ведомого.
+ * @return Флаги, по байту на флаг.
+ */
+EXTERN uint8_t* modbus_host_coils(void);
+
+/**
+ * Получает суммарное время обработки
+ * прерывания IDLE ведомого.
+ * @return Время, нс.
+ */
+EXTERN uint64_t modbus_host_idle_time_ns(void);
+
+/**
+ * Получает суммарное время вычисления
+ * CRC по мере приёма ведомым.
+ * @return Время, нс.
+ */
+EXTERN uint64_t modbus_host_progress_time_ns(void);
+
+/**
+ * Получает число прерываний IDLE ведомого.
+ * @return Число прерываний.
+ */
+EXTERN uint32_t modbus_host_idle_count(void);
+
+/**
+ * Получает суммарное время обработки
+ * принятых сообщений ведомым.
+ * @return Время, нс.
+ */
+EXTERN uint64_t modbus_host_dispatch_time_ns(void);
+
+/**
+ * Получает число обработанных ведомым сообщений.
+ * @return Число сообщений.
+ */
+EXTERN uint32_t modbus_host_dispatch_count(void);
+
+/**
+ * Сбрасывает время обработки прерываний
+ * и сообщений ведомого.
+ */
+EXTERN void modbus_host_reset_times(void);
+
+#endif /* MODBUS_HOST_H */
@@ -0,0 +1,145 @@
+/**
+ * @file sched_bench.c Измерение производительности планировщика.
+ * Для числа задач от 8 до 256 измеряется время добавления задачи,
+ * выбора и запуска очередной задачи (scheduler_instance_process)
+ * и замены задачи (удаление и добавление) при заполненной очереди.
+ * Приоритеты задач случайны, время операций с очередями
+ * приоритетов не должно зависеть от числа задач.
+ * Использование: sched_bench [число операций на измерение].
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "scheduler/scheduler.h"
+
+
+//! Число операций на измерение по-умолчанию.
+#define SCHED_BENCH_OPS_DEFAULT 2000000
+
+//! Максимальное число задач.
+#define SCHED_BENCH_TASKS_MAX 256
+
+static TASKS_BUFFER(tasks_buffer, SCHED_BENCH_TASKS_MAX);
+static task_id_t tids[SCHED_BENCH_TASKS_MAX];
+static scheduler_t scheduler;
+
+//! Число запусков задач.
+static volatile uint32_t runs = 0;
+
+static void* bench_task(void* arg)
+{
+    (void)arg;
+    
+    runs ++;
+    
+    return NULL;
+}
+
+static uint64_t time_ns(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static task_priority_t bench_priority(void)
+{
+    return rand() % SCHEDULER_PRIORITIES_COUNT;
+}
+
+/**
+ * Заполняет планировщик задачами.
+ * @return Время заполнения, нс.
+ */
+static uint64_t bench_fill(size_t count)
+{
+    size_t i;
+    
+    scheduler_instance_init(&scheduler, tasks_buffer, count);
+    
+    uint64_t t = time_ns();
+    
+    for(i = 0; i < count; i ++){
+        tids[i] = scheduler_instance_add_task(&scheduler, bench_task, bench_priority(), NULL, 0, NULL);
+    }
+    
+    return time_ns() - t;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t ops = argc > 1 ? (uint32_t)atol(argv[1]) : SCHED_BENCH_OPS_DEFAULT;
+    size_t count;
+    size_t i;
+    uint32_t op;
+    
+    if(ops == 0){
+        printf("invalid arguments\n");
+        return 2;
+    }
+    
+    srand(1);
+    
+    printf("scheduler, %u ops per measurement, ns per op\n", ops);
+    printf("tasks       add  dispatch  replace\n");
+    
+    for(count = 8; count <= SCHED_BENCH_TASKS_MAX; count *= 2){
+        uint32_t rounds = ops / count;
+        uint64_t add_ns = 0;
+    
+        if(rounds == 0) rounds = 1;
+    
+        // Добавление.
+        for(op = 0; op < rounds; op ++){
+            add_ns += bench_fill(count);
+        }
+    
+        for(i = 0; i < count; i ++){
+            if(tids[i] == INVALID_TASK_ID){
+                printf("add task failed\n");
+                return 1;
+            }
+        }
+    
+        // Выбор и запуск.
+        runs = 0;
+    
+        uint64_t t = time_ns();
+    
+        for(op = 0; op < ops; op ++){
+            scheduler_instance_process(&scheduler);
+        }
+    
+        uint64_t dispatch_ns = time_ns() - t;
+    
+        if(runs != ops){
+            printf("dispatch failed\n");
+            return 1;
+        }
+    
+        // Замена.
+        t = time_ns();
+    
+        for(op = 0; op < ops; op ++){
+            i = op % count;
+            scheduler_instance_remove_task(&scheduler, tids[i]);
+            tids[i] = scheduler_instance_add_task(&scheduler, bench_task, bench_priority(), NULL, 0, NULL);
+        }
+    
+        uint64_t replace_ns = time_ns() - t;
+    
+        if(scheduler_instance_tasks_count(&scheduler) != count){
+            printf("replace failed\n");
+            return 1;
+        }
+    
+        printf("%5u  %8.1f  %8.1f  %7.1f\n", (unsigned)count,
+               (double)add_ns / ((uint64_t)rounds * count),
+               (double)dispatch_ns / ops, (double)replace_ns / ops);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,275 @@
+/**
+ * @file spsc_stress.c Нагрузочная проверка кольцевого буфера
+ * в режиме USE_CIRCULAR_BUFFER_SPSC.
+ * Производитель и потребитель работают в разных потоках
+ * и передают через буфер последовательность байт,
+ * проверяемую потребителем. Проверяются копирование
+ * с переходом через конец буфера (circular_buffer_write/read),
+ * области записи и чтения (acquire/commit) и их сочетания,
+ * измеряется пропускная способность.
+ * Использование: spsc_stress [объём на режим, МиБ].
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "buffer/circular_buffer.h"
+
+#ifndef USE_CIRCULAR_BUFFER_SPSC
+#error spsc_stress requires USE_CIRCULAR_BUFFER_SPSC
+#endif
+
+
+//! Объём данных на режим по-умолчанию, МиБ.
+#define SPSC_STRESS_MIB_DEFAULT 256
+
+//! Размер памяти буфера, округляется до 512.
+#define SPSC_STRESS_MEMORY_SIZE 1000
+//! Ожидаемый размер буфера.
+#define SPSC_STRESS_BUFFER_SIZE 512
+
+//! Максимальный размер блока копирования.
+#define SPSC_STRESS_BLOCK_MAX 384
+
+
+//! Способ обмена одной стороны.
+typedef enum _Spsc_Stress_Mode {
+    SPSC_STRESS_COPY = 0, //!< circular_buffer_write/read.
+    SPSC_STRESS_ZERO_COPY, //!< acquire/commit.
+    SPSC_STRESS_BYTE //!< circular_buffer_put/get.
+} spsc_stress_mode_t;
+
+//! Сочетания способов производителя и потребителя.
+static const struct {
+    spsc_stress_mode_t producer;
+    spsc_stress_mode_t consumer;
+    const char* name;
+} spsc_stress_cases[] = {
+    {SPSC_STRESS_COPY, SPSC_STRESS_COPY, "write/read"},
+    {SPSC_STRESS_ZERO_COPY, SPSC_STRESS_ZERO_COPY, "acquire/commit"},
+    {SPSC_STRESS_COPY, SPSC_STRESS_ZERO_COPY, "write/read_acquire"},
+    {SPSC_STRESS_ZERO_COPY, SPSC_STRESS_COPY, "write_acquire/read"},
+    {SPSC_STRESS_BYTE, SPSC_STRESS_BYTE, "put/get"},
+};
+
+#define SPSC_STRESS_CASES_COUNT (sizeof(spsc_stress_cases) / sizeof(spsc_stress_cases[0]))
+
+static uint8_t memory[SPSC_STRESS_MEMORY_SIZE];
+static circular_buffer_t buffer;
+
+//! Параметры текущего режима.
+static spsc_stress_mode_t producer_mode;
+static spsc_stress_mode_t consumer_mode;
+static uint64_t total_size;
+
+//! Результаты сторон.
+static uint64_t producer_wraps;
+static uint64_t consumer_wraps;
+static uint64_t consumer_errors;
+
+//! Байт последовательности.
+static inline uint8_t spsc_stress_byte(uint64_t index)
+{
+    return (uint8_t)(index ^ (index >> 8) ^ (index >> 16));
+}
+
+static size_t spsc_stress_block_size(unsigned int* seed, uint64_t remaining)
+{
+    size_t size = 1 + rand_r(seed) % SPSC_STRESS_BLOCK_MAX;
+    
+    if(size > remaining) size = remaining;
+    
+    return size;
+}
+
+//! Проверяет переход области через конец буфера.
+static bool spsc_stress_wraps(size_t index, size_t size)
+{
+    return (index & (SPSC_STRESS_BUFFER_SIZE - 1)) + size > SPSC_STRESS_BUFFER_SIZE;
+}
+
+static void* spsc_stress_producer(void* arg)
+{
+    (void)arg;
+    
+    unsigned int seed = 1;
+    uint8_t block[SPSC_STRESS_BLOCK_MAX];
+    uint64_t index = 0;
+    size_t size, done, i;
+    uint8_t* ptr;
+    
+    producer_wraps = 0;
+    
+    while(index < total_size){
+        switch(producer_mode){
+            case SPSC_STRESS_COPY:
+                size = spsc_stress_block_size(&seed, total_size - index);
+                for(i = 0; i < size; i ++) block[i] = spsc_stress_byte(index + i);
+    
+                size_t put = buffer.put;
+                // Блок записывается целиком - запись переходит
+                // через конец буфера независимо от очерёдности потоков.
+                done = 0;
+                if(circular_buffer_free_size(&buffer) >= size){
+                    done = circular_buffer_write(&buffer, block, size);
+                }
+                if(spsc_stress_wraps(put, done)) producer_wraps ++;
+                break;
+            case SPSC_STRESS_ZERO_COPY:
+                size = circular_buffer_write_acquire(&buffer, &ptr);
+                if(size > total_size - index) size = total_size - index;
+                // Частичное заполнение области.
+                if(size > 1 && (rand_r(&seed) & 1)) size = 1 + rand_r(&seed) % size;
+                for(i = 0; i < size; i ++) ptr[i] = spsc_stress_byte(index + i);
+                done = circular_buffer_write_commit(&buffer, size);
+                break;
+            default:
+                done = circular_buffer_put(&buffer, spsc_stress_byte(index));
+                break;
+        }
+        // Буфер заполнен - уступить процессор потребителю.
+        if(done == 0) sched_yield();
+        index += done;
+    }
+    
+    return NULL;
+}
+
+static void* spsc_stress_consumer(void* arg)
+{
+    (void)arg;
+    
+    unsigned int seed = 2;
+    uint8_t block[SPSC_STRESS_BLOCK_MAX];
+    const uint8_t* data;
+    uint64_t index = 0;
+    size_t size, done, i;
+    const uint8_t* ptr;
+    uint8_t byte;
+    
+    consumer_wraps = 0;
+    consumer_errors = 0;
+    
+    while(index < total_size){
+        switch(consumer_mode){
+            case SPSC_STRESS_COPY:
+                size = spsc_stress_block_size(&seed, total_size - index);
+    
+                size_t get = buffer.get;
+                // Блок читается целиком, аналогично записи.
+                done = 0;
+                if(circular_buffer_avail_size(&buffer) >= size){
+                    done = circular_buffer_read(&buffer, block, size);
+                }
+                if(spsc_stress_wraps(get, done)) consumer_wraps ++;
+                data = block;
+                break;
+            case SPSC_STRESS_ZERO_COPY:
+                size = circular_buffer_read_acquire(&buffer, &ptr);
+                if(size > 1 && (rand_r(&seed) & 1)) size = 1 + rand_r(&seed) % size;
+                data = ptr;
+                done = size;
+                break;
+            default:
+                done = circular_buffer_get(&buffer, &byte);
+                data = &byte;
+                break;
+        }
+    
+        for(i = 0; i < done; i ++){
+            if(data[i] != spsc_stress_byte(index + i)) consumer_errors ++;
+        }
+    
+        if(consumer_mode == SPSC_STRESS_ZERO_COPY && done != 0){
+            if(circular_buffer_read_commit(&buffer, done) != done) consumer_errors ++;
+        }
+        
+        // Буфер пуст - уступить процессор производителю.
+        if(done == 0) sched_yield();
+    
+        index += done;
+    }
+    
+    return NULL;
+}
+
+static uint64_t time_ns(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t mib = argc > 1 ? (uint64_t)atol(argv[1]) : SPSC_STRESS_MIB_DEFAULT;
+    pthread_t producer, consumer;
+    int errors = 0;
+    size_t i;
+    
+    if(mib == 0){
+        printf("invalid arguments\n");
+        return 2;
+    }
+    
+    circular_buffer_init(&buffer, memory, SPSC_STRESS_MEMORY_SIZE);
+    
+    if(circular_buffer_size(&buffer) != SPSC_STRESS_BUFFER_SIZE){
+        printf("FAIL: buffer size %u\n", (unsigned)circular_buffer_size(&buffer));
+        return 1;
+    }
+    
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    
+    printf("spsc circular buffer %u bytes, %u MiB per case\n", SPSC_STRESS_BUFFER_SIZE, (unsigned)mib);
+    printf("case                    MB/s   wraps(put/get)\n");
+    
+    for(i = 0; i < SPSC_STRESS_CASES_COUNT; i ++){
+        producer_mode = spsc_stress_cases[i].producer;
+        consumer_mode = spsc_stress_cases[i].consumer;
+        // Побайтовый обмен медленнее, объём меньше.
+        total_size = mib * 1024 * 1024;
+        if(producer_mode == SPSC_STRESS_BYTE) total_size /= 16;
+    
+        circular_buffer_reset(&buffer);
+    
+        uint64_t t = time_ns();
+    
+        pthread_create(&producer, NULL, spsc_stress_producer, NULL);
+        pthread_create(&consumer, NULL, spsc_stress_consumer, NULL);
+        pthread_join(producer, NULL);
+        pthread_join(consumer, NULL);
+    
+        t = time_ns() - t;
+    
+        printf("%-20s  %7.1f   %llu/%llu\n", spsc_stress_cases[i].name,
+               (double)total_size * 1000 / t,
+               (unsigned long long)producer_wraps, (unsigned long long)consumer_wraps);
+    
+        if(consumer_errors != 0){
+            printf("FAIL: %s: %llu invalid bytes\n", spsc_stress_cases[i].name, (unsigned long long)consumer_errors);
+            errors ++;
+        }
+        if(circular_buffer_avail_size(&buffer) != 0){
+            printf("FAIL: %s: buffer not empty\n", spsc_stress_cases[i].name);
+            errors ++;
+        }
+        if(producer_mode == SPSC_STRESS_COPY && producer_wraps == 0){
+            printf("FAIL: %s: no wrapped writes\n", spsc_stress_cases[i].name);
+            errors ++;
+        }
+        if(consumer_mode == SPSC_STRESS_COPY && consumer_wraps == 0){
+            printf("FAIL: %s: no wrapped reads\n", spsc_stress_cases[i].name);
+            errors ++;
+        }
+    }
+    
+    printf(errors ? "FAILED\n" : "OK\n");
+    
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file stm32f10x.h Заглушка заголовка МК для сборки на хосте.
+ * Объявляет регистры USART и DMA, используемые драйверами,
+ * в виде обычных структур в памяти. Состояние регистров
+ * изменяется моделью периферии usart_sim.
+ */
+
+#ifndef HOST_STM32F10X_H
+#define HOST_STM32F10X_H
+
+#ifdef __arm__
+#error host stm32f10x.h must not be used for target build!
+#endif
+
+#include <stdint.h>
+
+
+//! Состояние функции периферии.
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+
+//! Регистры USART.
+typedef struct _Usart_TypeDef {
+    volatile uint32_t SR; //!< Регистр состояния.
+    volatile uint32_t DR; //!< Регистр данных.
+    volatile uint32_t BRR; //!< Регистр скорости.
+    volatile uint32_t CR1; //!< Регистр управления 1.
+    volatile uint32_t CR2; //!< Регистр управления 2.
+    volatile uint32_t CR3; //!< Регистр управления 3.
+    volatile uint32_t GTPR; //!< Регистр защитного времени и делителя.
+} USART_TypeDef;
+
+//! Регистры канала DMA.
+typedef struct _Dma_Channel_TypeDef {
+    volatile uint32_t CCR; //!< Регистр конфигурации.
+    volatile uint32_t CNDTR; //!< Число данных для передачи.
+    volatile uint32_t CPAR; //!< Адрес периферии.
+    volatile uint32_t CMAR; //!< Адрес памяти.
+    uintptr_t memory; //!< Полный адрес памяти (CMAR на хосте не вмещает указатель).
+} DMA_Channel_TypeDef;
+
+//! Установка адреса памяти канала DMA (вместо dma.h) - указатель не вмещается в CMAR.
+#define dma_channel_set_memory_address(dma_channel, address)\
+            ((dma_channel)->memory = (uintptr_t)(address))
+
+//! Регистры DMA.
+typedef struct _Dma_TypeDef {
+    volatile uint32_t ISR; //!< Регистр флагов прерываний.
+    volatile uint32_t IFCR; //!< Регистр сброса флагов прерываний.
+} DMA_TypeDef;
+
+
+// USART_SR.
+#define USART_SR_PE 0x1
+#define USART_SR_FE 0x2
+#define USART_SR_NE 0x4
+#define USART_SR_ORE 0x8
+#define USART_SR_IDLE 0x10
+#define USART_SR_RXNE 0x20
+#define USART_SR_TC 0x40
+#define USART_SR_TXE 0x80
+
+// USART_CR1.
+#define USART_CR1_RWU 0x2
+#define USART_CR1_RE 0x4
+#define USART_CR1_TE 0x8
+#define USART_CR1_IDLEIE 0x10
+#define USART_CR1_RXNEIE 0x20
+#define USART_CR1_TCIE 0x40
+#define USART_CR1_TXEIE 0x80
+#define USART_CR1_PEIE 0x100
+#define USART_CR1_WAKE 0x800
+#define USART_CR1_UE 0x2000
+
+// USART_CR3.
+#define USART_CR3_EIE 0x1
+#define USART_CR3_HDSEL 0x8
+#define USART_CR3_DMAR 0x40
+#define USART_CR3_DMAT 0x80
+
+// DMA_CCR.
+#define DMA_CCR1_EN 0x1
+#define DMA_CCR1_TCIE 0x2
+#define DMA_CCR1_HTIE 0x4
+#define DMA_CCR1_TEIE 0x8
+#define DMA_CCR1_DIR 0x10
+#define DMA_CCR1_CIRC 0x20
+#define DMA_CCR1_PINC 0x40
+#define DMA_CCR1_MINC 0x80
+#define DMA_CCR1_PL_0 0x1000
+
+// Флаги прерываний канала DMA.
+#define DMA_IT_GL 0x1
+#define DMA_IT_TC 0x2
+#define DMA_IT_HT 0x4
+#define DMA_IT_TE 0x8
+
+#endif /* HOST_STM32F10X_H */
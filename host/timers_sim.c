@@ -0,0 +1,191 @@
+/**
+ * @file timers_sim.c Проверка таймеров в режиме USE_TIMERS_TICKLESS
+ * на моделируемых часах (USE_TIMERS_SIM_CLOCK).
+ * Для однократных и периодических таймеров с близкими
+ * сроками срабатывания при разном допустимом запаздывании
+ * проверяется число срабатываний таймера отсчёта времени
+ * (объединение сроков в пределах запаздывания),
+ * число запусков таймеров и то, что каждый таймер
+ * запущен не раньше своего срока и не позже срока
+ * с учётом допустимого запаздывания.
+ * Использование: timers_sim.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "timers/timers.h"
+
+#ifndef USE_TIMERS_SIM_CLOCK
+#error timers_sim requires USE_TIMERS_SIM_CLOCK
+#endif
+
+
+//! Число таймеров случая проверки.
+#define TIMERS_SIM_TIMERS_COUNT 3
+
+//! Продвижение часов для сброса установленного срока между случаями.
+#define TIMERS_SIM_DRAIN_TICKS 1000000
+
+
+//! Случай проверки.
+typedef struct _Timers_Sim_Case {
+    const char* name; //!< Название.
+    timers_ticks_t slack; //!< Допустимое запаздывание.
+    timers_ticks_t offsets[TIMERS_SIM_TIMERS_COUNT]; //!< Сроки таймеров от начала случая.
+    timers_ticks_t period; //!< Период таймеров, 0 - однократные.
+    timers_ticks_t advance; //!< Продвижение часов.
+    uint32_t interrupts; //!< Ожидаемое число срабатываний.
+    uint32_t runs; //!< Ожидаемое число запусков таймеров.
+} timers_sim_case_t;
+
+/**
+ * Случаи проверки.
+ * Таймеры добавляются не по порядку сроков -
+ * установленный срок должен переноситься на более ранний.
+ * Установленный срок не переносится на более поздний,
+ * поэтому периодические таймеры добавляются от последнего
+ * к первому и объединяются начиная с первого периода.
+ */
+static const timers_sim_case_t cases[] = {
+    {"one-shot, slack 0",   0, {110, 100, 105}, 0,    200, 3, 3},
+    {"one-shot, slack 5",   5, {110, 100, 105}, 0,    200, 2, 3},
+    {"one-shot, slack 20", 20, {110, 100, 105}, 0,    200, 1, 3},
+    {"periodic, slack 0",   0, {1008, 1003, 1000}, 1000, 10500, 30, 30},
+    {"periodic, slack 10", 10, {1008, 1003, 1000}, 1000, 10500, 10, 30},
+};
+
+#define CASES_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+
+//! Состояние таймера случая проверки.
+typedef struct _Timers_Sim_Timer {
+    timers_ticks_t deadline; //!< Очередной срок.
+    timers_ticks_t period; //!< Период.
+    timers_ticks_t slack; //!< Допустимое запаздывание.
+    timers_ticks_t late_max; //!< Наибольшее запаздывание.
+    uint32_t runs; //!< Число запусков.
+    uint32_t errors; //!< Число запусков вне допустимого окна.
+} timers_sim_timer_t;
+
+static TIMERS_BUFFER(timers_buffer, TIMERS_SIM_TIMERS_COUNT);
+static timers_t timers;
+static timers_sim_timer_t sim_timers[TIMERS_SIM_TIMERS_COUNT];
+static timer_id_t tids[TIMERS_SIM_TIMERS_COUNT];
+
+static void* timers_sim_timer_proc(void* arg)
+{
+    timers_sim_timer_t* sim_timer = (timers_sim_timer_t*)arg;
+    timers_ticks_t ticks = timers_sim_get_ticks();
+    
+    if(ticks < sim_timer->deadline || ticks - sim_timer->deadline > sim_timer->slack){
+        sim_timer->errors ++;
+    }else if(ticks - sim_timer->deadline > sim_timer->late_max){
+        sim_timer->late_max = ticks - sim_timer->deadline;
+    }
+    
+    sim_timer->deadline += sim_timer->period;
+    sim_timer->runs ++;
+    
+    return NULL;
+}
+
+/**
+ * Выполняет случай проверки.
+ * @return Число ошибок.
+ */
+static int timers_sim_run_case(const timers_sim_case_t* c)
+{
+    timers_init_t is;
+    timers_ticks_t late_max = 0;
+    uint32_t runs = 0;
+    uint32_t run_errors = 0;
+    int errors = 0;
+    size_t i;
+    
+    is.buffer = timers_buffer;
+    is.count = TIMERS_SIM_TIMERS_COUNT;
+    is.get_ticks_callback = timers_sim_get_ticks;
+    is.setup_deadline_callback = timers_sim_setup_deadline;
+    is.slack = c->slack;
+    
+    timers_instance_init(&timers, &is);
+    
+    timers_ticks_t start = timers_sim_get_ticks();
+    uint32_t interrupts = timers_sim_interrupts();
+    
+    for(i = 0; i < TIMERS_SIM_TIMERS_COUNT; i ++){
+        sim_timers[i].deadline = start + c->offsets[i];
+        sim_timers[i].period = c->period;
+        sim_timers[i].slack = c->slack;
+        sim_timers[i].late_max = 0;
+        sim_timers[i].runs = 0;
+        sim_timers[i].errors = 0;
+    
+        tids[i] = timers_instance_add_timer_ticks(&timers, timers_sim_timer_proc,
+                        sim_timers[i].deadline, c->period, &sim_timers[i], NULL);
+        if(tids[i] == INVALID_TIMER_ID){
+            printf("FAIL: %s: add timer failed\n", c->name);
+            return 1;
+        }
+    }
+    
+    timers_instance_sim_advance(&timers, c->advance);
+    
+    interrupts = timers_sim_interrupts() - interrupts;
+    
+    for(i = 0; i < TIMERS_SIM_TIMERS_COUNT; i ++){
+        runs += sim_timers[i].runs;
+        run_errors += sim_timers[i].errors;
+        if(sim_timers[i].late_max > late_max) late_max = sim_timers[i].late_max;
+    }
+    
+    printf("%-20s  %10u  %5u  %8u\n", c->name, (unsigned)interrupts,
+           (unsigned)runs, (unsigned)late_max);
+    
+    if(interrupts != c->interrupts){
+        printf("FAIL: %s: %u interrupts, expected %u\n", c->name,
+               (unsigned)interrupts, (unsigned)c->interrupts);
+        errors ++;
+    }
+    if(runs != c->runs){
+        printf("FAIL: %s: %u runs, expected %u\n", c->name,
+               (unsigned)runs, (unsigned)c->runs);
+        errors ++;
+    }
+    if(run_errors != 0){
+        printf("FAIL: %s: %u runs outside of [deadline, deadline + slack]\n", c->name,
+               (unsigned)run_errors);
+        errors ++;
+    }
+    
+    // Удаление периодических таймеров и сброс
+    // установленного ими срока моделируемых часов.
+    for(i = 0; i < TIMERS_SIM_TIMERS_COUNT; i ++){
+        timers_instance_remove_timer(&timers, tids[i]);
+    }
+    timers_instance_sim_advance(&timers, TIMERS_SIM_DRAIN_TICKS);
+    
+    if(timers_instance_timers_count(&timers) != 0){
+        printf("FAIL: %s: timers left\n", c->name);
+        errors ++;
+    }
+    
+    return errors;
+}
+
+int main(void)
+{
+    int errors = 0;
+    size_t i;
+    
+    printf("tickless timers on simulated clock\n");
+    printf("case                  interrupts   runs  max late\n");
+    
+    for(i = 0; i < CASES_COUNT; i ++){
+        errors += timers_sim_run_case(&cases[i]);
+    }
+    
+    printf(errors ? "FAILED\n" : "OK\n");
+    
+    return errors ? 1 : 0;
+}
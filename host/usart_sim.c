@@ -0,0 +1,439 @@
+#include "usart_sim.h"
+#include "dma/dma.h"
+#include <string.h>
+#include <time.h>
+
+
+//! Число каналов DMA1 и DMA2.
+#define USART_SIM_DMA_PERIPH_CHANNELS 7
+//! Общее число каналов модели.
+#define USART_SIM_DMA_CHANNELS (USART_SIM_DMA_PERIPH_CHANNELS * 2)
+
+//! Периферия DMA модели.
+static DMA_TypeDef usart_sim_dma_periphs[2];
+//! Каналы DMA модели в порядке регистрации.
+static usart_sim_dma_t* usart_sim_dma_channels[USART_SIM_DMA_CHANNELS];
+//! Число зарегистрированных каналов.
+static size_t usart_sim_dma_channels_count = 0;
+
+
+/*
+ * Функции dma.h.
+ */
+
+static usart_sim_dma_t* usart_sim_dma_by_channel(DMA_Channel_TypeDef* dma_channel)
+{
+    size_t i = 0;
+    for(; i < usart_sim_dma_channels_count; i ++){
+        if(&usart_sim_dma_channels[i]->regs == dma_channel) return usart_sim_dma_channels[i];
+    }
+    return NULL;
+}
+
+uint32_t dma_channel_number(DMA_Channel_TypeDef* dma_channel)
+{
+    size_t i = 0;
+    for(; i < usart_sim_dma_channels_count; i ++){
+        if(&usart_sim_dma_channels[i]->regs == dma_channel){
+            // Нумерация как у МК: 1-7 для DMA1 и 8-14 для DMA2.
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+DMA_TypeDef* dma_channel_dma_periph(DMA_Channel_TypeDef* dma_channel)
+{
+    uint32_t channel_number = dma_channel_number(dma_channel);
+    
+    if(channel_number == 0) return NULL;
+    if(channel_number <= USART_SIM_DMA_PERIPH_CHANNELS) return &usart_sim_dma_periphs[0];
+    
+    return &usart_sim_dma_periphs[1];
+}
+
+uint32_t dma_channel_it_flag(DMA_Channel_TypeDef* dma_channel, uint32_t dma_it_flag)
+{
+    uint32_t channel_number = dma_channel_number(dma_channel);
+    
+    if(channel_number == 0) return 0;
+    if(channel_number <= USART_SIM_DMA_PERIPH_CHANNELS) return dma_it_flag << ((channel_number - 1) * 4);
+    
+    return (dma_it_flag << ((channel_number - 1 - USART_SIM_DMA_PERIPH_CHANNELS) * 4)) | DMA_PERIPH_SEL;
+}
+
+bool dma_channel_it_flag_status(uint32_t dma_ch_it_flag)
+{
+    DMA_TypeDef* dma = &usart_sim_dma_periphs[(dma_ch_it_flag & DMA_PERIPH_SEL) ? 1 : 0];
+    
+    return (dma->ISR & (dma_ch_it_flag & ~DMA_PERIPH_SEL)) != 0;
+}
+
+void dma_channel_it_flag_clear(uint32_t dma_ch_it_flag)
+{
+    DMA_TypeDef* dma = &usart_sim_dma_periphs[(dma_ch_it_flag & DMA_PERIPH_SEL) ? 1 : 0];
+    
+    // Запись в IFCR сбрасывает флаги ISR.
+    dma->ISR &= ~(dma_ch_it_flag & ~DMA_PERIPH_SEL);
+}
+
+err_t dma_channel_lock(DMA_Channel_TypeDef* dma_channel)
+{
+    usart_sim_dma_t* dma = usart_sim_dma_by_channel(dma_channel);
+    
+    if(dma == NULL) return E_INVALID_VALUE;
+    
+    // Модель однопоточна, ожидать разблокировки некому.
+    if(dma->locked) return E_BUSY;
+    
+    dma->locked = true;
+    
+    return E_NO_ERROR;
+}
+
+bool dma_channel_trylock(DMA_Channel_TypeDef* dma_channel)
+{
+    usart_sim_dma_t* dma = usart_sim_dma_by_channel(dma_channel);
+    
+    if(dma == NULL || dma->locked) return false;
+    
+    dma->locked = true;
+    
+    return true;
+}
+
+err_t dma_channel_unlock(DMA_Channel_TypeDef* dma_channel)
+{
+    usart_sim_dma_t* dma = usart_sim_dma_by_channel(dma_channel);
+    
+    if(dma == NULL) return E_INVALID_VALUE;
+    
+    dma->locked = false;
+    
+    return E_NO_ERROR;
+}
+
+
+/*
+ * Модель периферии.
+ */
+
+static void usart_sim_dma_register(usart_sim_dma_t* dma)
+{
+    bool registered = usart_sim_dma_by_channel(&dma->regs) != NULL;
+    
+    memset(dma, 0x0, sizeof(usart_sim_dma_t));
+    
+    // Повторная инициализация порта.
+    if(registered) return;
+    
+    if(usart_sim_dma_channels_count < USART_SIM_DMA_CHANNELS){
+        usart_sim_dma_channels[usart_sim_dma_channels_count ++] = dma;
+    }
+}
+
+/**
+ * Устанавливает флаг прерывания канала DMA
+ * и возвращает разрешение прерывания.
+ */
+static bool usart_sim_dma_set_it_flag(usart_sim_dma_t* dma, uint32_t dma_it_flag)
+{
+    uint32_t flag = dma_channel_it_flag(&dma->regs, dma_it_flag | DMA_IT_GL);
+    
+    usart_sim_dma_periphs[(flag & DMA_PERIPH_SEL) ? 1 : 0].ISR |= flag & ~DMA_PERIPH_SEL;
+    
+    // Биты разрешения прерываний в CCR совпадают с битами флагов.
+    return (dma->regs.CCR & dma_it_flag) != 0;
+}
+
+/**
+ * Выполняет обмен байтом по каналу DMA.
+ * @return Адрес памяти обмена.
+ */
+static uint8_t* usart_sim_dma_transfer(usart_sim_dma_t* dma)
+{
+    // Адрес или счётчик изменены драйвером - новая передача.
+    if(dma->regs.memory != dma->memory || dma->regs.CNDTR != dma->remaining){
+        dma->count = dma->regs.CNDTR;
+    }
+    
+    uint8_t* address = (uint8_t*)dma->regs.memory;
+    
+    dma->regs.memory ++;
+    dma->regs.CNDTR --;
+    
+    dma->memory = dma->regs.memory;
+    dma->remaining = dma->regs.CNDTR;
+    
+    return address;
+}
+
+/**
+ * Устанавливает флаги прерываний канала DMA после обмена.
+ * @return Флаг необходимости вызова обработчика прерывания.
+ */
+static bool usart_sim_dma_transfer_it(usart_sim_dma_t* dma)
+{
+    if(dma->regs.CNDTR == 0) return usart_sim_dma_set_it_flag(dma, DMA_IT_TC);
+    
+    // Половина передачи.
+    if(dma->count / 2 != 0 && dma->count - dma->regs.CNDTR == dma->count / 2){
+        return usart_sim_dma_set_it_flag(dma, DMA_IT_HT);
+    }
+    
+    return false;
+}
+
+/**
+ * Проверяет готовность канала DMA к обмену.
+ */
+static bool usart_sim_dma_ready(usart_sim_port_t* port, usart_sim_dma_t* dma, uint32_t cr3_flag)
+{
+    return (dma->regs.CCR & DMA_CCR1_EN) && (port->regs.CR3 & cr3_flag) && dma->regs.CNDTR != 0;
+}
+
+/**
+ * Вызывает обработчик прерывания USART
+ * и сбрасывает флаги, сбрасываемые чтением SR и DR.
+ */
+static void usart_sim_usart_irq(usart_sim_port_t* port)
+{
+    if(port->bus) usart_bus_irq_handler(port->bus);
+    
+    port->regs.SR &= ~(USART_SR_RXNE | USART_SR_IDLE | USART_SR_ORE);
+}
+
+/**
+ * Загружает очередной байт для передачи из DMA.
+ */
+static void usart_sim_tx_load(usart_sim_port_t* port, uint64_t now_ns)
+{
+    if(port->tx_shifting) return;
+    if(!(port->regs.CR1 & USART_CR1_TE)) return;
+    if(!usart_sim_dma_ready(port, &port->dma_tx, USART_CR3_DMAT)) return;
+    
+    uint8_t* address = usart_sim_dma_transfer(&port->dma_tx);
+    
+    port->tx_shift_byte = *address;
+    port->tx_shift_end_ns = now_ns + port->byte_time_ns;
+    port->tx_shifting = true;
+    port->regs.SR &= ~USART_SR_TC;
+    
+    if(usart_sim_dma_transfer_it(&port->dma_tx) && port->bus){
+        usart_bus_dma_tx_channel_irq_handler(port->bus);
+    }
+}
+
+/**
+ * Завершает передачу байта в линию.
+ */
+static void usart_sim_tx_end(usart_sim_port_t* port)
+{
+    uint64_t end_ns = port->tx_shift_end_ns;
+    
+    port->tx_shifting = false;
+    port->tx_bytes ++;
+    
+    if(port->peer) usart_sim_rx_byte(port->peer, port->tx_shift_byte, end_ns);
+    
+    // Передача без паузы, если есть данные.
+    usart_sim_tx_load(port, end_ns);
+    
+    if(!port->tx_shifting){
+        port->regs.SR |= USART_SR_TC;
+        if(port->regs.CR1 & USART_CR1_TCIE) usart_sim_usart_irq(port);
+    }
+}
+
+/**
+ * Формирует событие свободной линии.
+ */
+static void usart_sim_rx_idle(usart_sim_port_t* port)
+{
+    port->rx_idle_armed = false;
+    
+    // Свободная линия выводит приёмник из сна без флага IDLE.
+    if(port->regs.CR1 & USART_CR1_RWU){
+        port->regs.CR1 &= ~USART_CR1_RWU;
+        return;
+    }
+    
+    port->regs.SR |= USART_SR_IDLE;
+    
+    if(port->regs.CR1 & USART_CR1_IDLEIE){
+        usart_sim_usart_irq(port);
+    }else{
+        port->regs.SR &= ~USART_SR_IDLE;
+    }
+}
+
+ALWAYS_INLINE static uint64_t usart_sim_idle_time(usart_sim_port_t* port)
+{
+    return port->rx_last_ns + port->byte_time_ns;
+}
+
+void usart_sim_port_init(usart_sim_port_t* port, uint32_t baud)
+{
+    memset(&port->regs, 0x0, sizeof(USART_TypeDef));
+    
+    usart_sim_dma_register(&port->dma_rx);
+    usart_sim_dma_register(&port->dma_tx);
+    
+    port->bus = NULL;
+    port->peer = NULL;
+    port->byte_time_ns = (uint64_t)1000000000 * USART_SIM_BITS_PER_BYTE / baud;
+    port->tx_shifting = false;
+    port->tx_shift_byte = 0;
+    port->tx_shift_end_ns = 0;
+    port->rx_last_ns = 0;
+    port->rx_idle_armed = false;
+    port->last_ns = 0;
+    port->rx_bytes = 0;
+    port->rx_dropped = 0;
+    port->tx_bytes = 0;
+    
+    // Периферия включена, передатчик пуст.
+    port->regs.CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+    port->regs.SR = USART_SR_TC | USART_SR_TXE;
+}
+
+void usart_sim_port_bus_init(usart_sim_port_t* port, usart_bus_init_t* usart_is)
+{
+    usart_is->usart_device = &port->regs;
+    usart_is->dma_rx_channel = &port->dma_rx.regs;
+    usart_is->dma_tx_channel = &port->dma_tx.regs;
+}
+
+void usart_sim_port_attach(usart_sim_port_t* port, usart_bus_t* bus)
+{
+    port->bus = bus;
+}
+
+void usart_sim_connect(usart_sim_port_t* a, usart_sim_port_t* b)
+{
+    a->peer = b;
+    b->peer = a;
+}
+
+void usart_sim_rx_byte(usart_sim_port_t* port, uint8_t byte, uint64_t now_ns)
+{
+    // Пауза перед стартом байта.
+    if(port->rx_idle_armed && now_ns - port->byte_time_ns > usart_sim_idle_time(port)){
+        usart_sim_rx_idle(port);
+    }
+    
+    if(!(port->regs.CR1 & USART_CR1_RE)){
+        port->rx_dropped ++;
+        return;
+    }
+    
+    port->rx_bytes ++;
+    port->rx_last_ns = now_ns;
+    port->rx_idle_armed = true;
+    
+    // Приёмник в режиме пробуждения по свободной линии
+    // игнорирует байты до паузы.
+    if(port->regs.CR1 & USART_CR1_RWU){
+        return;
+    }
+    
+    if(usart_sim_dma_ready(port, &port->dma_rx, USART_CR3_DMAR)){
+        uint8_t* address = usart_sim_dma_transfer(&port->dma_rx);
+        
+        *address = byte;
+        
+        if(usart_sim_dma_transfer_it(&port->dma_rx) && port->bus){
+            usart_bus_dma_rx_channel_irq_handler(port->bus);
+        }
+        return;
+    }
+    
+    if(port->regs.SR & USART_SR_RXNE) port->regs.SR |= USART_SR_ORE;
+    
+    port->regs.DR = byte;
+    port->regs.SR |= USART_SR_RXNE;
+    
+    if(port->regs.CR1 & USART_CR1_RXNEIE) usart_sim_usart_irq(port);
+}
+
+/**
+ * Выполняет ближайшее событие порта до заданного момента.
+ * @return Флаг выполнения события.
+ */
+static bool usart_sim_port_step(usart_sim_port_t* port, uint64_t* event_ns, uint64_t now_ns)
+{
+    usart_sim_port_t* peer = port->peer;
+    uint64_t tx_ns = port->tx_shifting ? port->tx_shift_end_ns : UINT64_MAX;
+    uint64_t idle_ns = port->rx_idle_armed ? usart_sim_idle_time(port) : UINT64_MAX;
+    
+    // Байт, начатый до истечения паузы, отменяет её.
+    if(peer && peer->tx_shifting && peer->tx_shift_end_ns - peer->byte_time_ns <= idle_ns){
+        idle_ns = UINT64_MAX;
+    }
+    
+    if(tx_ns <= idle_ns && tx_ns <= now_ns && tx_ns <= *event_ns){
+        *event_ns = tx_ns;
+        return true;
+    }
+    if(idle_ns < tx_ns && idle_ns <= now_ns && idle_ns <= *event_ns){
+        *event_ns = idle_ns;
+        return true;
+    }
+    return false;
+}
+
+static void usart_sim_port_exec(usart_sim_port_t* port, uint64_t event_ns)
+{
+    if(port->tx_shifting && port->tx_shift_end_ns == event_ns){
+        usart_sim_tx_end(port);
+    }else{
+        usart_sim_rx_idle(port);
+    }
+}
+
+void usart_sim_process(usart_sim_port_t* port, uint64_t now_ns)
+{
+    usart_sim_port_t* peer = port->peer;
+    uint64_t event_ns;
+    
+    // Первая обработка задаёт начало времени модели.
+    if(port->last_ns == 0) port->last_ns = now_ns;
+    if(peer && peer->last_ns == 0) peer->last_ns = now_ns;
+    
+    // Передача, начатая вне модели, начинается
+    // с момента предыдущей обработки.
+    usart_sim_tx_load(port, port->last_ns > port->tx_shift_end_ns ? port->last_ns : port->tx_shift_end_ns);
+    if(peer) usart_sim_tx_load(peer, peer->last_ns > peer->tx_shift_end_ns ? peer->last_ns : peer->tx_shift_end_ns);
+    
+    // События обоих концов линии в порядке времени.
+    for(;;){
+        event_ns = UINT64_MAX;
+    
+        bool port_event = usart_sim_port_step(port, &event_ns, now_ns);
+        bool peer_event = peer && usart_sim_port_step(peer, &event_ns, now_ns);
+    
+        if(peer_event){
+            usart_sim_port_exec(peer, event_ns);
+        }else if(port_event){
+            usart_sim_port_exec(port, event_ns);
+        }else{
+            break;
+        }
+    
+        // Передача, начатая из прерываний.
+        usart_sim_tx_load(port, event_ns);
+        if(peer) usart_sim_tx_load(peer, event_ns);
+    }
+    
+    port->last_ns = now_ns;
+    if(peer) peer->last_ns = now_ns;
+}
+
+uint64_t usart_sim_time_ns(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
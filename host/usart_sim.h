@@ -0,0 +1,109 @@
+/**
+ * @file usart_sim.h Модель USART и DMA для сборки на хосте.
+ * Порт модели содержит регистры USART и каналов DMA
+ * приёма и передачи, с которыми работает драйвер usart_bus.
+ * Порты соединяются попарно линией, байты передаются
+ * со скоростью, заданной в бодах (10 бит на байт).
+ * Модель вызывает обработчики прерываний драйвера
+ * при приёме байта, завершении DMA и свободной линии (IDLE).
+ * Время модели задаётся вызывающим в наносекундах,
+ * что позволяет работать как в реальном времени,
+ * так и с моделируемыми часами.
+ * Также реализует функции dma.h для каналов модели.
+ */
+
+#ifndef USART_SIM_H
+#define USART_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "usart/usart_bus.h"
+
+
+//! Число бит на байт (старт, 8 бит данных, стоп).
+#define USART_SIM_BITS_PER_BYTE 10
+
+//! Тип состояния канала DMA модели.
+typedef struct _Usart_Sim_Dma {
+    DMA_Channel_TypeDef regs; //!< Регистры канала.
+    uint32_t count; //!< Число данных текущей передачи.
+    uintptr_t memory; //!< Адрес памяти после последнего обмена.
+    uint32_t remaining; //!< Число данных после последнего обмена.
+    bool locked; //!< Флаг блокировки канала.
+} usart_sim_dma_t;
+
+//! Тип порта модели.
+typedef struct _Usart_Sim_Port {
+    USART_TypeDef regs; //!< Регистры USART.
+    usart_sim_dma_t dma_rx; //!< Канал DMA приёма.
+    usart_sim_dma_t dma_tx; //!< Канал DMA передачи.
+    usart_bus_t* bus; //!< Драйвер шины порта.
+    struct _Usart_Sim_Port* peer; //!< Порт на другом конце линии.
+    uint64_t byte_time_ns; //!< Время передачи байта, нс.
+    bool tx_shifting; //!< Флаг передачи байта в линию.
+    uint8_t tx_shift_byte; //!< Передаваемый байт.
+    uint64_t tx_shift_end_ns; //!< Время окончания передачи байта.
+    uint64_t rx_last_ns; //!< Время приёма последнего байта.
+    bool rx_idle_armed; //!< Флаг ожидания IDLE после приёма.
+    uint64_t last_ns; //!< Время предыдущей обработки событий.
+    uint32_t rx_bytes; //!< Число принятых байт.
+    uint32_t rx_dropped; //!< Число потерянных байт (приёмник выключен).
+    uint32_t tx_bytes; //!< Число переданных байт.
+} usart_sim_port_t;
+
+
+/**
+ * Инициализирует порт модели.
+ * @param port Порт.
+ * @param baud Скорость линии, бод.
+ */
+EXTERN void usart_sim_port_init(usart_sim_port_t* port, uint32_t baud);
+
+/**
+ * Заполняет структуру инициализации драйвера
+ * регистрами порта модели.
+ * @param port Порт.
+ * @param usart_is Структура инициализации шины USART.
+ */
+EXTERN void usart_sim_port_bus_init(usart_sim_port_t* port, usart_bus_init_t* usart_is);
+
+/**
+ * Связывает порт с драйвером, обработчики
+ * прерываний которого вызывает модель.
+ * @param port Порт.
+ * @param bus Шина USART.
+ */
+EXTERN void usart_sim_port_attach(usart_sim_port_t* port, usart_bus_t* bus);
+
+/**
+ * Соединяет два порта линией.
+ * @param a Первый порт.
+ * @param b Второй порт.
+ */
+EXTERN void usart_sim_connect(usart_sim_port_t* a, usart_sim_port_t* b);
+
+/**
+ * Передаёт байт в порт так, как если бы
+ * он был принят с линии в заданный момент.
+ * @param port Порт.
+ * @param byte Байт.
+ * @param now_ns Время приёма, нс.
+ */
+EXTERN void usart_sim_rx_byte(usart_sim_port_t* port, uint8_t byte, uint64_t now_ns);
+
+/**
+ * Выполняет события порта до заданного момента:
+ * передачу байт, приём IDLE.
+ * @param port Порт.
+ * @param now_ns Текущее время, нс.
+ */
+EXTERN void usart_sim_process(usart_sim_port_t* port, uint64_t now_ns);
+
+/**
+ * Получает текущее время монотонных часов хоста.
+ * @return Время, нс.
+ */
+EXTERN uint64_t usart_sim_time_ns(void);
+
+#endif /* USART_SIM_H */
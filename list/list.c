@@ -3,6 +3,9 @@
 #include "utils/utils.h"
 
 
+// Проверка числа элементов, переносимых list_split, обходом списка.
+//#define LIST_DEBUG
+
 
 ALWAYS_INLINE static void list_item_link(list_item_t* prev, list_item_t* next)
 {
@@ -54,6 +57,7 @@ err_t list_init(list_t* list)
 {
     list->head = NULL;
     list->tail = NULL;
+    list->size = 0;
     list->alloc_item = NULL;
     list->free_item = NULL;
 
@@ -70,7 +74,11 @@ err_t list_append(list_t* list, list_item_t* item)
 {
     if(item == NULL) return E_NULL_POINTER;
     
+    list->size ++;
+    
     if(list->tail == NULL){
+        item->prev = NULL;
+        item->next = NULL;
         list->head = item;
         list->tail = item;
         return E_NO_ERROR;
@@ -88,7 +96,11 @@ err_t list_prepend(list_t* list, list_item_t* item)
 {
     if(item == NULL) return E_NULL_POINTER;
     
+    list->size ++;
+    
     if(list->head == NULL){
+        item->prev = NULL;
+        item->next = NULL;
         list->head = item;
         list->tail = item;
         return E_NO_ERROR;
@@ -111,6 +123,8 @@ err_t list_insert_after(list_t* list, list_item_t* ref, list_item_t* item)
     
     list_item_link2(ref, item, ref->next);
     
+    list->size ++;
+    
     return E_NO_ERROR;
 }
 err_t list_insert_before(list_t* list, list_item_t* ref, list_item_t* item)
@@ -122,6 +136,8 @@ err_t list_insert_before(list_t* list, list_item_t* ref, list_item_t* item)
     
     list_item_link2(ref->prev, item, ref);
     
+    list->size ++;
+    
     return E_NO_ERROR;
 }
 
@@ -130,11 +146,7 @@ err_t list_insert_sorted(list_t* list, list_item_t* item, int (*compare)(const v
     if(item == NULL) return E_NULL_POINTER;
     if(compare == NULL) return E_NULL_POINTER;
     
-    if(list->head == NULL){
-        list->head = item;
-        list->tail = item;
-        return E_NO_ERROR;
-    }
+    if(list->head == NULL) return list_append(list, item);
     
     list_item_t* cur = list->head;
     int cmp = 0;
@@ -162,11 +174,7 @@ err_t list_rinsert_sorted(list_t* list, list_item_t* item, int (*compare)(const
     if(item == NULL) return E_NULL_POINTER;
     if(compare == NULL) return E_NULL_POINTER;
 
-    if(list->head == NULL){
-        list->head = item;
-        list->tail = item;
-        return E_NO_ERROR;
-    }
+    if(list->head == NULL) return list_append(list, item);
 
     list_item_t* cur = list->tail;
     int cmp = 0;
@@ -207,6 +215,75 @@ err_t list_remove(list_t* list, list_item_t* item)
     item->prev = NULL;
     item->next = NULL;
     
+    list->size --;
+    
+    return E_NO_ERROR;
+}
+
+err_t list_splice(list_t* list, list_t* other)
+{
+    if(other == NULL) return E_NULL_POINTER;
+    if(other == list) return E_INVALID_VALUE;
+    
+    if(other->head == NULL) return E_NO_ERROR;
+    
+    if(list->tail == NULL){
+        list->head = other->head;
+    }else{
+        list_item_link(list->tail, other->head);
+    }
+    
+    list->tail = other->tail;
+    list->size += other->size;
+    
+    other->head = NULL;
+    other->tail = NULL;
+    other->size = 0;
+    
+    return E_NO_ERROR;
+}
+
+err_t list_split(list_t* list, list_item_t* item, size_t count, list_t* other)
+{
+    if(other == NULL) return E_NULL_POINTER;
+    if(other == list) return E_INVALID_VALUE;
+    
+    if(item == NULL) return list_splice(other, list);
+    
+    // Перед первым элементом списка нет элементов.
+    if(item == list->head) return (count == 0) ? E_NO_ERROR : E_INVALID_VALUE;
+    
+    if(count == 0 || count >= list->size) return E_INVALID_VALUE;
+    
+#ifdef LIST_DEBUG
+    size_t n = 0;
+    list_item_t* cur = list->head;
+    
+    for(; cur != item && cur != NULL; cur = cur->next) n ++;
+    
+    if(cur != item || n != count) return E_INVALID_VALUE;
+#endif
+    
+    list_item_t* first = list->head;
+    list_item_t* last = item->prev;
+    
+    if(last == NULL) return E_INVALID_VALUE;
+    
+    list->head = item;
+    item->prev = NULL;
+    list->size -= count;
+    
+    last->next = NULL;
+    
+    if(other->tail == NULL){
+        other->head = first;
+    }else{
+        list_item_link(other->tail, first);
+    }
+    
+    other->tail = last;
+    other->size += count;
+    
     return E_NO_ERROR;
 }
 
@@ -250,7 +327,7 @@ list_item_t* list_insert_sorted_new(list_t* list, void* data, int (*compare)(con
 {
     list_item_t* item = list_alloc_item(list, data);
     
-    list_insert_sorted(list, data, compare);
+    list_insert_sorted(list, item, compare);
     
     return item;
 }
@@ -355,20 +432,6 @@ void list_rforeach2_second(list_t* list, void (*proc)(void* item_data, void* use
     }
 }
 
-size_t list_size(list_t* list)
-{
-    size_t size = 0;
-    list_item_t* item = list_first(list);
-    
-    while(item){
-        size ++;
-        
-        item = list_next(item);
-    }
-    
-    return size;
-}
-
 err_t list_item_init(list_item_t* item)
 {
     item->data = NULL;
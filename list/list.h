@@ -19,6 +19,7 @@ typedef void (*list_free_item_t)(list_item_t* item);
 typedef struct _List {
     list_item_t* head; //!< Первый элемент списка.
     list_item_t* tail; //!< Последний элемент списка.
+    size_t size; //!< Число элементов списка.
     list_alloc_item_t alloc_item; //!< Функция выделения памяти.
     list_free_item_t free_item; //!< Функция освобождения памяти.
 } list_t;
@@ -118,6 +119,37 @@ EXTERN err_t list_insert_sorted(list_t* list, list_item_t* item, int (*compare)(
  */
 EXTERN err_t list_rinsert_sorted(list_t* list, list_item_t* item, int (*compare)(const void*, const void*));
 
+/**
+ * Переносит все элементы списка other
+ * в конец списка list.
+ * Выполняется за постоянное время.
+ * @param list Список.
+ * @param other Переносимый список.
+ * @return Код ошибки.
+ */
+EXTERN err_t list_splice(list_t* list, list_t* other);
+
+/**
+ * Переносит элементы начала списка до
+ * заданного элемента (не включая его)
+ * в конец списка other.
+ * Выполняется за постоянное время, поэтому
+ * число переносимых элементов передаётся
+ * вызывающей стороной, которая, как правило,
+ * получает его при поиске элемента item.
+ * Число должно быть точным, иначе размеры списков
+ * станут неверными; при определении LIST_DEBUG
+ * в list.c оно проверяется обходом списка.
+ * Для item, равного первому элементу списка,
+ * число должно быть равно нулю.
+ * @param list Список.
+ * @param item Элемент списка, NULL для переноса всего списка.
+ * @param count Число переносимых элементов.
+ * @param other Список назначения.
+ * @return Код ошибки.
+ */
+EXTERN err_t list_split(list_t* list, list_item_t* item, size_t count, list_t* other);
+
 /**
  * Удаляет элемент из списка.
  * @param list Список.
@@ -286,7 +318,10 @@ EXTERN void list_rforeach2_second(list_t* list, void (*proc)(void* item_data, vo
  * @param list Список.
  * @return Размер списка.
  */
-EXTERN size_t list_size(list_t* list);
+ALWAYS_INLINE static size_t list_size(list_t* list)
+{
+    return list->size;
+}
 
 /**
  * Получает флаг пустоты списка.
@@ -0,0 +1,116 @@
+#include "mempool.h"
+#include "utils/critical.h"
+
+
+#define MEMPOOL_LOCK(pool) do{ if((pool)->isr_safe) CRITICAL_ENTER(); }while(0)
+#define MEMPOOL_UNLOCK(pool) do{ if((pool)->isr_safe) CRITICAL_EXIT(); }while(0)
+
+
+err_t mempool_init(mempool_t* pool, void* memory, size_t block_size, size_t blocks_count, bool isr_safe)
+{
+    if(pool == NULL || memory == NULL) return E_NULL_POINTER;
+    if(block_size == 0 || blocks_count == 0) return E_INVALID_VALUE;
+    
+    pool->memory = (uint8_t*)memory;
+    pool->block_size = MEMPOOL_BLOCK_SIZE(block_size);
+    pool->blocks_count = blocks_count;
+    pool->used = 0;
+    pool->max_used = 0;
+    pool->failures = 0;
+    pool->isr_safe = isr_safe;
+    
+    mempool_block_t* block;
+    size_t i = blocks_count;
+    
+    pool->free_list = NULL;
+    
+    // Связывание блоков в порядке возрастания адресов.
+    while(i > 0){
+        i --;
+        block = (mempool_block_t*)(pool->memory + i * pool->block_size);
+        block->next = pool->free_list;
+        pool->free_list = block;
+    }
+    
+    return E_NO_ERROR;
+}
+
+void* mempool_alloc(mempool_t* pool)
+{
+    MEMPOOL_LOCK(pool);
+    
+    mempool_block_t* block = pool->free_list;
+    
+    if(block == NULL){
+        pool->failures ++;
+        MEMPOOL_UNLOCK(pool);
+        return NULL;
+    }
+    
+    pool->free_list = block->next;
+    
+    pool->used ++;
+    if(pool->used > pool->max_used) pool->max_used = pool->used;
+    
+    MEMPOOL_UNLOCK(pool);
+    
+    return block;
+}
+
+bool mempool_contains(const mempool_t* pool, const void* block)
+{
+    const uint8_t* ptr = (const uint8_t*)block;
+    
+    if(ptr < pool->memory) return false;
+    
+    size_t offset = (size_t)(ptr - pool->memory);
+    
+    if(offset >= pool->block_size * pool->blocks_count) return false;
+    
+    return (offset % pool->block_size) == 0;
+}
+
+err_t mempool_free(mempool_t* pool, void* block)
+{
+    if(block == NULL) return E_NULL_POINTER;
+    if(!mempool_contains(pool, block)) return E_INVALID_VALUE;
+    
+    mempool_block_t* pool_block = (mempool_block_t*)block;
+    
+    MEMPOOL_LOCK(pool);
+    
+    if(pool->used == 0){
+        MEMPOOL_UNLOCK(pool);
+        return E_INVALID_OPERATION;
+    }
+    
+#ifdef USE_MEMPOOL_CHECK_FREE
+    mempool_block_t* free_block = pool->free_list;
+    
+    for(; free_block != NULL; free_block = free_block->next){
+        if(free_block == pool_block){
+            MEMPOOL_UNLOCK(pool);
+            return E_INVALID_OPERATION;
+        }
+    }
+#endif
+    
+    pool_block->next = pool->free_list;
+    pool->free_list = pool_block;
+    
+    pool->used --;
+    
+    MEMPOOL_UNLOCK(pool);
+    
+    return E_NO_ERROR;
+}
+
+void mempool_reset_stats(mempool_t* pool)
+{
+    MEMPOOL_LOCK(pool);
+    
+    pool->max_used = pool->used;
+    pool->failures = 0;
+    
+    MEMPOOL_UNLOCK(pool);
+}
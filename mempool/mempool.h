@@ -0,0 +1,178 @@
+/**
+ * @file mempool.h Библиотека пула блоков памяти фиксированного размера.
+ * Выделение и освобождение блока выполняются за O(1):
+ * свободные блоки связаны в список, указатель на следующий
+ * свободный блок хранится в самом блоке.
+ * Для использования из прерываний пул инициализируется
+ * с флагом isr_safe, операции при этом выполняются
+ * в критической секции.
+ * Повторное освобождение блока приводит к неопределённому
+ * поведению; при сборке с USE_MEMPOOL_CHECK_FREE оно
+ * обнаруживается проверкой списка свободных блоков за O(n).
+ * Макросы MEMPOOL_LIST_ALLOCATOR и MEMPOOL_RBTREE_ALLOCATOR
+ * объявляют пул и функции выделения памяти для списка
+ * (list_set_allocator) и дерева (rbtree_init).
+ */
+
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "errors/errors.h"
+#include "defs/defs.h"
+
+
+//! Число указателей, занимаемых блоком заданного размера.
+#define MEMPOOL_BLOCK_WORDS(block_size) (((block_size) + sizeof(void*) - 1) / sizeof(void*))
+
+//! Размер блока с учётом выравнивания.
+#define MEMPOOL_BLOCK_SIZE(block_size) (MEMPOOL_BLOCK_WORDS(block_size) * sizeof(void*))
+
+//! Декларация выровненной памяти пула.
+#define MEMPOOL_BUFFER(name, block_size, count) void* name[MEMPOOL_BLOCK_WORDS(block_size) * (count)]
+
+//! Свободный блок пула.
+typedef struct _Mempool_Block {
+    struct _Mempool_Block* next; //!< Следующий свободный блок.
+} mempool_block_t;
+
+//! Пул блоков памяти.
+typedef struct _Mempool {
+    mempool_block_t* free_list; //!< Список свободных блоков.
+    uint8_t* memory; //!< Память пула.
+    size_t block_size; //!< Размер блока.
+    size_t blocks_count; //!< Число блоков.
+    size_t used; //!< Число выделенных блоков.
+    size_t max_used; //!< Максимальное число выделенных блоков.
+    uint32_t failures; //!< Число неудачных выделений.
+    bool isr_safe; //!< Флаг использования из прерываний.
+} mempool_t;
+
+/**
+ * Инициализирует пул.
+ * @param pool Пул.
+ * @param memory Память пула (см. MEMPOOL_BUFFER).
+ * @param block_size Размер блока.
+ * @param blocks_count Число блоков.
+ * @param isr_safe Флаг использования из прерываний.
+ * @return Код ошибки.
+ */
+EXTERN err_t mempool_init(mempool_t* pool, void* memory, size_t block_size, size_t blocks_count, bool isr_safe);
+
+/**
+ * Выделяет блок.
+ * @param pool Пул.
+ * @return Блок, NULL при отсутствии свободных блоков.
+ */
+EXTERN void* mempool_alloc(mempool_t* pool);
+
+/**
+ * Освобождает блок.
+ * Блок не должен быть уже освобождён.
+ * @param pool Пул.
+ * @param block Блок.
+ * @return Код ошибки, E_INVALID_VALUE для блока вне пула,
+ * E_INVALID_OPERATION при освобождении блока пула,
+ * в котором нет выделенных блоков, либо, при USE_MEMPOOL_CHECK_FREE,
+ * уже свободного блока.
+ */
+EXTERN err_t mempool_free(mempool_t* pool, void* block);
+
+/**
+ * Проверяет принадлежность блока пулу.
+ * @param pool Пул.
+ * @param block Блок.
+ * @return Флаг принадлежности блока пулу.
+ */
+EXTERN bool mempool_contains(const mempool_t* pool, const void* block);
+
+/**
+ * Получает размер блока пула.
+ * @param pool Пул.
+ * @return Размер блока.
+ */
+ALWAYS_INLINE static size_t mempool_block_size(const mempool_t* pool)
+{
+    return pool->block_size;
+}
+
+/**
+ * Получает число блоков пула.
+ * @param pool Пул.
+ * @return Число блоков.
+ */
+ALWAYS_INLINE static size_t mempool_blocks_count(const mempool_t* pool)
+{
+    return pool->blocks_count;
+}
+
+/**
+ * Получает число выделенных блоков.
+ * @param pool Пул.
+ * @return Число выделенных блоков.
+ */
+ALWAYS_INLINE static size_t mempool_used(const mempool_t* pool)
+{
+    return pool->used;
+}
+
+/**
+ * Получает максимальное число одновременно выделенных блоков.
+ * @param pool Пул.
+ * @return Максимальное число выделенных блоков.
+ */
+ALWAYS_INLINE static size_t mempool_max_used(const mempool_t* pool)
+{
+    return pool->max_used;
+}
+
+/**
+ * Получает число неудачных выделений.
+ * @param pool Пул.
+ * @return Число неудачных выделений.
+ */
+ALWAYS_INLINE static uint32_t mempool_failures(const mempool_t* pool)
+{
+    return pool->failures;
+}
+
+/**
+ * Сбрасывает статистику пула.
+ * @param pool Пул.
+ */
+EXTERN void mempool_reset_stats(mempool_t* pool);
+
+/**
+ * Объявляет пул и функции выделения памяти.
+ * @param name Имя пула.
+ * @param type Тип выделяемого объекта.
+ * @param count Число объектов.
+ * @param isr_safe Флаг использования из прерываний.
+ * Объявляются пул name, функция инициализации name_init(),
+ * функции name_alloc() и name_free(type*).
+ */
+#define MEMPOOL_ALLOCATOR(name, type, count, isr_safe)\
+    static MEMPOOL_BUFFER(name##_memory, sizeof(type), count);\
+    static mempool_t name;\
+    UNUSED static err_t name##_init(void)\
+    {\
+        return mempool_init(&name, name##_memory, sizeof(type), count, isr_safe);\
+    }\
+    UNUSED static type* name##_alloc(void)\
+    {\
+        return (type*)mempool_alloc(&name);\
+    }\
+    UNUSED static void name##_free(type* obj)\
+    {\
+        mempool_free(&name, obj);\
+    }
+
+//! Объявляет пул элементов списка (см. MEMPOOL_ALLOCATOR, list_set_allocator).
+#define MEMPOOL_LIST_ALLOCATOR(name, count, isr_safe) MEMPOOL_ALLOCATOR(name, list_item_t, count, isr_safe)
+
+//! Объявляет пул узлов дерева (см. MEMPOOL_ALLOCATOR, rbtree_init).
+#define MEMPOOL_RBTREE_ALLOCATOR(name, count, isr_safe) MEMPOOL_ALLOCATOR(name, rbtree_node_t, count, isr_safe)
+
+#endif /* MEMPOOL_H */
@@ -0,0 +1,394 @@
+#include "modbus_reg_map.h"
+#include <string.h>
+
+
+/**
+ * Получает ключ упорядочивания регистра.
+ * @param type Тип данных.
+ * @param address Адрес регистра.
+ * @return Ключ.
+ */
+ALWAYS_INLINE static uint32_t modbus_reg_map_key(modbus_rtu_data_type_t type, uint16_t address)
+{
+    return ((uint32_t)type << 16) | address;
+}
+
+//! Получает ключ упорядочивания диапазона.
+ALWAYS_INLINE static uint32_t modbus_reg_map_entry_key(const modbus_reg_map_entry_t* entry)
+{
+    return modbus_reg_map_key(entry->type, entry->address);
+}
+
+//! Получает флаг масштабирования значений диапазона.
+ALWAYS_INLINE static bool modbus_reg_map_entry_scaled(const modbus_reg_map_entry_t* entry)
+{
+    return entry->scale_mul != 0 || entry->scale_div != 0;
+}
+
+//! Получает множитель масштабирования диапазона.
+ALWAYS_INLINE static int32_t modbus_reg_map_entry_mul(const modbus_reg_map_entry_t* entry)
+{
+    return entry->scale_mul ? entry->scale_mul : 1;
+}
+
+//! Получает делитель масштабирования диапазона.
+ALWAYS_INLINE static int32_t modbus_reg_map_entry_div(const modbus_reg_map_entry_t* entry)
+{
+    return entry->scale_div ? entry->scale_div : 1;
+}
+
+//! Проверяет принадлежность значения диапазону int16_t.
+ALWAYS_INLINE static bool modbus_reg_map_int16_valid(int32_t value)
+{
+    return value >= INT16_MIN && value <= INT16_MAX;
+}
+
+//! Ограничивает значение диапазоном int16_t.
+ALWAYS_INLINE static int16_t modbus_reg_map_int16_sat(int32_t value)
+{
+    if(value < INT16_MIN) return INT16_MIN;
+    if(value > INT16_MAX) return INT16_MAX;
+    return (int16_t)value;
+}
+
+/**
+ * Проверяет диапазон таблицы.
+ * @param entry Диапазон.
+ * @return Флаг допустимости диапазона.
+ */
+static bool modbus_reg_map_entry_valid(const modbus_reg_map_entry_t* entry)
+{
+    if(entry->count == 0) return false;
+    if((uint32_t)entry->address + entry->count > 0x10000) return false;
+    
+    if(entry->access & MODBUS_REG_MAP_ACCESS_READ){
+        if(entry->data == NULL && entry->get == NULL) return false;
+    }
+    
+    if(entry->access & MODBUS_REG_MAP_ACCESS_WRITE){
+        if(entry->type == MODBUS_RTU_DISCR_INPUT || entry->type == MODBUS_RTU_INPUT_REG) return false;
+        if(entry->data == NULL && entry->set == NULL) return false;
+    }
+    
+    return true;
+}
+
+err_t modbus_reg_map_init(modbus_reg_map_t* map, const modbus_reg_map_entry_t* entries, size_t count, const modbus_reg_map_entry_t** index)
+{
+    if(map == NULL || index == NULL) return E_NULL_POINTER;
+    if(entries == NULL && count != 0) return E_NULL_POINTER;
+    
+    const modbus_reg_map_entry_t* entry;
+    size_t i, j;
+    
+    // Сортировка вставками - таблицы обычно
+    // невелики и уже упорядочены.
+    for(i = 0; i < count; i ++){
+        entry = &entries[i];
+    
+        if(!modbus_reg_map_entry_valid(entry)) return E_INVALID_VALUE;
+    
+        for(j = i; j > 0 && modbus_reg_map_entry_key(index[j - 1]) > modbus_reg_map_entry_key(entry); j --){
+            index[j] = index[j - 1];
+        }
+        index[j] = entry;
+    }
+    
+    // Проверка пересечения диапазонов.
+    for(i = 1; i < count; i ++){
+        if(index[i - 1]->type == index[i]->type &&
+           (uint32_t)index[i - 1]->address + index[i - 1]->count > index[i]->address){
+            return E_INVALID_VALUE;
+        }
+    }
+    
+    map->index = index;
+    map->count = count;
+    
+    return E_NO_ERROR;
+}
+
+/**
+ * Ищет индекс диапазона, содержащего регистр.
+ * @param map Карта регистров.
+ * @param type Тип данных.
+ * @param address Адрес регистра.
+ * @return Индекс диапазона, либо число диапазонов.
+ */
+static size_t modbus_reg_map_find_index(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address)
+{
+    uint32_t key = modbus_reg_map_key(type, address);
+    
+    size_t lo = 0;
+    size_t hi = map->count;
+    size_t mid;
+    
+    // Поиск первого диапазона с ключом, большим искомого.
+    while(lo < hi){
+        mid = (lo + hi) / 2;
+        if(modbus_reg_map_entry_key(map->index[mid]) <= key){
+            lo = mid + 1;
+        }else{
+            hi = mid;
+        }
+    }
+    
+    if(lo == 0) return map->count;
+    
+    const modbus_reg_map_entry_t* entry = map->index[lo - 1];
+    
+    if(entry->type != type || (uint32_t)entry->address + entry->count <= address) return map->count;
+    
+    return lo - 1;
+}
+
+const modbus_reg_map_entry_t* modbus_reg_map_find(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address)
+{
+    size_t i = modbus_reg_map_find_index(map, type, address);
+    
+    if(i >= map->count) return NULL;
+    
+    return map->index[i];
+}
+
+/**
+ * Проверяет доступ к блоку регистров.
+ * Блок должен быть полностью покрыт
+ * смежными диапазонами с заданными правами.
+ * @param map Карта регистров.
+ * @param type Тип данных.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param access Права доступа.
+ * @param first Индекс первого диапазона блока.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+static modbus_rtu_error_t modbus_reg_map_check(const modbus_reg_map_t* map, modbus_rtu_data_type_t type,
+                                               uint16_t address, uint16_t count, modbus_reg_map_access_t access, size_t* first)
+{
+    size_t i = modbus_reg_map_find_index(map, type, address);
+    
+    *first = i;
+    
+    uint32_t cur_address = address;
+    uint32_t end_address = (uint32_t)address + count;
+    
+    const modbus_reg_map_entry_t* entry;
+    
+    while(cur_address < end_address){
+        if(i >= map->count) return MODBUS_RTU_ERROR_INVALID_ADDRESS;
+    
+        entry = map->index[i];
+    
+        if(entry->type != type || entry->address > cur_address) return MODBUS_RTU_ERROR_INVALID_ADDRESS;
+        if((entry->access & access) != access) return MODBUS_RTU_ERROR_INVALID_ADDRESS;
+    
+        cur_address = (uint32_t)entry->address + entry->count;
+        i ++;
+    }
+    
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+modbus_rtu_error_t modbus_reg_map_read_bits(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, uint8_t* values)
+{
+    size_t i;
+    
+    modbus_rtu_error_t err = modbus_reg_map_check(map, type, address, count, MODBUS_REG_MAP_ACCESS_READ, &i);
+    if(err != MODBUS_RTU_ERROR_NONE) return err;
+    
+    const modbus_reg_map_entry_t* entry;
+    uint16_t value;
+    uint16_t offset;
+    uint16_t n = 0;
+    
+    for(; n < count; i ++){
+        entry = map->index[i];
+        offset = address + n - entry->address;
+    
+        for(; n < count && offset < entry->count; n ++, offset ++){
+            if(entry->get){
+                err = entry->get(address + n, &value);
+                if(err != MODBUS_RTU_ERROR_NONE) return err;
+            }else{
+                value = ((const uint8_t*)entry->data)[offset];
+            }
+    
+            if(value) values[n >> 3] |= (1 << (n & 0x7));
+        }
+    }
+    
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+modbus_rtu_error_t modbus_reg_map_write_bits(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, const uint8_t* values)
+{
+    size_t i;
+    
+    modbus_rtu_error_t err = modbus_reg_map_check(map, type, address, count, MODBUS_REG_MAP_ACCESS_WRITE, &i);
+    if(err != MODBUS_RTU_ERROR_NONE) return err;
+    
+    const modbus_reg_map_entry_t* entry;
+    uint16_t value;
+    uint16_t offset;
+    uint16_t n = 0;
+    
+    for(; n < count; i ++){
+        entry = map->index[i];
+        offset = address + n - entry->address;
+    
+        for(; n < count && offset < entry->count; n ++, offset ++){
+            value = (values[n >> 3] >> (n & 0x7)) & 0x1;
+    
+            if(entry->set){
+                err = entry->set(address + n, value);
+                if(err != MODBUS_RTU_ERROR_NONE) return err;
+            }else{
+                ((uint8_t*)entry->data)[offset] = value;
+            }
+        }
+    }
+    
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+modbus_rtu_error_t modbus_reg_map_read_regs(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, uint16_t* values)
+{
+    size_t i;
+    
+    modbus_rtu_error_t err = modbus_reg_map_check(map, type, address, count, MODBUS_REG_MAP_ACCESS_READ, &i);
+    if(err != MODBUS_RTU_ERROR_NONE) return err;
+    
+    const modbus_reg_map_entry_t* entry;
+    uint16_t offset;
+    uint16_t size;
+    uint16_t j;
+    uint16_t n = 0;
+    
+    for(; n < count; i ++, n += size){
+        entry = map->index[i];
+        offset = address + n - entry->address;
+        size = entry->count - offset;
+        if(size > count - n) size = count - n;
+    
+        if(entry->get){
+            for(j = 0; j < size; j ++){
+                err = entry->get(address + n + j, &values[n + j]);
+                if(err != MODBUS_RTU_ERROR_NONE) return err;
+            }
+        }else if(modbus_reg_map_entry_scaled(entry)){
+            const int16_t* data = (const int16_t*)entry->data + offset;
+            int32_t mul = modbus_reg_map_entry_mul(entry);
+            int32_t div = modbus_reg_map_entry_div(entry);
+    
+            for(j = 0; j < size; j ++){
+                values[n + j] = (uint16_t)modbus_reg_map_int16_sat((int32_t)data[j] * mul / div);
+            }
+        }else{
+            memcpy(&values[n], (const uint16_t*)entry->data + offset, size * sizeof(uint16_t));
+        }
+    }
+    
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+/**
+ * Проверяет, что значения всех масштабируемых диапазонов
+ * блока после обратного масштабирования умещаются в int16_t.
+ * @param map Карта регистров.
+ * @param first Индекс первого диапазона блока.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+static modbus_rtu_error_t modbus_reg_map_check_scaled(const modbus_reg_map_t* map, size_t first,
+                                                      uint16_t address, uint16_t count, const uint16_t* values)
+{
+    const modbus_reg_map_entry_t* entry;
+    uint16_t offset;
+    uint16_t size;
+    uint16_t j;
+    uint16_t n = 0;
+    size_t i = first;
+    
+    for(; n < count; i ++, n += size){
+        entry = map->index[i];
+        offset = address + n - entry->address;
+        size = entry->count - offset;
+        if(size > count - n) size = count - n;
+    
+        if(entry->set || !modbus_reg_map_entry_scaled(entry)) continue;
+    
+        int32_t mul = modbus_reg_map_entry_mul(entry);
+        int32_t div = modbus_reg_map_entry_div(entry);
+    
+        for(j = 0; j < size; j ++){
+            if(!modbus_reg_map_int16_valid((int32_t)(int16_t)values[n + j] * div / mul))
+                return MODBUS_RTU_ERROR_INVALID_DATA;
+        }
+    }
+    
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+modbus_rtu_error_t modbus_reg_map_write_regs(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, const uint16_t* values)
+{
+    size_t i;
+    
+    modbus_rtu_error_t err = modbus_reg_map_check(map, type, address, count, MODBUS_REG_MAP_ACCESS_WRITE, &i);
+    if(err != MODBUS_RTU_ERROR_NONE) return err;
+    
+    // Блок записывается только если допустимы значения всех его диапазонов.
+    err = modbus_reg_map_check_scaled(map, i, address, count, values);
+    if(err != MODBUS_RTU_ERROR_NONE) return err;
+    
+    const modbus_reg_map_entry_t* entry;
+    uint16_t offset;
+    uint16_t size;
+    uint16_t j;
+    uint16_t n = 0;
+    
+    for(; n < count; i ++, n += size){
+        entry = map->index[i];
+        offset = address + n - entry->address;
+        size = entry->count - offset;
+        if(size > count - n) size = count - n;
+    
+        if(entry->set){
+            for(j = 0; j < size; j ++){
+                err = entry->set(address + n + j, values[n + j]);
+                if(err != MODBUS_RTU_ERROR_NONE) return err;
+            }
+        }else if(modbus_reg_map_entry_scaled(entry)){
+            int16_t* data = (int16_t*)entry->data + offset;
+            int32_t mul = modbus_reg_map_entry_mul(entry);
+            int32_t div = modbus_reg_map_entry_div(entry);
+    
+            for(j = 0; j < size; j ++){
+                data[j] = (int16_t)((int32_t)(int16_t)values[n + j] * div / mul);
+            }
+        }else{
+            memcpy((uint16_t*)entry->data + offset, &values[n], size * sizeof(uint16_t));
+        }
+    }
+    
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+modbus_rtu_error_t modbus_reg_map_change_reg(const modbus_reg_map_t* map, uint16_t address, uint16_t and_mask, uint16_t or_mask)
+{
+    size_t i;
+    
+    modbus_rtu_error_t err = modbus_reg_map_check(map, MODBUS_RTU_HOLDING_REG, address, 1, MODBUS_REG_MAP_ACCESS_RW, &i);
+    if(err != MODBUS_RTU_ERROR_NONE) return err;
+    
+    uint16_t value;
+    
+    err = modbus_reg_map_read_regs(map, MODBUS_RTU_HOLDING_REG, address, 1, &value);
+    if(err != MODBUS_RTU_ERROR_NONE) return err;
+    
+    value = (value & and_mask) | (or_mask & ~and_mask);
+    
+    return modbus_reg_map_write_regs(map, MODBUS_RTU_HOLDING_REG, address, 1, &value);
+}
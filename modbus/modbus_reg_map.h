@@ -0,0 +1,169 @@
+/**
+ * @file modbus_reg_map.h Карта регистров протокола Modbus RTU.
+ * Карта задаётся константной таблицей диапазонов регистров,
+ * для каждого из которых указывается либо массив значений,
+ * либо функции получения и установки значения регистра,
+ * а также права доступа и масштабирование.
+ * При инициализации по таблице строится упорядоченный индекс,
+ * поиск диапазона выполняется двоичным поиском.
+ */
+
+#ifndef MODBUS_REG_MAP_H
+#define MODBUS_REG_MAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "errors/errors.h"
+#include "defs/defs.h"
+#include "modbus_rtu.h"
+
+
+// Права доступа.
+//! Чтение.
+#define MODBUS_REG_MAP_ACCESS_READ 0x1
+//! Запись.
+#define MODBUS_REG_MAP_ACCESS_WRITE 0x2
+//! Чтение и запись.
+#define MODBUS_REG_MAP_ACCESS_RW (MODBUS_REG_MAP_ACCESS_READ | MODBUS_REG_MAP_ACCESS_WRITE)
+
+//! Тип прав доступа.
+typedef uint8_t modbus_reg_map_access_t;
+
+/**
+ * Тип функции получения значения регистра.
+ * Для флагов и дискретных входов значение - 0 или 1.
+ * @param address Адрес регистра.
+ * @param value Значение регистра.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+typedef modbus_rtu_error_t (*modbus_reg_map_get_t)(uint16_t address, uint16_t* value);
+
+/**
+ * Тип функции установки значения регистра.
+ * Для флагов значение - 0 или 1.
+ * @param address Адрес регистра.
+ * @param value Значение регистра.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+typedef modbus_rtu_error_t (*modbus_reg_map_set_t)(uint16_t address, uint16_t value);
+
+/**
+ * Тип диапазона регистров карты.
+ * Массив значений содержит по элементу на регистр:
+ * uint16_t (int16_t при масштабировании) для регистров,
+ * uint8_t (0 - выключен, иначе - включен) для флагов и входов.
+ * Функции получения и установки значения имеют
+ * приоритет над массивом значений.
+ * Масштабирование применяется к массиву значений регистров:
+ * значение регистра = значение * scale_mul / scale_div,
+ * нулевые множитель и делитель означают отсутствие масштабирования.
+ * При чтении результат ограничивается диапазоном int16_t,
+ * запись значения вне диапазона int16_t отклоняется
+ * с ошибкой MODBUS_RTU_ERROR_INVALID_DATA.
+ */
+typedef struct _Modbus_Reg_Map_Entry {
+    modbus_rtu_data_type_t type; //!< Тип данных.
+    uint16_t address; //!< Адрес первого регистра.
+    uint16_t count; //!< Число регистров.
+    modbus_reg_map_access_t access; //!< Права доступа.
+    void* data; //!< Массив значений.
+    modbus_reg_map_get_t get; //!< Функция получения значения.
+    modbus_reg_map_set_t set; //!< Функция установки значения.
+    int16_t scale_mul; //!< Множитель масштабирования.
+    int16_t scale_div; //!< Делитель масштабирования.
+} modbus_reg_map_entry_t;
+
+//! Объявляет буфер индекса карты регистров.
+#define MODBUS_REG_MAP_INDEX_BUFFER(name, count) const modbus_reg_map_entry_t* name[count]
+
+//! Тип карты регистров.
+typedef struct _Modbus_Reg_Map {
+    const modbus_reg_map_entry_t** index; //!< Диапазоны, упорядоченные по типу и адресу.
+    size_t count; //!< Число диапазонов.
+} modbus_reg_map_t;
+
+
+/**
+ * Инициализирует карту регистров.
+ * Проверяет таблицу диапазонов и строит индекс.
+ * @param map Карта регистров.
+ * @param entries Таблица диапазонов.
+ * @param count Число диапазонов.
+ * @param index Буфер индекса на count элементов.
+ * @return Код ошибки, E_INVALID_VALUE при
+ * пересечении диапазонов либо отсутствии
+ * источника значений для разрешённого доступа.
+ */
+EXTERN err_t modbus_reg_map_init(modbus_reg_map_t* map, const modbus_reg_map_entry_t* entries, size_t count, const modbus_reg_map_entry_t** index);
+
+/**
+ * Ищет диапазон, содержащий регистр.
+ * @param map Карта регистров.
+ * @param type Тип данных.
+ * @param address Адрес регистра.
+ * @return Диапазон, либо NULL.
+ */
+EXTERN const modbus_reg_map_entry_t* modbus_reg_map_find(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address);
+
+/**
+ * Читает блок флагов или дискретных входов.
+ * @param map Карта регистров.
+ * @param type Тип данных.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения, упакованные по 8 в байт,
+ * начиная с младшего бита; буфер должен быть обнулён.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+EXTERN modbus_rtu_error_t modbus_reg_map_read_bits(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, uint8_t* values);
+
+/**
+ * Записывает блок флагов.
+ * @param map Карта регистров.
+ * @param type Тип данных.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения, упакованные по 8 в байт,
+ * начиная с младшего бита.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+EXTERN modbus_rtu_error_t modbus_reg_map_write_bits(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, const uint8_t* values);
+
+/**
+ * Читает блок регистров.
+ * @param map Карта регистров.
+ * @param type Тип данных.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+EXTERN modbus_rtu_error_t modbus_reg_map_read_regs(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, uint16_t* values);
+
+/**
+ * Записывает блок регистров.
+ * Если значение любого масштабируемого диапазона блока
+ * не умещается в int16_t, блок не записывается.
+ * @param map Карта регистров.
+ * @param type Тип данных.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+EXTERN modbus_rtu_error_t modbus_reg_map_write_regs(const modbus_reg_map_t* map, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, const uint16_t* values);
+
+/**
+ * Изменяет регистр хранения по маскам (функция 0x16):
+ * значение = (значение & and_mask) | (or_mask & ~and_mask).
+ * Регистр должен быть доступен для чтения и записи.
+ * @param map Карта регистров.
+ * @param address Адрес регистра.
+ * @param and_mask Маска И.
+ * @param or_mask Маска ИЛИ.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+EXTERN modbus_rtu_error_t modbus_reg_map_change_reg(const modbus_reg_map_t* map, uint16_t address, uint16_t and_mask, uint16_t or_mask);
+
+#endif /* MODBUS_REG_MAP_H */
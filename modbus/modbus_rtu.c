@@ -1,8 +1,17 @@
 #include "modbus_rtu.h"
 #include <string.h>
 #include "utils/net.h"
+#include "utils/critical.h"
+#ifdef USE_MODBUS_RTU_REG_MAP
+#include "modbus_reg_map.h"
+#endif
 
 
+//! Максимальное число читаемых флагов и дискретных входов.
+#define MODBUS_RTU_READ_BITS_MAX 2000
+//! Максимальное число записываемых флагов.
+#define MODBUS_RTU_WRITE_BITS_MAX 1968
+
 
 /*
  * Вычисление CRC взято из мануала http://www.modbus.org/docs/PI_MBUS_300.pdf
@@ -52,21 +61,39 @@ static const uint8_t table_crc_lo[] = {
     0x40
 };
 
-static uint16_t modbus_rtu_calc_crc(const void* data, size_t size)
+//! Начальное значение CRC.
+#define MODBUS_RTU_CRC_INIT 0xffff
+
+/**
+ * Продолжает вычисление CRC.
+ * CRC сообщения вместе с его контрольной
+ * суммой равна нулю для корректного сообщения.
+ * @param crc Текущее значение CRC.
+ * @param data Данные.
+ * @param size Размер данных.
+ * @return Новое значение CRC.
+ */
+static uint16_t modbus_rtu_update_crc(uint16_t crc, const void* data, size_t size)
 {
-    uint8_t crc_hi = 0xff;
-    uint8_t crc_lo = 0xff;
+    uint8_t crc_hi = crc >> 8;
+    uint8_t crc_lo = crc & 0xff;
     
+    const uint8_t* bytes = (const uint8_t*)data;
     size_t index = 0;
     
     for(; size != 0; size --){
-        index = crc_lo ^ *(uint8_t*)data ++;
+        index = crc_lo ^ *bytes ++;
         crc_lo = crc_hi ^ table_crc_hi[index];
         crc_hi = table_crc_lo[index];
     }
     return ((uint16_t)crc_hi << 8) | crc_lo;
 }
 
+static uint16_t modbus_rtu_calc_crc(const void* data, size_t size)
+{
+    return modbus_rtu_update_crc(MODBUS_RTU_CRC_INIT, data, size);
+}
+
 
 
 ALWAYS_INLINE static void modbus_rtu_message_recv_init(modbus_rtu_message_t* msg, modbus_rtu_address_t address)
@@ -92,6 +119,28 @@ ALWAYS_INLINE static void modbus_rtu_message_recv_done(modbus_rtu_message_t* msg
 
 
 
+/**
+ * Инициализирует буферы сообщений для приёма.
+ * @param modbus Протокол Modbus RTU.
+ * @param messages Буферы сообщений.
+ * @param count Число буферов.
+ */
+static void modbus_rtu_init_rx_messages(modbus_rtu_t* modbus, modbus_rtu_message_t* messages, size_t count)
+{
+    modbus->rx_messages = messages;
+    modbus->rx_messages_count = count;
+    modbus->rx_first = 0;
+    modbus->rx_pending = 0;
+    modbus->rx_queue = false;
+    modbus->rx_message = messages;
+    modbus->rx_recv_message = messages;
+    
+    size_t i = 0;
+    for(; i < count; i ++){
+        modbus_rtu_message_reset(&messages[i]);
+    }
+}
+
 err_t modbus_rtu_init(modbus_rtu_t* modbus, modbus_rtu_init_t* modbus_is)
 {
     if(modbus_is->usart == NULL) return E_NULL_POINTER;
@@ -106,15 +155,53 @@ err_t modbus_rtu_init(modbus_rtu_t* modbus, modbus_rtu_init_t* modbus_is)
     modbus->mode = modbus_is->mode;
     modbus->address = modbus_is->address;
     
-    modbus->rx_message = modbus_is->rx_message;
     modbus->tx_message = modbus_is->tx_message;
     
-    modbus_rtu_message_reset(modbus->rx_message);
     modbus_rtu_message_reset(modbus->tx_message);
     
+    modbus_rtu_init_rx_messages(modbus, modbus_is->rx_message, 1);
+    
+    return E_NO_ERROR;
+}
+
+err_t modbus_rtu_set_rx_messages(modbus_rtu_t* modbus, modbus_rtu_message_t* messages, size_t count)
+{
+    if(messages == NULL) return E_NULL_POINTER;
+    if(count == 0) return E_INVALID_VALUE;
+    
+    modbus_rtu_init_rx_messages(modbus, messages, count);
+    
+    modbus->rx_queue = true;
+    
     return E_NO_ERROR;
 }
 
+size_t modbus_rtu_rx_messages_pending(modbus_rtu_t* modbus)
+{
+    return modbus->rx_pending;
+}
+
+void modbus_rtu_rx_message_done(modbus_rtu_t* modbus)
+{
+    CRITICAL_ENTER();
+    
+    if(modbus->rx_pending != 0){
+        modbus->rx_pending --;
+        
+        modbus->rx_first ++;
+        if(modbus->rx_first >= modbus->rx_messages_count) modbus->rx_first = 0;
+        
+        modbus->rx_message = &modbus->rx_messages[modbus->rx_first];
+    }
+    
+    CRITICAL_EXIT();
+}
+
+uint32_t modbus_rtu_rx_overruns(modbus_rtu_t* modbus)
+{
+    return modbus->rx_overruns;
+}
+
 modbus_rtu_address_t modbus_rtu_address(modbus_rtu_t* modbus)
 {
     return modbus->address;
@@ -162,8 +249,29 @@ bool modbus_rtu_usart_rx_byte_callback(modbus_rtu_t* modbus, uint8_t byte)
         return true;
     }
     
-    if(modbus_rtu_message_recv(modbus->rx_message, modbus->usart) == E_NO_ERROR){
-        modbus_rtu_message_recv_init(modbus->rx_message, byte);
+    // Все буферы заняты необработанными сообщениями.
+    if(modbus->rx_pending >= modbus->rx_messages_count){
+        if(modbus->rx_queue){
+            modbus->rx_overruns ++;
+            usart_bus_sleep(modbus->usart);
+            return true;
+        }
+        // Без очереди новое сообщение
+        // замещает принятое ранее.
+        modbus->rx_pending = 0;
+    }
+    
+    size_t index = modbus->rx_first + modbus->rx_pending;
+    if(index >= modbus->rx_messages_count) index -= modbus->rx_messages_count;
+    
+    modbus->rx_recv_message = &modbus->rx_messages[index];
+    
+    if(modbus_rtu_message_recv(modbus->rx_recv_message, modbus->usart) == E_NO_ERROR){
+        modbus_rtu_message_recv_init(modbus->rx_recv_message, byte);
+        
+        modbus->rx_crc = modbus_rtu_update_crc(MODBUS_RTU_CRC_INIT, &byte, 1);
+        modbus->rx_crc_size = 1;
+        modbus->rx_seq ++;
     }else{
         usart_bus_sleep(modbus->usart);
     }
@@ -175,18 +283,67 @@ bool modbus_rtu_usart_rx_callback(modbus_rtu_t* modbus)
 {
     if(usart_bus_rx_errors(modbus->usart) != USART_ERROR_NONE) return true;
     
-    modbus_rtu_message_recv_done(modbus->rx_message, modbus->usart);
+    modbus_rtu_message_recv_done(modbus->rx_recv_message, modbus->usart);
     
-    uint16_t calc_crc = modbus_rtu_calc_crc(&modbus->rx_message->adu, modbus->rx_message->data_size + MODBUS_RTU_FIELDS_SIZE);
-    uint16_t crc = modbus_rtu_message_crc(modbus->rx_message);
+    // Учёт оставшихся байт сообщения, включая CRC.
+    size_t size = usart_bus_bytes_received(modbus->usart) + 1;
     
-    if(crc != calc_crc) return true;
+    if(size < MODBUS_RTU_FIELDS_CRC_SIZE) return true;
+    const uint8_t* adu = (const uint8_t*)&modbus->rx_recv_message->adu;
+    
+    uint16_t crc = modbus_rtu_update_crc(modbus->rx_crc, adu + modbus->rx_crc_size, size - modbus->rx_crc_size);
+    
+    modbus->rx_crc_size = size;
+    
+    if(crc != 0) return true;
+    
+    modbus->rx_pending ++;
     
     if(modbus->recv_callback) modbus->recv_callback();
     
     return true;
 }
 
+void modbus_rtu_usart_rx_progress(modbus_rtu_t* modbus)
+{
+    uint16_t crc;
+    size_t crc_size;
+    size_t size;
+    uint8_t seq;
+    
+    CRITICAL_ENTER();
+    
+    if(!usart_bus_rx_busy(modbus->usart)){
+        CRITICAL_EXIT();
+        return;
+    }
+    
+    crc = modbus->rx_crc;
+    crc_size = modbus->rx_crc_size;
+    seq = modbus->rx_seq;
+    size = usart_bus_rx_position(modbus->usart) + 1;
+    
+    CRITICAL_EXIT();
+    
+    if(size <= crc_size) return;
+    
+    const uint8_t* adu = (const uint8_t*)&modbus->rx_recv_message->adu;
+    
+    crc = modbus_rtu_update_crc(crc, adu + crc_size, size - crc_size);
+    
+    CRITICAL_ENTER();
+    
+    // Приём мог завершиться либо начаться
+    // приём следующего сообщения.
+    if(modbus->rx_seq == seq && modbus->rx_crc_size == crc_size &&
+       usart_bus_rx_busy(modbus->usart)){
+        modbus->rx_crc = crc;
+        modbus->rx_crc_size = size;
+    }
+    
+    CRITICAL_EXIT();
+}
+
 bool modbus_rtu_usart_tx_callback(modbus_rtu_t* modbus)
 {
     usart_bus_receiver_enable(modbus->usart);
@@ -378,6 +535,66 @@ void modbus_rtu_set_write_holding_reg_callback(modbus_rtu_t* modbus, modbus_rtu_
     modbus->write_holding_reg_callback = callback;
 }
 
+modbus_rtu_read_coils_callback_t modbus_rtu_read_coils_callback(modbus_rtu_t* modbus)
+{
+    return modbus->read_coils_callback;
+}
+
+void modbus_rtu_set_read_coils_callback(modbus_rtu_t* modbus, modbus_rtu_read_coils_callback_t callback)
+{
+    modbus->read_coils_callback = callback;
+}
+
+modbus_rtu_read_dins_callback_t modbus_rtu_read_dins_callback(modbus_rtu_t* modbus)
+{
+    return modbus->read_dins_callback;
+}
+
+void modbus_rtu_set_read_dins_callback(modbus_rtu_t* modbus, modbus_rtu_read_dins_callback_t callback)
+{
+    modbus->read_dins_callback = callback;
+}
+
+modbus_rtu_read_holding_regs_callback_t modbus_rtu_read_holding_regs_callback(modbus_rtu_t* modbus)
+{
+    return modbus->read_holding_regs_callback;
+}
+
+void modbus_rtu_set_read_holding_regs_callback(modbus_rtu_t* modbus, modbus_rtu_read_holding_regs_callback_t callback)
+{
+    modbus->read_holding_regs_callback = callback;
+}
+
+modbus_rtu_read_input_regs_callback_t modbus_rtu_read_input_regs_callback(modbus_rtu_t* modbus)
+{
+    return modbus->read_input_regs_callback;
+}
+
+void modbus_rtu_set_read_input_regs_callback(modbus_rtu_t* modbus, modbus_rtu_read_input_regs_callback_t callback)
+{
+    modbus->read_input_regs_callback = callback;
+}
+
+modbus_rtu_write_coils_callback_t modbus_rtu_write_coils_callback(modbus_rtu_t* modbus)
+{
+    return modbus->write_coils_callback;
+}
+
+void modbus_rtu_set_write_coils_callback(modbus_rtu_t* modbus, modbus_rtu_write_coils_callback_t callback)
+{
+    modbus->write_coils_callback = callback;
+}
+
+modbus_rtu_write_holding_regs_callback_t modbus_rtu_write_holding_regs_callback(modbus_rtu_t* modbus)
+{
+    return modbus->write_holding_regs_callback;
+}
+
+void modbus_rtu_set_write_holding_regs_callback(modbus_rtu_t* modbus, modbus_rtu_write_holding_regs_callback_t callback)
+{
+    modbus->write_holding_regs_callback = callback;
+}
+
 modbus_rtu_change_holding_reg_callback_t modbus_rtu_change_holding_reg_callback(modbus_rtu_t* modbus)
 {
     return modbus->change_holding_reg_callback;
@@ -428,6 +645,20 @@ void modbus_rtu_set_custom_function_callback(modbus_rtu_t* modbus, modbus_rtu_cu
     modbus->custom_function_callback = callback;
 }
 
+#ifdef USE_MODBUS_RTU_REG_MAP
+
+struct _Modbus_Reg_Map* modbus_rtu_reg_map(modbus_rtu_t* modbus)
+{
+    return modbus->reg_map;
+}
+
+void modbus_rtu_set_reg_map(modbus_rtu_t* modbus, struct _Modbus_Reg_Map* reg_map)
+{
+    modbus->reg_map = reg_map;
+}
+
+#endif
+
 static err_t modbus_rtu_disp_fail(modbus_rtu_t* modbus, modbus_rtu_error_t error)
 {
     if(modbus_rtu_message_address(modbus->rx_message) == MODBUS_RTU_ADDRESS_BROADCAST &&
@@ -455,105 +686,288 @@ static err_t modbus_rtu_disp_succ(modbus_rtu_t* modbus, size_t data_size)
     return modbus_rtu_send_message(modbus);
 }
 
-static err_t modbus_rtu_disp_read_coils(modbus_rtu_t* modbus)
+/**
+ * Проверяет нахождение блока регистров
+ * в адресном пространстве протокола Modbus RTU.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @return Флаг допустимости блока регистров.
+ */
+ALWAYS_INLINE static bool modbus_rtu_block_valid(uint16_t address, uint16_t count)
 {
-    if(modbus->read_coil_callback == NULL)
-        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
+    return (uint32_t)address + count <= 0x10000;
+}
+
+/**
+ * Получает флаг наличия карты регистров.
+ * @param modbus Протокол Modbus RTU.
+ * @return Флаг наличия карты регистров.
+ */
+ALWAYS_INLINE static bool modbus_rtu_has_reg_map(modbus_rtu_t* modbus)
+{
+#ifdef USE_MODBUS_RTU_REG_MAP
+    return modbus->reg_map != NULL;
+#else
+    (void)modbus;
+    return false;
+#endif
+}
+
+/**
+ * Получает флаг возможности чтения флагов или дискретных входов.
+ * @param modbus Протокол Modbus RTU.
+ * @param type Тип данных.
+ * @return Флаг возможности чтения.
+ */
+static bool modbus_rtu_can_read_bits(modbus_rtu_t* modbus, modbus_rtu_data_type_t type)
+{
+    if(modbus_rtu_has_reg_map(modbus)) return true;
     
-    if(modbus_rtu_message_data_size(modbus->rx_message) != sizeof(uint16_t) * 2)
-        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
+    if(type == MODBUS_RTU_COIL){
+        return modbus->read_coils_callback != NULL || modbus->read_coil_callback != NULL;
+    }
+    return modbus->read_dins_callback != NULL || modbus->read_din_callback != NULL;
+}
+
+/**
+ * Читает блок флагов или дискретных входов
+ * из карты регистров, блочным каллбэком,
+ * либо каллбэком отдельного регистра.
+ * @param modbus Протокол Modbus RTU.
+ * @param type Тип данных.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Обнулённый буфер упакованных значений.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+static modbus_rtu_error_t modbus_rtu_read_bits(modbus_rtu_t* modbus, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, uint8_t* values)
+{
+#ifdef USE_MODBUS_RTU_REG_MAP
+    if(modbus->reg_map) return modbus_reg_map_read_bits(modbus->reg_map, type, address, count, values);
+#endif
+    
+    if(type == MODBUS_RTU_COIL && modbus->read_coils_callback){
+        return modbus->read_coils_callback(address, count, values);
+    }
+    if(type == MODBUS_RTU_DISCR_INPUT && modbus->read_dins_callback){
+        return modbus->read_dins_callback(address, count, values);
+    }
     
     modbus_rtu_error_t modbus_err = MODBUS_RTU_ERROR_NONE;
+    modbus_rtu_coil_value_t coil_value = MODBUS_RTU_COIL_OFF;
+    modbus_rtu_din_value_t din_value = MODBUS_RTU_DIN_OFF;
+    bool value;
     
-    uint16_t* rx_data = (uint16_t*)modbus_rtu_message_data(modbus->rx_message);
-    uint8_t* tx_data = modbus_rtu_message_data(modbus->tx_message);
+    uint16_t i = 0;
+    for(; i < count; i ++){
+        if(type == MODBUS_RTU_COIL){
+            modbus_err = modbus->read_coil_callback(address, &coil_value);
+            value = coil_value != MODBUS_RTU_COIL_OFF;
+        }else{
+            modbus_err = modbus->read_din_callback(address, &din_value);
+            value = din_value != MODBUS_RTU_DIN_OFF;
+        }
     
-    uint16_t address = ntohs(rx_data[0]);
-    uint16_t count = ntohs(rx_data[1]);
+        if(modbus_err != MODBUS_RTU_ERROR_NONE) return modbus_err;
     
-    if(count > (MODBUS_RTU_DATA_SIZE_MAX - 1) * 8)
-        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
+        if(value){
+            values[i >> 3] |= (1 << (i & 0x7));
+        }
+        address ++;
+    }
     
-    modbus_rtu_coil_value_t value;
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+/**
+ * Получает флаг возможности записи флагов.
+ * @param modbus Протокол Modbus RTU.
+ * @return Флаг возможности записи.
+ */
+static bool modbus_rtu_can_write_coils(modbus_rtu_t* modbus)
+{
+    if(modbus_rtu_has_reg_map(modbus)) return true;
     
-    uint8_t byte_index = 1;
-    uint8_t bit_index = 0;
+    return modbus->write_coils_callback != NULL || modbus->write_coil_callback != NULL;
+}
+
+/**
+ * Записывает блок флагов.
+ * @param modbus Протокол Modbus RTU.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Упакованные значения.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+static modbus_rtu_error_t modbus_rtu_write_coils(modbus_rtu_t* modbus, uint16_t address, uint16_t count, const uint8_t* values)
+{
+#ifdef USE_MODBUS_RTU_REG_MAP
+    if(modbus->reg_map) return modbus_reg_map_write_bits(modbus->reg_map, MODBUS_RTU_COIL, address, count, values);
+#endif
     
-    tx_data[byte_index] = 0;
+    if(modbus->write_coils_callback){
+        return modbus->write_coils_callback(address, count, values);
+    }
+    
+    modbus_rtu_error_t modbus_err = MODBUS_RTU_ERROR_NONE;
+    modbus_rtu_coil_value_t value;
     
     uint16_t i = 0;
     for(; i < count; i ++){
-        modbus_err = modbus->read_coil_callback(address, &value);
-        
-        if(modbus_err != MODBUS_RTU_ERROR_NONE)
-            return modbus_rtu_disp_fail(modbus, modbus_err);
-        
-        if(value){
-            tx_data[byte_index] |= (1 << bit_index);
-        }
-        if(++ bit_index >= 8){
-            bit_index = 0;
-            tx_data[++ byte_index] = 0;
+    
+        if(values[i >> 3] & (1 << (i & 0x7))){
+            value = MODBUS_RTU_COIL_ON;
+        }else{
+            value = MODBUS_RTU_COIL_OFF;
         }
+    
+        modbus_err = modbus->write_coil_callback(address, value);
+    
+        if(modbus_err != MODBUS_RTU_ERROR_NONE) return modbus_err;
+    
         address ++;
     }
     
-    tx_data[0] = (byte_index - 1) + (count > 0);
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+/**
+ * Получает флаг возможности чтения регистров.
+ * @param modbus Протокол Modbus RTU.
+ * @param type Тип данных.
+ * @return Флаг возможности чтения.
+ */
+static bool modbus_rtu_can_read_regs(modbus_rtu_t* modbus, modbus_rtu_data_type_t type)
+{
+    if(modbus_rtu_has_reg_map(modbus)) return true;
     
-    return modbus_rtu_disp_succ(modbus, tx_data[0] + 1);
+    if(type == MODBUS_RTU_HOLDING_REG){
+        return modbus->read_holding_regs_callback != NULL || modbus->read_holding_reg_callback != NULL;
+    }
+    return modbus->read_input_regs_callback != NULL || modbus->read_input_reg_callback != NULL;
 }
 
-static err_t modbus_rtu_disp_read_dins(modbus_rtu_t* modbus)
+/**
+ * Читает блок регистров хранения или ввода.
+ * @param modbus Протокол Modbus RTU.
+ * @param type Тип данных.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+static modbus_rtu_error_t modbus_rtu_read_regs(modbus_rtu_t* modbus, modbus_rtu_data_type_t type, uint16_t address, uint16_t count, uint16_t* values)
 {
-    if(modbus->read_din_callback == NULL)
-        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
+#ifdef USE_MODBUS_RTU_REG_MAP
+    if(modbus->reg_map) return modbus_reg_map_read_regs(modbus->reg_map, type, address, count, values);
+#endif
     
-    if(modbus_rtu_message_data_size(modbus->rx_message) != sizeof(uint16_t) * 2)
-        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
+    if(type == MODBUS_RTU_HOLDING_REG && modbus->read_holding_regs_callback){
+        return modbus->read_holding_regs_callback(address, count, values);
+    }
+    if(type == MODBUS_RTU_INPUT_REG && modbus->read_input_regs_callback){
+        return modbus->read_input_regs_callback(address, count, values);
+    }
     
     modbus_rtu_error_t modbus_err = MODBUS_RTU_ERROR_NONE;
+    uint16_t value;
     
-    uint16_t* rx_data = (uint16_t*)modbus_rtu_message_data(modbus->rx_message);
-    uint8_t* tx_data = modbus_rtu_message_data(modbus->tx_message);
+    uint16_t i = 0;
+    for(; i < count; i ++){
+        if(type == MODBUS_RTU_HOLDING_REG){
+            modbus_err = modbus->read_holding_reg_callback(address, &value);
+        }else{
+            modbus_err = modbus->read_input_reg_callback(address, &value);
+        }
     
-    uint16_t address = ntohs(rx_data[0]);
-    uint16_t count = ntohs(rx_data[1]);
+        if(modbus_err != MODBUS_RTU_ERROR_NONE) return modbus_err;
     
-    if(count > (MODBUS_RTU_DATA_SIZE_MAX - 1) * 8)
-        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
+        values[i] = value;
+        address ++;
+    }
+    
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+/**
+ * Получает флаг возможности записи регистров хранения.
+ * @param modbus Протокол Modbus RTU.
+ * @return Флаг возможности записи.
+ */
+static bool modbus_rtu_can_write_regs(modbus_rtu_t* modbus)
+{
+    if(modbus_rtu_has_reg_map(modbus)) return true;
     
-    modbus_rtu_din_value_t value;
+    return modbus->write_holding_regs_callback != NULL || modbus->write_holding_reg_callback != NULL;
+}
+
+/**
+ * Записывает блок регистров хранения.
+ * @param modbus Протокол Modbus RTU.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+static modbus_rtu_error_t modbus_rtu_write_regs(modbus_rtu_t* modbus, uint16_t address, uint16_t count, const uint16_t* values)
+{
+#ifdef USE_MODBUS_RTU_REG_MAP
+    if(modbus->reg_map) return modbus_reg_map_write_regs(modbus->reg_map, MODBUS_RTU_HOLDING_REG, address, count, values);
+#endif
     
-    uint8_t byte_index = 1;
-    uint8_t bit_index = 0;
+    if(modbus->write_holding_regs_callback){
+        return modbus->write_holding_regs_callback(address, count, values);
+    }
     
-    tx_data[byte_index] = 0;
+    modbus_rtu_error_t modbus_err = MODBUS_RTU_ERROR_NONE;
     
     uint16_t i = 0;
     for(; i < count; i ++){
-        modbus_err = modbus->read_din_callback(address, &value);
-        
-        if(modbus_err != MODBUS_RTU_ERROR_NONE)
-            return modbus_rtu_disp_fail(modbus, modbus_err);
-        
-        if(value){
-            tx_data[byte_index] |= (1 << bit_index);
-        }
-        if(++ bit_index >= 8){
-            bit_index = 0;
-            tx_data[++ byte_index] = 0;
-        }
+    
+        modbus_err = modbus->write_holding_reg_callback(address, values[i]);
+    
+        if(modbus_err != MODBUS_RTU_ERROR_NONE) return modbus_err;
+    
         address ++;
     }
     
-    tx_data[0] = (byte_index - 1) + (count > 0);
+    return MODBUS_RTU_ERROR_NONE;
+}
+
+/**
+ * Получает флаг возможности изменения регистра хранения по маскам.
+ * @param modbus Протокол Modbus RTU.
+ * @return Флаг возможности изменения.
+ */
+static bool modbus_rtu_can_change_reg(modbus_rtu_t* modbus)
+{
+    if(modbus_rtu_has_reg_map(modbus)) return true;
     
-    return modbus_rtu_disp_succ(modbus, tx_data[0] + 1);
+    return modbus->change_holding_reg_callback != NULL;
+}
+
+/**
+ * Изменяет регистр хранения по маскам.
+ * При наличии карты регистров выполняется
+ * чтение, изменение и запись регистра карты.
+ * @param modbus Протокол Modbus RTU.
+ * @param address Адрес регистра.
+ * @param and_mask Маска И.
+ * @param or_mask Маска ИЛИ.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+static modbus_rtu_error_t modbus_rtu_change_reg(modbus_rtu_t* modbus, uint16_t address, uint16_t and_mask, uint16_t or_mask)
+{
+#ifdef USE_MODBUS_RTU_REG_MAP
+    if(modbus->reg_map) return modbus_reg_map_change_reg(modbus->reg_map, address, and_mask, or_mask);
+#endif
+    
+    return modbus->change_holding_reg_callback(address, and_mask, or_mask);
 }
 
-static err_t modbus_rtu_disp_read_holding_regs(modbus_rtu_t* modbus)
+static err_t modbus_rtu_disp_read_bits(modbus_rtu_t* modbus, modbus_rtu_data_type_t type)
 {
-    if(modbus->read_holding_reg_callback == NULL)
+    if(!modbus_rtu_can_read_bits(modbus, type))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
     
     if(modbus_rtu_message_data_size(modbus->rx_message) != sizeof(uint16_t) * 2)
@@ -567,32 +981,30 @@ static err_t modbus_rtu_disp_read_holding_regs(modbus_rtu_t* modbus)
     uint16_t address = ntohs(rx_data[0]);
     uint16_t count = ntohs(rx_data[1]);
     
-    if(count > (MODBUS_RTU_DATA_SIZE_MAX - 1) / 2)
+    if(count == 0 || count > MODBUS_RTU_READ_BITS_MAX)
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
     
-    uint16_t value;
+    if(!modbus_rtu_block_valid(address, count))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_ADDRESS);
     
-    uint16_t* regs_values = (uint16_t*)(tx_data + 1);
+    uint8_t bytes_count = (count + 7) / 8;
+    uint8_t* bits_values = tx_data + 1;
     
-    uint16_t i = 0;
-    for(; i < count; i ++){
-        modbus_err = modbus->read_holding_reg_callback(address, &value);
-        
-        if(modbus_err != MODBUS_RTU_ERROR_NONE)
-            return modbus_rtu_disp_fail(modbus, modbus_err);
-        
-        regs_values[i] = htons(value);
-        address ++;
-    }
+    memset(bits_values, 0x0, bytes_count);
     
-    tx_data[0] = count * 2;
+    modbus_err = modbus_rtu_read_bits(modbus, type, address, count, bits_values);
+    
+    if(modbus_err != MODBUS_RTU_ERROR_NONE)
+        return modbus_rtu_disp_fail(modbus, modbus_err);
+    
+    tx_data[0] = bytes_count;
     
     return modbus_rtu_disp_succ(modbus, tx_data[0] + 1);
 }
 
-static err_t modbus_rtu_disp_read_input_regs(modbus_rtu_t* modbus)
+static err_t modbus_rtu_disp_read_regs(modbus_rtu_t* modbus, modbus_rtu_data_type_t type)
 {
-    if(modbus->read_input_reg_callback == NULL)
+    if(!modbus_rtu_can_read_regs(modbus, type))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
     
     if(modbus_rtu_message_data_size(modbus->rx_message) != sizeof(uint16_t) * 2)
@@ -606,22 +1018,23 @@ static err_t modbus_rtu_disp_read_input_regs(modbus_rtu_t* modbus)
     uint16_t address = ntohs(rx_data[0]);
     uint16_t count = ntohs(rx_data[1]);
     
-    if(count > (MODBUS_RTU_DATA_SIZE_MAX - 1) / 2)
+    if(count == 0 || count > (MODBUS_RTU_DATA_SIZE_MAX - 1) / 2)
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
     
-    uint16_t value;
+    if(!modbus_rtu_block_valid(address, count))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_ADDRESS);
     
     uint16_t* regs_values = (uint16_t*)(tx_data + 1);
     
+    modbus_err = modbus_rtu_read_regs(modbus, type, address, count, regs_values);
+    
+    if(modbus_err != MODBUS_RTU_ERROR_NONE)
+        return modbus_rtu_disp_fail(modbus, modbus_err);
+    
+    // host to network order.
     uint16_t i = 0;
     for(; i < count; i ++){
-        modbus_err = modbus->read_input_reg_callback(address, &value);
-        
-        if(modbus_err != MODBUS_RTU_ERROR_NONE)
-            return modbus_rtu_disp_fail(modbus, modbus_err);
-        
-        regs_values[i] = htons(value);
-        address ++;
+        regs_values[i] = htons(regs_values[i]);
     }
     
     tx_data[0] = count * 2;
@@ -631,7 +1044,7 @@ static err_t modbus_rtu_disp_read_input_regs(modbus_rtu_t* modbus)
 
 static err_t modbus_rtu_disp_write_coil(modbus_rtu_t* modbus)
 {
-    if(modbus->write_coil_callback == NULL)
+    if(!modbus_rtu_can_write_coils(modbus))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
     
     if(modbus_rtu_message_data_size(modbus->rx_message) != sizeof(uint16_t) * 2)
@@ -644,13 +1057,14 @@ static err_t modbus_rtu_disp_write_coil(modbus_rtu_t* modbus)
     
     uint16_t address = ntohs(rx_data[0]);
     uint16_t value = ntohs(rx_data[1]);
-
+    
     if(value != 0 && value != 0xff00)
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
     
-    modbus_err = modbus->write_coil_callback(address,
-                            value ? MODBUS_RTU_COIL_ON : MODBUS_RTU_COIL_OFF);
-
+    uint8_t coil_value = value ? 0x1 : 0x0;
+    
+    modbus_err = modbus_rtu_write_coils(modbus, address, 1, &coil_value);
+    
     if(modbus_err != MODBUS_RTU_ERROR_NONE)
         return modbus_rtu_disp_fail(modbus, modbus_err);
     
@@ -662,7 +1076,7 @@ static err_t modbus_rtu_disp_write_coil(modbus_rtu_t* modbus)
 
 static err_t modbus_rtu_disp_write_reg(modbus_rtu_t* modbus)
 {
-    if(modbus->write_holding_reg_callback == NULL)
+    if(!modbus_rtu_can_write_regs(modbus))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
     
     if(modbus_rtu_message_data_size(modbus->rx_message) != sizeof(uint16_t) * 2)
@@ -675,9 +1089,9 @@ static err_t modbus_rtu_disp_write_reg(modbus_rtu_t* modbus)
     
     uint16_t address = ntohs(rx_data[0]);
     uint16_t value = ntohs(rx_data[1]);
-
-    modbus_err = modbus->write_holding_reg_callback(address, value);
-
+    
+    modbus_err = modbus_rtu_write_regs(modbus, address, 1, &value);
+    
     if(modbus_err != MODBUS_RTU_ERROR_NONE)
         return modbus_rtu_disp_fail(modbus, modbus_err);
     
@@ -689,7 +1103,7 @@ static err_t modbus_rtu_disp_write_reg(modbus_rtu_t* modbus)
 
 static err_t modbus_rtu_disp_write_coils(modbus_rtu_t* modbus)
 {
-    if(modbus->write_coil_callback == NULL)
+    if(!modbus_rtu_can_write_coils(modbus))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
     
     const size_t header_size = (sizeof(uint16_t) * 2 + 1);
@@ -706,36 +1120,19 @@ static err_t modbus_rtu_disp_write_coils(modbus_rtu_t* modbus)
     uint16_t count = ntohs(rx_data[1]);
     uint8_t bytes_count = *((uint8_t*)&rx_data[2]);
     
-    if((count > (MODBUS_RTU_DATA_SIZE_MAX - header_size) * 8) || (count > bytes_count * 8))
+    if((count == 0) || (count > MODBUS_RTU_WRITE_BITS_MAX) || (count > bytes_count * 8) ||
+       (header_size + bytes_count > modbus_rtu_message_data_size(modbus->rx_message)))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
     
-    uint8_t* coils_values = modbus_rtu_message_data(modbus->rx_message) + header_size;
+    if(!modbus_rtu_block_valid(address, count))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_ADDRESS);
     
-    uint8_t byte_index = 0;
-    uint8_t bit_index = 0;
+    uint8_t* coils_values = modbus_rtu_message_data(modbus->rx_message) + header_size;
     
-    modbus_rtu_coil_value_t value;
+    modbus_err = modbus_rtu_write_coils(modbus, address, count, coils_values);
     
-    uint16_t i = 0;
-    for(; i < count; i ++){
-        
-        if(coils_values[byte_index] & (1 << bit_index)){
-            value = MODBUS_RTU_COIL_ON;
-        }else{
-            value = MODBUS_RTU_COIL_OFF;
-        }
-        
-        modbus_err = modbus->write_coil_callback(address, value);
-        
-        if(modbus_err != MODBUS_RTU_ERROR_NONE)
-            return modbus_rtu_disp_fail(modbus, modbus_err);
-        
-        if(++ bit_index >= 8){
-            bit_index = 0;
-            byte_index ++;
-        }
-        address ++;
-    }
+    if(modbus_err != MODBUS_RTU_ERROR_NONE)
+        return modbus_rtu_disp_fail(modbus, modbus_err);
     
     tx_data[0] = rx_data[0];
     tx_data[1] = rx_data[1];
@@ -745,7 +1142,7 @@ static err_t modbus_rtu_disp_write_coils(modbus_rtu_t* modbus)
 
 static err_t modbus_rtu_disp_write_regs(modbus_rtu_t* modbus)
 {
-    if(modbus->write_holding_reg_callback == NULL)
+    if(!modbus_rtu_can_write_regs(modbus))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
     
     const size_t header_size = (sizeof(uint16_t) * 2 + 1);
@@ -762,22 +1159,26 @@ static err_t modbus_rtu_disp_write_regs(modbus_rtu_t* modbus)
     uint16_t count = ntohs(rx_data[1]);
     uint8_t bytes_count = *((uint8_t*)&rx_data[2]);
     
-    if((count > (MODBUS_RTU_DATA_SIZE_MAX - header_size) / 2) || (count > bytes_count / 2))
+    if((count == 0) || (count > (MODBUS_RTU_DATA_SIZE_MAX - header_size) / 2) || (count > bytes_count / 2) ||
+       (header_size + bytes_count > modbus_rtu_message_data_size(modbus->rx_message)))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
     
+    if(!modbus_rtu_block_valid(address, count))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_ADDRESS);
+    
     uint16_t* regs_values = (uint16_t*)(modbus_rtu_message_data(modbus->rx_message) + header_size);
     
+    // network to host order.
     uint16_t i = 0;
     for(; i < count; i ++){
-        
-        modbus_err = modbus->write_holding_reg_callback(address, ntohs(regs_values[i]));
-        
-        if(modbus_err != MODBUS_RTU_ERROR_NONE)
-            return modbus_rtu_disp_fail(modbus, modbus_err);
-        
-        address ++;
+        regs_values[i] = ntohs(regs_values[i]);
     }
     
+    modbus_err = modbus_rtu_write_regs(modbus, address, count, regs_values);
+    
+    if(modbus_err != MODBUS_RTU_ERROR_NONE)
+        return modbus_rtu_disp_fail(modbus, modbus_err);
+    
     tx_data[0] = rx_data[0];
     tx_data[1] = rx_data[1];
     
@@ -786,7 +1187,7 @@ static err_t modbus_rtu_disp_write_regs(modbus_rtu_t* modbus)
 
 static err_t modbus_rtu_disp_change_reg(modbus_rtu_t* modbus)
 {
-    if(modbus->change_holding_reg_callback == NULL)
+    if(!modbus_rtu_can_change_reg(modbus))
         return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
     
     if(modbus_rtu_message_data_size(modbus->rx_message) != sizeof(uint16_t) * 3)
@@ -801,7 +1202,7 @@ static err_t modbus_rtu_disp_change_reg(modbus_rtu_t* modbus)
     uint16_t and_mask = ntohs(rx_data[1]);
     uint16_t or_mask = ntohs(rx_data[2]);
 
-    modbus_err = modbus->change_holding_reg_callback(address, and_mask, or_mask);
+    modbus_err = modbus_rtu_change_reg(modbus, address, and_mask, or_mask);
 
     if(modbus_err != MODBUS_RTU_ERROR_NONE)
         return modbus_rtu_disp_fail(modbus, modbus_err);
@@ -813,6 +1214,68 @@ static err_t modbus_rtu_disp_change_reg(modbus_rtu_t* modbus)
     return modbus_rtu_disp_succ(modbus, modbus_rtu_message_data_size(modbus->rx_message));
 }
 
+static err_t modbus_rtu_disp_read_write_regs(modbus_rtu_t* modbus)
+{
+    if(!modbus_rtu_can_write_regs(modbus) || !modbus_rtu_can_read_regs(modbus, MODBUS_RTU_HOLDING_REG))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_FUNC);
+    
+    const size_t header_size = (sizeof(uint16_t) * 4 + 1);
+    
+    if(modbus_rtu_message_data_size(modbus->rx_message) < header_size)
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
+    
+    modbus_rtu_error_t modbus_err = MODBUS_RTU_ERROR_NONE;
+    
+    uint16_t* rx_data = (uint16_t*)modbus_rtu_message_data(modbus->rx_message);
+    uint8_t* tx_data = modbus_rtu_message_data(modbus->tx_message);
+    
+    uint16_t read_address = ntohs(rx_data[0]);
+    uint16_t read_count = ntohs(rx_data[1]);
+    uint16_t write_address = ntohs(rx_data[2]);
+    uint16_t write_count = ntohs(rx_data[3]);
+    uint8_t bytes_count = *((uint8_t*)&rx_data[4]);
+    
+    if((read_count == 0) || (write_count == 0) ||
+       (read_count > (MODBUS_RTU_DATA_SIZE_MAX - 1) / 2) ||
+       (write_count > (MODBUS_RTU_DATA_SIZE_MAX - header_size) / 2) ||
+       (write_count > bytes_count / 2) ||
+       (header_size + bytes_count > modbus_rtu_message_data_size(modbus->rx_message)))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
+    
+    if(!modbus_rtu_block_valid(read_address, read_count) ||
+       !modbus_rtu_block_valid(write_address, write_count))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_ADDRESS);
+    
+    uint16_t* write_values = (uint16_t*)(modbus_rtu_message_data(modbus->rx_message) + header_size);
+    uint16_t* read_values = (uint16_t*)(tx_data + 1);
+    
+    // network to host order.
+    uint16_t i = 0;
+    for(; i < write_count; i ++){
+        write_values[i] = ntohs(write_values[i]);
+    }
+    
+    // Запись выполняется перед чтением.
+    modbus_err = modbus_rtu_write_regs(modbus, write_address, write_count, write_values);
+    
+    if(modbus_err != MODBUS_RTU_ERROR_NONE)
+        return modbus_rtu_disp_fail(modbus, modbus_err);
+    
+    modbus_err = modbus_rtu_read_regs(modbus, MODBUS_RTU_HOLDING_REG, read_address, read_count, read_values);
+    
+    if(modbus_err != MODBUS_RTU_ERROR_NONE)
+        return modbus_rtu_disp_fail(modbus, modbus_err);
+    
+    // host to network order.
+    for(i = 0; i < read_count; i ++){
+        read_values[i] = htons(read_values[i]);
+    }
+    
+    tx_data[0] = read_count * 2;
+    
+    return modbus_rtu_disp_succ(modbus, tx_data[0] + 1);
+}
+
 static err_t modbus_rtu_disp_report_slave_id(modbus_rtu_t* modbus)
 {
     if(modbus->report_slave_id_callback == NULL)
@@ -873,7 +1336,9 @@ static err_t modbus_rtu_disp_read_file_record(modbus_rtu_t* modbus)
     uint8_t* tx_data = (uint8_t*)modbus_rtu_message_data(modbus->tx_message);
     
     uint8_t byte_count = rx_data[0];
-    if(byte_count < 0x7 || byte_count > 0xf5) return MODBUS_RTU_ERROR_INVALID_DATA;
+    if(byte_count < 0x7 || byte_count > 0xf5 ||
+       (size_t)byte_count + 1 != modbus_rtu_message_data_size(modbus->rx_message))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
     
     modbus_rtu_error_t modbus_err = MODBUS_RTU_ERROR_NONE;
     
@@ -887,7 +1352,7 @@ static err_t modbus_rtu_disp_read_file_record(modbus_rtu_t* modbus)
     uint16_t record = 0;
     uint16_t length = 0;
     
-    uint8_t resp_size = 0;
+    size_t resp_size = 0;
     uint16_t index = 0;
     
     uint16_t* response_data = NULL;
@@ -912,14 +1377,20 @@ static err_t modbus_rtu_disp_read_file_record(modbus_rtu_t* modbus)
             break;
         }
         
+        response_cur_data_size = length * 2;
+        response_cur_size = response_cur_data_size + sizeof(modbus_rtu_read_file_record_response_t);
+        
+        // Ответ должен уместиться в сообщение.
+        if(resp_size + response_cur_size > MODBUS_RTU_DATA_SIZE_MAX - 1){
+            modbus_err = MODBUS_RTU_ERROR_INVALID_DATA;
+            break;
+        }
+        
         response_data = (uint16_t*)(response_buffer + sizeof(modbus_rtu_read_file_record_response_t));
         
         modbus_err = modbus->read_file_record_callback(file, record, length, response_data);
         if(modbus_err != MODBUS_RTU_ERROR_NONE) break;
         
-        response_cur_data_size = length * 2;
-        response_cur_size = response_cur_data_size + sizeof(modbus_rtu_read_file_record_response_t);
-        
         response->data_length = response_cur_data_size + 1;
         response->reference_type = 0x6;
         
@@ -957,7 +1428,9 @@ static err_t modbus_rtu_disp_write_file_record(modbus_rtu_t* modbus)
     uint8_t* tx_data = (uint8_t*)modbus_rtu_message_data(modbus->tx_message);
     
     uint8_t byte_count = rx_data[0];
-    if(byte_count < 0x9 || byte_count > 0xfb) return MODBUS_RTU_ERROR_INVALID_DATA;
+    if(byte_count < 0x9 || byte_count > 0xfb ||
+       (size_t)byte_count + 1 != modbus_rtu_message_data_size(modbus->rx_message))
+        return modbus_rtu_disp_fail(modbus, MODBUS_RTU_ERROR_INVALID_DATA);
     
     modbus_rtu_error_t modbus_err = MODBUS_RTU_ERROR_NONE;
     
@@ -987,6 +1460,14 @@ static err_t modbus_rtu_disp_write_file_record(modbus_rtu_t* modbus)
             break;
         }
         
+        request_size = sizeof(modbus_rtu_file_record_request_t) + length * 2;
+        
+        // Данные записи должны уместиться в запросе.
+        if(request_size > byte_count){
+            modbus_err = MODBUS_RTU_ERROR_INVALID_DATA;
+            break;
+        }
+        
         request_data = (uint16_t*)((uint8_t*)request + sizeof(modbus_rtu_file_record_request_t));
         
         // network to host order.
@@ -997,8 +1478,6 @@ static err_t modbus_rtu_disp_write_file_record(modbus_rtu_t* modbus)
         modbus_err = modbus->write_file_record_callback(file, record, length, request_data);
         if(modbus_err != MODBUS_RTU_ERROR_NONE) break;
         
-        request_size = sizeof(modbus_rtu_file_record_request_t) + length * 2;
-        
         memcpy(response, request, request_size);
         
         byte_count -= request_size;
@@ -1045,19 +1524,19 @@ static err_t modbus_rtu_disp_custom(modbus_rtu_t* modbus)
 }
 
 
-err_t modbus_rtu_dispatch(modbus_rtu_t* modbus)
+static err_t modbus_rtu_dispatch_message(modbus_rtu_t* modbus)
 {
     switch(modbus->rx_message->adu.func){
         default:
             return modbus_rtu_disp_custom(modbus);
         case MODBUS_RTU_FUNC_READ_COILS_STATUS:
-            return modbus_rtu_disp_read_coils(modbus);
+            return modbus_rtu_disp_read_bits(modbus, MODBUS_RTU_COIL);
         case MODBUS_RTU_FUNC_READ_DISCR_INPUTS:
-            return modbus_rtu_disp_read_dins(modbus);
+            return modbus_rtu_disp_read_bits(modbus, MODBUS_RTU_DISCR_INPUT);
         case MODBUS_RTU_FUNC_READ_HOLDING_REGS:
-            return modbus_rtu_disp_read_holding_regs(modbus);
+            return modbus_rtu_disp_read_regs(modbus, MODBUS_RTU_HOLDING_REG);
         case MODBUS_RTU_FUNC_READ_INPUT_REGS:
-            return modbus_rtu_disp_read_input_regs(modbus);
+            return modbus_rtu_disp_read_regs(modbus, MODBUS_RTU_INPUT_REG);
         case MODBUS_RTU_FUNC_WRITE_SINGLE_COIL:
             return modbus_rtu_disp_write_coil(modbus);
         case MODBUS_RTU_FUNC_WRITE_SINGLE_REG:
@@ -1068,6 +1547,8 @@ err_t modbus_rtu_dispatch(modbus_rtu_t* modbus)
             return modbus_rtu_disp_write_regs(modbus);
         case MODBUS_RTU_FUNC_CHANGE_REG:
             return modbus_rtu_disp_change_reg(modbus);
+        case MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS:
+            return modbus_rtu_disp_read_write_regs(modbus);
         case MODBUS_RTU_FUNC_READ_SLAVE_ID:
             return modbus_rtu_disp_report_slave_id(modbus);
         case MODBUS_RTU_FUNC_READ_FILE:
@@ -1078,3 +1559,16 @@ err_t modbus_rtu_dispatch(modbus_rtu_t* modbus)
     
     return E_NO_ERROR;
 }
+
+err_t modbus_rtu_dispatch(modbus_rtu_t* modbus)
+{
+    // Ответ формируется в сообщении для передачи,
+    // которое ещё передаётся.
+    if(usart_bus_tx_busy(modbus->usart)) return E_BUSY;
+    
+    err_t err = modbus_rtu_dispatch_message(modbus);
+    
+    modbus_rtu_rx_message_done(modbus);
+    
+    return err;
+}
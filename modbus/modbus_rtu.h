@@ -39,6 +39,8 @@ typedef uint8_t modbus_rtu_func_t;
 #define MODBUS_RTU_FUNC_WRITE_MULTIPLE_REGS 0x10
 //! Изменение значения в регистре хранения.
 #define MODBUS_RTU_FUNC_CHANGE_REG 0x16
+//! Запись и чтение нескольких регистров хранения.
+#define MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS 0x17
 //! Чтение данных из очереди FIFO.
 #define MODBUS_RTU_FUNC_READ_FIFO 0x18
 //! Чтение из файла.
@@ -239,6 +241,66 @@ typedef modbus_rtu_error_t (*modbus_rtu_write_coil_callback_t)(uint16_t address,
 //! Каллбэк записи регистра хранения.
 typedef modbus_rtu_error_t (*modbus_rtu_write_holding_reg_callback_t)(uint16_t address, uint16_t value);
 
+/**
+ * Каллбэк чтения блока регистров флагов.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров, упакованные по 8 в байт,
+ * начиная с младшего бита; буфер предварительно обнулён.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+typedef modbus_rtu_error_t (*modbus_rtu_read_coils_callback_t)(uint16_t address, uint16_t count, uint8_t* values);
+
+/**
+ * Каллбэк чтения блока цифровых входов.
+ * @param address Адрес первого входа.
+ * @param count Число входов.
+ * @param values Значения входов, упакованные по 8 в байт,
+ * начиная с младшего бита; буфер предварительно обнулён.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+typedef modbus_rtu_error_t (*modbus_rtu_read_dins_callback_t)(uint16_t address, uint16_t count, uint8_t* values);
+
+/**
+ * Каллбэк чтения блока регистров хранения.
+ * Буфер значений может быть не выровнен.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+typedef modbus_rtu_error_t (*modbus_rtu_read_holding_regs_callback_t)(uint16_t address, uint16_t count, uint16_t* values);
+
+/**
+ * Каллбэк чтения блока регистров ввода.
+ * Буфер значений может быть не выровнен.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+typedef modbus_rtu_error_t (*modbus_rtu_read_input_regs_callback_t)(uint16_t address, uint16_t count, uint16_t* values);
+
+/**
+ * Каллбэк записи блока регистров флагов.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров, упакованные по 8 в байт,
+ * начиная с младшего бита.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+typedef modbus_rtu_error_t (*modbus_rtu_write_coils_callback_t)(uint16_t address, uint16_t count, const uint8_t* values);
+
+/**
+ * Каллбэк записи блока регистров хранения.
+ * Буфер значений может быть не выровнен.
+ * @param address Адрес первого регистра.
+ * @param count Число регистров.
+ * @param values Значения регистров.
+ * @return Код ошибки протокола Modbus RTU.
+ */
+typedef modbus_rtu_error_t (*modbus_rtu_write_holding_regs_callback_t)(uint16_t address, uint16_t count, const uint16_t* values);
+
 //! Каллбэк изменения регистра хранения.
 typedef modbus_rtu_error_t (*modbus_rtu_change_holding_reg_callback_t)(uint16_t address, uint16_t and_mask, uint16_t or_mask);
 
@@ -263,13 +325,28 @@ typedef modbus_rtu_error_t (*modbus_rtu_write_file_record_t)(uint16_t file, uint
 typedef modbus_rtu_error_t (*modbus_rtu_custom_function_callback_t)(modbus_rtu_func_t func, const void* rx_data, size_t rx_size, void* tx_data, size_t* tx_size);
 
 
+#ifdef USE_MODBUS_RTU_REG_MAP
+//! Предварительная декларация карты регистров.
+struct _Modbus_Reg_Map;
+#endif
+
 //! Тип протокола Modbus RTU.
 typedef struct _Modbus_Rtu {
     usart_bus_t* usart; //!< Шина USART.
     modbus_rtu_mode_t mode; //!< Режим работы.
     modbus_rtu_address_t address; //!< Адрес.
-    modbus_rtu_message_t* rx_message; //!< Сообщение для приёма.
+    modbus_rtu_message_t* rx_message; //!< Принятое сообщение для обработки.
     modbus_rtu_message_t* tx_message; //!< Сообщение для передачи.
+    modbus_rtu_message_t* rx_messages; //!< Буферы сообщений для приёма.
+    size_t rx_messages_count; //!< Число буферов сообщений для приёма.
+    size_t rx_first; //!< Индекс первого принятого сообщения.
+    volatile size_t rx_pending; //!< Число принятых необработанных сообщений.
+    bool rx_queue; //!< Флаг очереди сообщений, иначе новое сообщение замещает принятое.
+    modbus_rtu_message_t* rx_recv_message; //!< Принимаемое сообщение.
+    uint32_t rx_overruns; //!< Число сообщений, потерянных из-за отсутствия буфера.
+    uint16_t rx_crc; //!< CRC принятой части сообщения.
+    uint16_t rx_crc_size; //!< Число байт сообщения, учтённых в CRC.
+    uint8_t rx_seq; //!< Номер принимаемого сообщения.
     modbus_rtu_msg_recv_callback_t recv_callback; //!< Каллбэк приёма сообщения.
     modbus_rtu_msg_sent_callback_t sent_callback; //!< Каллбэк передачи сообщения.
     modbus_rtu_read_coil_callback_t read_coil_callback; //!< Каллбэк чтения регистра флагов.
@@ -278,11 +355,20 @@ typedef struct _Modbus_Rtu {
     modbus_rtu_read_input_reg_callback_t read_input_reg_callback; //!< Каллбэк чтения регистра ввода.
     modbus_rtu_write_coil_callback_t write_coil_callback; //!< Каллбэк записи регистра флагов.
     modbus_rtu_write_holding_reg_callback_t write_holding_reg_callback; //!< Каллбэк записи регистра хранения.
+    modbus_rtu_read_coils_callback_t read_coils_callback; //!< Каллбэк чтения блока регистров флагов.
+    modbus_rtu_read_dins_callback_t read_dins_callback; //!< Каллбэк чтения блока цифровых входов.
+    modbus_rtu_read_holding_regs_callback_t read_holding_regs_callback; //!< Каллбэк чтения блока регистров хранения.
+    modbus_rtu_read_input_regs_callback_t read_input_regs_callback; //!< Каллбэк чтения блока регистров ввода.
+    modbus_rtu_write_coils_callback_t write_coils_callback; //!< Каллбэк записи блока регистров флагов.
+    modbus_rtu_write_holding_regs_callback_t write_holding_regs_callback; //!< Каллбэк записи блока регистров хранения.
     modbus_rtu_change_holding_reg_callback_t change_holding_reg_callback; //!< Каллбэк изменения регистра хранения.
     modbus_rtu_report_slave_id_callback_t report_slave_id_callback; //!< Каллбэк получения идентификатора ведомого устройства.
     modbus_rtu_read_file_record_t read_file_record_callback; //!< Каллбэк чтения файла.
     modbus_rtu_write_file_record_t write_file_record_callback; //!< Каллбэк записи файла.
     modbus_rtu_custom_function_callback_t custom_function_callback; //!< Каллбэк обработки пользовательской функции.
+#ifdef USE_MODBUS_RTU_REG_MAP
+    struct _Modbus_Reg_Map* reg_map; //!< Карта регистров.
+#endif
 } modbus_rtu_t;
 
 
@@ -344,6 +430,19 @@ EXTERN bool modbus_rtu_usart_rx_byte_callback(modbus_rtu_t* modbus, uint8_t byte
  */
 EXTERN bool modbus_rtu_usart_rx_callback(modbus_rtu_t* modbus);
 
+/**
+ * Учитывает в CRC байты сообщения, принятые к текущему моменту.
+ * CRC принимаемого сообщения вычисляется по мере приёма,
+ * при завершении приёма обрабатываются только байты,
+ * не учтённые ранее.
+ * Следует вызывать из главного цикла во время приёма
+ * и из каллбэка хода приёма шины USART
+ * (прерывание половины передачи DMA).
+ * Сравнение с вычислением CRC целиком при IDLE - host/bench.c.
+ * @param modbus Протокол Modbus RTU.
+ */
+EXTERN void modbus_rtu_usart_rx_progress(modbus_rtu_t* modbus);
+
 /**
  * Каллбэк событий передачи данных по шине USART.
  * @param modbus Протокол Modbus RTU.
@@ -401,11 +500,57 @@ ALWAYS_INLINE static usart_errors_t modbus_rtu_tx_errors(modbus_rtu_t* modbus)
 
 /**
  * Получает сообщение для приёма протокола Modbus RTU.
+ * При использовании очереди - первое
+ * принятое необработанное сообщение.
  * @param modbus Протокол Modbus RTU.
  * @return Сообщение для приёма протокола Modbus RTU.
  */
 EXTERN modbus_rtu_message_t* modbus_rtu_rx_message(modbus_rtu_t* modbus);
 
+/**
+ * Устанавливает очередь буферов сообщений для приёма.
+ * Приём продолжается в свободный буфер, пока
+ * принятые ранее сообщения ожидают обработки.
+ * При занятости всех буферов принимаемые
+ * сообщения отбрасываются, поэтому каждое принятое
+ * сообщение должно освобождаться modbus_rtu_rx_message_done
+ * (modbus_rtu_dispatch освобождает его сама).
+ * По-умолчанию (без вызова данной функции) используется
+ * сообщение для приёма структуры инициализации,
+ * которое замещается каждым новым сообщением.
+ * Должна вызываться до начала приёма.
+ * @param modbus Протокол Modbus RTU.
+ * @param messages Буферы сообщений.
+ * @param count Число буферов.
+ * @return Код ошибки.
+ */
+EXTERN err_t modbus_rtu_set_rx_messages(modbus_rtu_t* modbus, modbus_rtu_message_t* messages, size_t count);
+
+/**
+ * Получает число принятых необработанных сообщений.
+ * @param modbus Протокол Modbus RTU.
+ * @return Число сообщений.
+ */
+EXTERN size_t modbus_rtu_rx_messages_pending(modbus_rtu_t* modbus);
+
+/**
+ * Освобождает буфер обработанного принятого сообщения,
+ * следующее принятое сообщение становится текущим.
+ * Вызывается modbus_rtu_dispatch, при обработке
+ * сообщений без диспетчеризации должна вызываться
+ * после обработки каждого сообщения.
+ * @param modbus Протокол Modbus RTU.
+ */
+EXTERN void modbus_rtu_rx_message_done(modbus_rtu_t* modbus);
+
+/**
+ * Получает число сообщений, потерянных
+ * из-за отсутствия свободного буфера приёма.
+ * @param modbus Протокол Modbus RTU.
+ * @return Число потерянных сообщений.
+ */
+EXTERN uint32_t modbus_rtu_rx_overruns(modbus_rtu_t* modbus);
+
 /**
  * Получает сообщение для передачи протокола Modbus RTU.
  * @param modbus Протокол Modbus RTU.
@@ -590,6 +735,102 @@ EXTERN modbus_rtu_write_holding_reg_callback_t modbus_rtu_write_holding_reg_call
  */
 EXTERN void modbus_rtu_set_write_holding_reg_callback(modbus_rtu_t* modbus, modbus_rtu_write_holding_reg_callback_t callback);
 
+/**
+ * Получает каллбэк чтения блока регистров флагов.
+ * @param modbus Протокол Modbus RTU.
+ * @return Каллбэк чтения блока регистров флагов.
+ */
+EXTERN modbus_rtu_read_coils_callback_t modbus_rtu_read_coils_callback(modbus_rtu_t* modbus);
+
+/**
+ * Устанавливает каллбэк чтения блока регистров флагов.
+ * При установке используется вместо
+ * каллбэка доступа к отдельному регистру.
+ * @param modbus Протокол Modbus RTU.
+ * @param callback Каллбэк чтения блока регистров флагов.
+ */
+EXTERN void modbus_rtu_set_read_coils_callback(modbus_rtu_t* modbus, modbus_rtu_read_coils_callback_t callback);
+
+/**
+ * Получает каллбэк чтения блока цифровых входов.
+ * @param modbus Протокол Modbus RTU.
+ * @return Каллбэк чтения блока цифровых входов.
+ */
+EXTERN modbus_rtu_read_dins_callback_t modbus_rtu_read_dins_callback(modbus_rtu_t* modbus);
+
+/**
+ * Устанавливает каллбэк чтения блока цифровых входов.
+ * При установке используется вместо
+ * каллбэка доступа к отдельному регистру.
+ * @param modbus Протокол Modbus RTU.
+ * @param callback Каллбэк чтения блока цифровых входов.
+ */
+EXTERN void modbus_rtu_set_read_dins_callback(modbus_rtu_t* modbus, modbus_rtu_read_dins_callback_t callback);
+
+/**
+ * Получает каллбэк чтения блока регистров хранения.
+ * @param modbus Протокол Modbus RTU.
+ * @return Каллбэк чтения блока регистров хранения.
+ */
+EXTERN modbus_rtu_read_holding_regs_callback_t modbus_rtu_read_holding_regs_callback(modbus_rtu_t* modbus);
+
+/**
+ * Устанавливает каллбэк чтения блока регистров хранения.
+ * При установке используется вместо
+ * каллбэка доступа к отдельному регистру.
+ * @param modbus Протокол Modbus RTU.
+ * @param callback Каллбэк чтения блока регистров хранения.
+ */
+EXTERN void modbus_rtu_set_read_holding_regs_callback(modbus_rtu_t* modbus, modbus_rtu_read_holding_regs_callback_t callback);
+
+/**
+ * Получает каллбэк чтения блока регистров ввода.
+ * @param modbus Протокол Modbus RTU.
+ * @return Каллбэк чтения блока регистров ввода.
+ */
+EXTERN modbus_rtu_read_input_regs_callback_t modbus_rtu_read_input_regs_callback(modbus_rtu_t* modbus);
+
+/**
+ * Устанавливает каллбэк чтения блока регистров ввода.
+ * При установке используется вместо
+ * каллбэка доступа к отдельному регистру.
+ * @param modbus Протокол Modbus RTU.
+ * @param callback Каллбэк чтения блока регистров ввода.
+ */
+EXTERN void modbus_rtu_set_read_input_regs_callback(modbus_rtu_t* modbus, modbus_rtu_read_input_regs_callback_t callback);
+
+/**
+ * Получает каллбэк записи блока регистров флагов.
+ * @param modbus Протокол Modbus RTU.
+ * @return Каллбэк записи блока регистров флагов.
+ */
+EXTERN modbus_rtu_write_coils_callback_t modbus_rtu_write_coils_callback(modbus_rtu_t* modbus);
+
+/**
+ * Устанавливает каллбэк записи блока регистров флагов.
+ * При установке используется вместо
+ * каллбэка доступа к отдельному регистру.
+ * @param modbus Протокол Modbus RTU.
+ * @param callback Каллбэк записи блока регистров флагов.
+ */
+EXTERN void modbus_rtu_set_write_coils_callback(modbus_rtu_t* modbus, modbus_rtu_write_coils_callback_t callback);
+
+/**
+ * Получает каллбэк записи блока регистров хранения.
+ * @param modbus Протокол Modbus RTU.
+ * @return Каллбэк записи блока регистров хранения.
+ */
+EXTERN modbus_rtu_write_holding_regs_callback_t modbus_rtu_write_holding_regs_callback(modbus_rtu_t* modbus);
+
+/**
+ * Устанавливает каллбэк записи блока регистров хранения.
+ * При установке используется вместо
+ * каллбэка доступа к отдельному регистру.
+ * @param modbus Протокол Modbus RTU.
+ * @param callback Каллбэк записи блока регистров хранения.
+ */
+EXTERN void modbus_rtu_set_write_holding_regs_callback(modbus_rtu_t* modbus, modbus_rtu_write_holding_regs_callback_t callback);
+
 /**
  * Получает каллбэк изменения регистра хранения.
  * @param modbus Протокол Modbus RTU.
@@ -660,9 +901,34 @@ EXTERN modbus_rtu_custom_function_callback_t modbus_rtu_custom_function_callback
  */
 EXTERN void modbus_rtu_set_custom_function_callback(modbus_rtu_t* modbus, modbus_rtu_custom_function_callback_t callback);
 
+#ifdef USE_MODBUS_RTU_REG_MAP
+
+/**
+ * Получает карту регистров.
+ * @param modbus Протокол Modbus RTU.
+ * @return Карта регистров.
+ */
+EXTERN struct _Modbus_Reg_Map* modbus_rtu_reg_map(modbus_rtu_t* modbus);
+
+/**
+ * Устанавливает карту регистров.
+ * При установке обращения к флагам, дискретным входам,
+ * регистрам хранения и ввода обслуживаются картой
+ * вместо каллбэков чтения и записи.
+ * @param modbus Протокол Modbus RTU.
+ * @param reg_map Карта регистров, NULL для использования каллбэков.
+ */
+EXTERN void modbus_rtu_set_reg_map(modbus_rtu_t* modbus, struct _Modbus_Reg_Map* reg_map);
+
+#endif
 
 /**
  * Обрабатывает сообщение протокола Modbus RTU.
+ * После обработки освобождает буфер принятого сообщения.
+ * Во время передачи предыдущего ответа возвращает E_BUSY,
+ * не обрабатывая сообщение и не освобождая его буфер,
+ * в этом случае вызов следует повторить после
+ * каллбэка передачи сообщения.
  * @param modbus Протокол Modbus RTU.
  * @return Код ошибки.
  */
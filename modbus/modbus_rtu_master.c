@@ -0,0 +1,685 @@
+#include "modbus_rtu_master.h"
+#include <string.h>
+#include "utils/net.h"
+#include "utils/critical.h"
+
+
+//! Максимальное число читаемых флагов и входов.
+#define MODBUS_RTU_MASTER_READ_BITS_MAX 2000
+//! Максимальное число читаемых регистров.
+#define MODBUS_RTU_MASTER_READ_REGS_MAX 125
+//! Максимальное число записываемых флагов.
+#define MODBUS_RTU_MASTER_WRITE_BITS_MAX 1968
+//! Максимальное число записываемых регистров.
+#define MODBUS_RTU_MASTER_WRITE_REGS_MAX 123
+//! Максимальное число записываемых регистров при совмещённой записи и чтении.
+#define MODBUS_RTU_MASTER_READ_WRITE_REGS_MAX 121
+//! Максимальный адрес ведомого.
+#define MODBUS_RTU_MASTER_SLAVE_ADDRESS_MAX 247
+//! Бит исключения в коде функции ответа.
+#define MODBUS_RTU_MASTER_FUNC_EXCEPTION 0x80
+
+
+static void* modbus_rtu_master_timer_proc(void* arg);
+
+
+/**
+ * Преобразует время в микросекундах в структуру времени.
+ * @param tv Время.
+ * @param us Время в микросекундах.
+ */
+static void modbus_rtu_master_us_to_tv(struct timeval* tv, uint32_t us)
+{
+    tv->tv_sec = us / 1000000;
+    tv->tv_usec = us % 1000000;
+}
+
+/**
+ * Проверяет запрос.
+ * @param request Запрос.
+ * @return Код ошибки.
+ */
+static err_t modbus_rtu_master_check_request(modbus_rtu_master_request_t* request)
+{
+    if(request->data == NULL) return E_NULL_POINTER;
+    if(request->address > MODBUS_RTU_MASTER_SLAVE_ADDRESS_MAX) return E_INVALID_VALUE;
+    if(request->count == 0) return E_INVALID_VALUE;
+    if((uint32_t)request->reg_address + request->count > 0x10000) return E_INVALID_VALUE;
+    
+    uint16_t count_max;
+    bool is_read = false;
+    
+    switch(request->func){
+        default:
+            return E_INVALID_VALUE;
+        case MODBUS_RTU_FUNC_READ_COILS_STATUS:
+        case MODBUS_RTU_FUNC_READ_DISCR_INPUTS:
+            count_max = MODBUS_RTU_MASTER_READ_BITS_MAX;
+            is_read = true;
+            break;
+        case MODBUS_RTU_FUNC_READ_HOLDING_REGS:
+        case MODBUS_RTU_FUNC_READ_INPUT_REGS:
+            count_max = MODBUS_RTU_MASTER_READ_REGS_MAX;
+            is_read = true;
+            break;
+        case MODBUS_RTU_FUNC_WRITE_SINGLE_COIL:
+        case MODBUS_RTU_FUNC_WRITE_SINGLE_REG:
+            count_max = 1;
+            break;
+        case MODBUS_RTU_FUNC_WRITE_MULTIPLE_COILS:
+            count_max = MODBUS_RTU_MASTER_WRITE_BITS_MAX;
+            break;
+        case MODBUS_RTU_FUNC_WRITE_MULTIPLE_REGS:
+            count_max = MODBUS_RTU_MASTER_WRITE_REGS_MAX;
+            break;
+        case MODBUS_RTU_FUNC_CHANGE_REG:
+            count_max = 1;
+            break;
+        case MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS:
+            if(request->write_data == NULL) return E_NULL_POINTER;
+            if(request->write_count == 0 ||
+               request->write_count > MODBUS_RTU_MASTER_READ_WRITE_REGS_MAX) return E_INVALID_VALUE;
+            if((uint32_t)request->write_address + request->write_count > 0x10000) return E_INVALID_VALUE;
+            count_max = MODBUS_RTU_MASTER_READ_REGS_MAX;
+            is_read = true;
+            break;
+    }
+    
+    if(request->count > count_max) return E_INVALID_VALUE;
+    if(is_read && request->address == MODBUS_RTU_ADDRESS_BROADCAST) return E_INVALID_VALUE;
+    
+    return E_NO_ERROR;
+}
+
+/**
+ * Назначает запросу статистику его ведомого.
+ * @param master Ведущий.
+ * @param request Запрос.
+ * @param stats_used Число используемых элементов статистики.
+ * @return Код ошибки.
+ */
+static err_t modbus_rtu_master_assign_stats(modbus_rtu_master_t* master, modbus_rtu_master_request_t* request, size_t* stats_used)
+{
+    size_t i = 0;
+    for(; i < *stats_used; i ++){
+        if(master->stats[i].address == request->address){
+            request->stats = &master->stats[i];
+            return E_NO_ERROR;
+        }
+    }
+    
+    if(*stats_used >= master->stats_count) return E_OUT_OF_MEMORY;
+    
+    request->stats = &master->stats[*stats_used];
+    request->stats->address = request->address;
+    
+    (*stats_used) ++;
+    
+    return E_NO_ERROR;
+}
+
+err_t modbus_rtu_master_init(modbus_rtu_master_t* master, modbus_rtu_master_init_t* master_is)
+{
+    if(master_is->modbus == NULL) return E_NULL_POINTER;
+    if(master_is->requests == NULL) return E_NULL_POINTER;
+    if(master_is->stats == NULL) return E_NULL_POINTER;
+    
+    if(master_is->modbus->mode != MODBUS_RTU_MODE_MASTER) return E_INVALID_VALUE;
+    if(master_is->requests_count == 0) return E_INVALID_VALUE;
+    
+    memset(master, 0x0, sizeof(modbus_rtu_master_t));
+    
+    master->modbus = master_is->modbus;
+    master->timers = master_is->timers ? master_is->timers : timers_default();
+    master->requests = master_is->requests;
+    master->requests_count = master_is->requests_count;
+    master->stats = master_is->stats;
+    master->stats_count = master_is->stats_count;
+    master->retries = master_is->retries;
+    master->state = MODBUS_RTU_MASTER_STATE_STOPPED;
+    master->timer = INVALID_TIMER_ID;
+    
+    // t3.5 = 3.5 символа по 11 бит.
+    uint32_t gap_us = MODBUS_RTU_MASTER_GAP_US_MIN;
+    if(master_is->baud != 0 && master_is->baud <= 19200){
+        gap_us = 38500000UL / master_is->baud;
+    }
+    modbus_rtu_master_us_to_tv(&master->gap, gap_us);
+    
+    modbus_rtu_master_us_to_tv(&master->timeout, master_is->timeout_us ?
+                               master_is->timeout_us : MODBUS_RTU_MASTER_TIMEOUT_US_DEFAULT);
+    modbus_rtu_master_us_to_tv(&master->turnaround, master_is->turnaround_us ?
+                               master_is->turnaround_us : MODBUS_RTU_MASTER_TURNAROUND_US_DEFAULT);
+    
+    memset(master->stats, 0x0, sizeof(modbus_rtu_master_slave_stats_t) * master->stats_count);
+    
+    err_t err = E_NO_ERROR;
+    size_t stats_used = 0;
+    modbus_rtu_master_request_t* request = NULL;
+    
+    size_t i = 0;
+    for(; i < master->requests_count; i ++){
+        request = &master->requests[i];
+    
+        err = modbus_rtu_master_check_request(request);
+        if(err != E_NO_ERROR) return err;
+    
+        err = modbus_rtu_master_assign_stats(master, request, &stats_used);
+        if(err != E_NO_ERROR) return err;
+    
+        timerclear(&request->next_time);
+        request->status = MODBUS_RTU_MASTER_STATUS_NONE;
+        request->error = MODBUS_RTU_ERROR_NONE;
+    }
+    
+    master->stats_count = stats_used;
+    
+    modbus_rtu_master_reset_stats(master);
+    
+    return E_NO_ERROR;
+}
+
+/**
+ * Устанавливает состояние, если опрос не остановлен.
+ * @param master Ведущий.
+ * @param state Состояние.
+ * @return Флаг установки состояния.
+ */
+static bool modbus_rtu_master_set_state(modbus_rtu_master_t* master, modbus_rtu_master_state_t state)
+{
+    bool res = false;
+    
+    CRITICAL_ENTER();
+    
+    if(master->state != MODBUS_RTU_MASTER_STATE_STOPPED){
+        master->state = state;
+        res = true;
+    }
+    
+    CRITICAL_EXIT();
+    
+    return res;
+}
+
+/**
+ * Устанавливает состояние и запускает таймер на заданное время.
+ * При невозможности запуска таймера опрос останавливается.
+ * @param master Ведущий.
+ * @param state Состояние.
+ * @param tv Время срабатывания таймера.
+ */
+static void modbus_rtu_master_set_timer_at(modbus_rtu_master_t* master, modbus_rtu_master_state_t state, struct timeval* tv)
+{
+    if(!modbus_rtu_master_set_state(master, state)) return;
+    
+    master->timer = timers_instance_add_timer(master->timers, modbus_rtu_master_timer_proc, tv, NULL, master, NULL);
+    
+    if(master->timer == INVALID_TIMER_ID){
+        master->state = MODBUS_RTU_MASTER_STATE_STOPPED;
+    }
+}
+
+/**
+ * Устанавливает состояние и запускает таймер на заданный интервал.
+ * @param master Ведущий.
+ * @param state Состояние.
+ * @param delay Интервал.
+ */
+static void modbus_rtu_master_set_timer(modbus_rtu_master_t* master, modbus_rtu_master_state_t state, const struct timeval* delay)
+{
+    struct timeval tv;
+    
+    gettimeofday(&tv, NULL);
+    timeradd(&tv, delay, &tv);
+    
+    modbus_rtu_master_set_timer_at(master, state, &tv);
+}
+
+/**
+ * Заполняет сообщение запроса.
+ * @param master Ведущий.
+ * @param request Запрос.
+ */
+static void modbus_rtu_master_build(modbus_rtu_master_t* master, modbus_rtu_master_request_t* request)
+{
+    modbus_rtu_message_t* message = modbus_rtu_tx_message(master->modbus);
+    uint8_t* data = modbus_rtu_message_data(message);
+    uint16_t* header = (uint16_t*)data;
+    
+    const uint8_t* bits_values = (const uint8_t*)request->data;
+    const uint16_t* regs_values = (const uint16_t*)request->data;
+    
+    size_t size = sizeof(uint16_t) * 2;
+    uint8_t bytes_count = 0;
+    uint16_t i;
+    
+    header[0] = htons(request->reg_address);
+    
+    switch(request->func){
+        default:
+            header[1] = htons(request->count);
+            break;
+        case MODBUS_RTU_FUNC_WRITE_SINGLE_COIL:
+            header[1] = htons((bits_values[0] & 0x1) ? 0xff00 : 0x0);
+            break;
+        case MODBUS_RTU_FUNC_WRITE_SINGLE_REG:
+            header[1] = htons(regs_values[0]);
+            break;
+        case MODBUS_RTU_FUNC_WRITE_MULTIPLE_COILS:
+            header[1] = htons(request->count);
+            bytes_count = (request->count + 7) / 8;
+            data[size ++] = bytes_count;
+            memcpy(&data[size], bits_values, bytes_count);
+            size += bytes_count;
+            break;
+        case MODBUS_RTU_FUNC_WRITE_MULTIPLE_REGS:
+            header[1] = htons(request->count);
+            bytes_count = request->count * 2;
+            data[size ++] = bytes_count;
+            // Данные начинаются с нечётного смещения.
+            for(i = 0; i < request->count; i ++){
+                data[size ++] = regs_values[i] >> 8;
+                data[size ++] = regs_values[i] & 0xff;
+            }
+            break;
+        case MODBUS_RTU_FUNC_CHANGE_REG:
+            header[1] = htons(regs_values[0]);
+            header[2] = htons(regs_values[1]);
+            size += sizeof(uint16_t);
+            break;
+        case MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS:
+            header[1] = htons(request->count);
+            header[2] = htons(request->write_address);
+            header[3] = htons(request->write_count);
+            size += sizeof(uint16_t) * 2;
+            bytes_count = request->write_count * 2;
+            data[size ++] = bytes_count;
+            // Данные начинаются с нечётного смещения.
+            for(i = 0; i < request->write_count; i ++){
+                data[size ++] = request->write_data[i] >> 8;
+                data[size ++] = request->write_data[i] & 0xff;
+            }
+            break;
+    }
+    
+    modbus_rtu_message_set_address(message, request->address);
+    modbus_rtu_message_set_func(message, request->func);
+    modbus_rtu_message_set_data_size(message, size);
+    modbus_rtu_message_calc_crc(message);
+}
+
+/**
+ * Разбирает ответ на запрос.
+ * @param master Ведущий.
+ * @param request Запрос.
+ * @return Результат запроса.
+ */
+static modbus_rtu_master_status_t modbus_rtu_master_decode(modbus_rtu_master_t* master, modbus_rtu_master_request_t* request)
+{
+    modbus_rtu_message_t* rx_message = modbus_rtu_rx_message(master->modbus);
+    modbus_rtu_message_t* tx_message = modbus_rtu_tx_message(master->modbus);
+    
+    modbus_rtu_func_t func = modbus_rtu_message_func(rx_message);
+    size_t size = modbus_rtu_message_data_size(rx_message);
+    const uint8_t* data = modbus_rtu_message_data(rx_message);
+    
+    if(func == (request->func | MODBUS_RTU_MASTER_FUNC_EXCEPTION)){
+        if(size != 1) return MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE;
+    
+        request->error = data[0];
+    
+        return MODBUS_RTU_MASTER_STATUS_EXCEPTION;
+    }
+    
+    if(func != request->func) return MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE;
+    
+    uint16_t* regs_values = (uint16_t*)request->data;
+    size_t bytes_count;
+    uint16_t i;
+    
+    switch(func){
+        default:
+            return MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE;
+        case MODBUS_RTU_FUNC_READ_COILS_STATUS:
+        case MODBUS_RTU_FUNC_READ_DISCR_INPUTS:
+            bytes_count = (request->count + 7) / 8;
+            if(size != bytes_count + 1 || data[0] != bytes_count)
+                return MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE;
+    
+            memcpy(request->data, &data[1], bytes_count);
+            break;
+        case MODBUS_RTU_FUNC_READ_HOLDING_REGS:
+        case MODBUS_RTU_FUNC_READ_INPUT_REGS:
+        case MODBUS_RTU_FUNC_READ_WRITE_MULTIPLE_REGS:
+            bytes_count = request->count * 2;
+            if(size != bytes_count + 1 || data[0] != bytes_count)
+                return MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE;
+    
+            for(i = 0; i < request->count; i ++){
+                regs_values[i] = ((uint16_t)data[i * 2 + 1] << 8) | data[i * 2 + 2];
+            }
+            break;
+        case MODBUS_RTU_FUNC_WRITE_SINGLE_COIL:
+        case MODBUS_RTU_FUNC_WRITE_SINGLE_REG:
+        case MODBUS_RTU_FUNC_WRITE_MULTIPLE_COILS:
+        case MODBUS_RTU_FUNC_WRITE_MULTIPLE_REGS:
+            // Ответ повторяет адрес и значение либо число регистров.
+            if(size != sizeof(uint16_t) * 2 ||
+               memcmp(data, modbus_rtu_message_data(tx_message), sizeof(uint16_t) * 2) != 0)
+                return MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE;
+            break;
+        case MODBUS_RTU_FUNC_CHANGE_REG:
+            // Ответ повторяет адрес и маски.
+            if(size != sizeof(uint16_t) * 3 ||
+               memcmp(data, modbus_rtu_message_data(tx_message), sizeof(uint16_t) * 3) != 0)
+                return MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE;
+            break;
+    }
+    
+    return MODBUS_RTU_MASTER_STATUS_OK;
+}
+
+/**
+ * Завершает выполнение текущего запроса.
+ * При ошибке и наличии повторов запрос повторяется.
+ * @param master Ведущий.
+ * @param status Результат запроса.
+ */
+static void modbus_rtu_master_complete(modbus_rtu_master_t* master, modbus_rtu_master_status_t status)
+{
+    modbus_rtu_master_request_t* request = &master->requests[master->current];
+    modbus_rtu_master_slave_stats_t* stats = request->stats;
+    
+    switch(status){
+        default:
+            break;
+        case MODBUS_RTU_MASTER_STATUS_OK:
+            stats->responses ++;
+            break;
+        case MODBUS_RTU_MASTER_STATUS_EXCEPTION:
+            stats->exceptions ++;
+            break;
+        case MODBUS_RTU_MASTER_STATUS_TIMEOUT:
+            stats->timeouts ++;
+            break;
+        case MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE:
+            stats->invalid_responses ++;
+            break;
+    }
+    
+    bool failed = status == MODBUS_RTU_MASTER_STATUS_TIMEOUT ||
+                  status == MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE ||
+                  status == MODBUS_RTU_MASTER_STATUS_SEND_ERROR;
+    
+    if(failed && master->retry < master->retries){
+        master->retry ++;
+        master->resend = true;
+        stats->retries ++;
+    }else{
+        if(failed) stats->failures ++;
+    
+        request->status = status;
+    
+        if(request->callback) request->callback(request);
+    }
+    
+    modbus_rtu_master_set_timer(master, MODBUS_RTU_MASTER_STATE_GAP, &master->gap);
+}
+
+/**
+ * Выбирает и передаёт очередной запрос.
+ * Если ни один запрос не должен выполняться,
+ * ожидает время ближайшего запроса.
+ * @param master Ведущий.
+ */
+static void modbus_rtu_master_next(modbus_rtu_master_t* master)
+{
+    modbus_rtu_master_request_t* request = NULL;
+    
+    if(!master->resend){
+        struct timeval now;
+        struct timeval next_time;
+    
+        gettimeofday(&now, NULL);
+        timerclear(&next_time);
+    
+        size_t index = master->current;
+    
+        size_t i = 0;
+        for(; i < master->requests_count; i ++){
+            index ++;
+            if(index >= master->requests_count) index = 0;
+    
+            request = &master->requests[index];
+    
+            if(!timercmp(&request->next_time, &now, >)) break;
+    
+            if(i == 0 || timercmp(&request->next_time, &next_time, <)){
+                next_time = request->next_time;
+            }
+        }
+    
+        if(i == master->requests_count){
+            modbus_rtu_master_set_timer_at(master, MODBUS_RTU_MASTER_STATE_IDLE, &next_time);
+            return;
+        }
+    
+        master->current = index;
+        master->retry = 0;
+    
+        timeradd(&now, &request->period, &request->next_time);
+    }else{
+        master->resend = false;
+    
+        request = &master->requests[master->current];
+    }
+    
+    request->error = MODBUS_RTU_ERROR_NONE;
+    
+    modbus_rtu_master_build(master, request);
+    
+    if(!modbus_rtu_master_set_state(master, MODBUS_RTU_MASTER_STATE_SENDING)) return;
+    
+    request->stats->requests ++;
+    
+    if(modbus_rtu_send_message(master->modbus) != E_NO_ERROR){
+        if(!modbus_rtu_master_set_state(master, MODBUS_RTU_MASTER_STATE_PROCESSING)) return;
+    
+        modbus_rtu_master_complete(master, MODBUS_RTU_MASTER_STATUS_SEND_ERROR);
+    }
+}
+
+static void* modbus_rtu_master_timer_proc(void* arg)
+{
+    modbus_rtu_master_t* master = (modbus_rtu_master_t*)arg;
+    modbus_rtu_master_state_t state;
+    
+    CRITICAL_ENTER();
+    
+    // Таймер мог быть удалён во время срабатывания.
+    if(timers_instance_current_timer_id(master->timers) != master->timer){
+        CRITICAL_EXIT();
+        return NULL;
+    }
+    
+    master->timer = INVALID_TIMER_ID;
+    
+    state = master->state;
+    
+    if(state == MODBUS_RTU_MASTER_STATE_WAIT_RESPONSE ||
+       state == MODBUS_RTU_MASTER_STATE_TURNAROUND){
+        master->state = MODBUS_RTU_MASTER_STATE_PROCESSING;
+    }
+    
+    CRITICAL_EXIT();
+    
+    switch(state){
+        default:
+            break;
+        case MODBUS_RTU_MASTER_STATE_IDLE:
+        case MODBUS_RTU_MASTER_STATE_GAP:
+            modbus_rtu_master_next(master);
+            break;
+        case MODBUS_RTU_MASTER_STATE_WAIT_RESPONSE:
+            modbus_rtu_master_complete(master, MODBUS_RTU_MASTER_STATUS_TIMEOUT);
+            break;
+        case MODBUS_RTU_MASTER_STATE_TURNAROUND:
+            modbus_rtu_master_complete(master, MODBUS_RTU_MASTER_STATUS_OK);
+            break;
+    }
+    
+    return NULL;
+}
+
+err_t modbus_rtu_master_start(modbus_rtu_master_t* master)
+{
+    if(master->state != MODBUS_RTU_MASTER_STATE_STOPPED) return E_BUSY;
+    
+    size_t i = 0;
+    for(; i < master->requests_count; i ++){
+        timerclear(&master->requests[i].next_time);
+    }
+    
+    master->current = master->requests_count - 1;
+    master->retry = 0;
+    master->resend = false;
+    master->timer = INVALID_TIMER_ID;
+    master->state = MODBUS_RTU_MASTER_STATE_GAP;
+    
+    modbus_rtu_master_next(master);
+    
+    if(master->state == MODBUS_RTU_MASTER_STATE_STOPPED) return E_OUT_OF_MEMORY;
+    
+    return E_NO_ERROR;
+}
+
+void modbus_rtu_master_stop(modbus_rtu_master_t* master)
+{
+    timer_id_t tid;
+    
+    CRITICAL_ENTER();
+    
+    master->state = MODBUS_RTU_MASTER_STATE_STOPPED;
+    
+    tid = master->timer;
+    master->timer = INVALID_TIMER_ID;
+    
+    CRITICAL_EXIT();
+    
+    if(tid != INVALID_TIMER_ID) timers_instance_remove_timer(master->timers, tid);
+}
+
+void modbus_rtu_master_trigger(modbus_rtu_master_t* master, modbus_rtu_master_request_t* request)
+{
+    timer_id_t tid = INVALID_TIMER_ID;
+    bool idle = false;
+    
+    CRITICAL_ENTER();
+    
+    timerclear(&request->next_time);
+    
+    if(master->state == MODBUS_RTU_MASTER_STATE_IDLE){
+        master->state = MODBUS_RTU_MASTER_STATE_PROCESSING;
+        tid = master->timer;
+        master->timer = INVALID_TIMER_ID;
+        idle = true;
+    }
+    
+    CRITICAL_EXIT();
+    
+    if(!idle) return;
+    
+    if(tid != INVALID_TIMER_ID) timers_instance_remove_timer(master->timers, tid);
+    
+    modbus_rtu_master_set_timer(master, MODBUS_RTU_MASTER_STATE_GAP, &master->gap);
+}
+
+void modbus_rtu_master_msg_recv(modbus_rtu_master_t* master)
+{
+    modbus_rtu_master_request_t* request = &master->requests[master->current];
+    modbus_rtu_message_t* rx_message = modbus_rtu_rx_message(master->modbus);
+    timer_id_t tid;
+    
+    CRITICAL_ENTER();
+    
+    // Ответы других ведомых игнорируются.
+    if(master->state != MODBUS_RTU_MASTER_STATE_WAIT_RESPONSE ||
+       modbus_rtu_message_address(rx_message) != request->address){
+        CRITICAL_EXIT();
+        modbus_rtu_rx_message_done(master->modbus);
+        return;
+    }
+    
+    master->state = MODBUS_RTU_MASTER_STATE_PROCESSING;
+    
+    tid = master->timer;
+    master->timer = INVALID_TIMER_ID;
+    
+    CRITICAL_EXIT();
+    
+    if(tid != INVALID_TIMER_ID) timers_instance_remove_timer(master->timers, tid);
+    
+    struct timeval tv;
+    
+    gettimeofday(&tv, NULL);
+    timersub(&tv, &master->sent_time, &tv);
+    
+    uint32_t latency = (uint32_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    
+    modbus_rtu_master_status_t status = modbus_rtu_master_decode(master, request);
+    
+    modbus_rtu_rx_message_done(master->modbus);
+    
+    if(status == MODBUS_RTU_MASTER_STATUS_OK || status == MODBUS_RTU_MASTER_STATUS_EXCEPTION){
+        modbus_rtu_master_slave_stats_t* stats = request->stats;
+    
+        stats->latency_last_us = latency;
+        stats->latency_sum_us += latency;
+        if(latency < stats->latency_min_us) stats->latency_min_us = latency;
+        if(latency > stats->latency_max_us) stats->latency_max_us = latency;
+    }
+    
+    modbus_rtu_master_complete(master, status);
+}
+
+void modbus_rtu_master_msg_sent(modbus_rtu_master_t* master)
+{
+    if(master->state != MODBUS_RTU_MASTER_STATE_SENDING) return;
+    
+    modbus_rtu_master_request_t* request = &master->requests[master->current];
+    
+    gettimeofday(&master->sent_time, NULL);
+    
+    if(request->address == MODBUS_RTU_ADDRESS_BROADCAST){
+        modbus_rtu_master_set_timer(master, MODBUS_RTU_MASTER_STATE_TURNAROUND, &master->turnaround);
+    }else{
+        modbus_rtu_master_set_timer(master, MODBUS_RTU_MASTER_STATE_WAIT_RESPONSE, &master->timeout);
+    }
+}
+
+const modbus_rtu_master_slave_stats_t* modbus_rtu_master_slave_stats(modbus_rtu_master_t* master, modbus_rtu_address_t address)
+{
+    size_t i = 0;
+    for(; i < master->stats_count; i ++){
+        if(master->stats[i].address == address) return &master->stats[i];
+    }
+    
+    return NULL;
+}
+
+void modbus_rtu_master_reset_stats(modbus_rtu_master_t* master)
+{
+    modbus_rtu_master_slave_stats_t* stats = NULL;
+    modbus_rtu_address_t address;
+    
+    size_t i = 0;
+    for(; i < master->stats_count; i ++){
+        stats = &master->stats[i];
+        address = stats->address;
+    
+        memset(stats, 0x0, sizeof(modbus_rtu_master_slave_stats_t));
+    
+        stats->address = address;
+        stats->latency_min_us = UINT32_MAX;
+    }
+}
@@ -0,0 +1,246 @@
+/**
+ * @file modbus_rtu_master.h Опрос ведомых устройств протокола Modbus RTU.
+ * Ведущий выполняет таблицу периодических запросов
+ * к ведомым устройствам, отправляя очередной запрос
+ * сразу по завершении предыдущего с соблюдением
+ * межкадрового интервала t3.5.
+ * Межкадровый интервал, таймаут ответа и задержка после
+ * широковещательного запроса отсчитываются таймерами.
+ * При отсутствии ответа или некорректном ответе запрос
+ * повторяется заданное число раз.
+ * Результат запроса передаётся каллбэку запроса,
+ * для каждого ведомого ведётся статистика запросов,
+ * ошибок и времени ответа.
+ * Протокол Modbus RTU должен работать в режиме ведущего,
+ * из каллбэков приёма и передачи сообщения протокола
+ * следует вызывать modbus_rtu_master_msg_recv
+ * и modbus_rtu_master_msg_sent соответственно.
+ */
+
+#ifndef MODBUS_RTU_MASTER_H
+#define MODBUS_RTU_MASTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/time.h>
+#include "errors/errors.h"
+#include "defs/defs.h"
+#include "timers/timers.h"
+#include "modbus_rtu.h"
+
+
+//! Интервал t3.5 при скорости выше 19200 бод, мкс.
+#define MODBUS_RTU_MASTER_GAP_US_MIN 1750
+
+//! Таймаут ответа по-умолчанию, мкс.
+#define MODBUS_RTU_MASTER_TIMEOUT_US_DEFAULT 100000
+
+//! Задержка после широковещательного запроса по-умолчанию, мкс.
+#define MODBUS_RTU_MASTER_TURNAROUND_US_DEFAULT 100000
+
+
+//! Тип результата запроса.
+typedef enum _Modbus_Rtu_Master_Status {
+    MODBUS_RTU_MASTER_STATUS_NONE = 0, //!< Запрос не выполнялся.
+    MODBUS_RTU_MASTER_STATUS_OK, //!< Запрос выполнен.
+    MODBUS_RTU_MASTER_STATUS_EXCEPTION, //!< Ведомый ответил исключением.
+    MODBUS_RTU_MASTER_STATUS_TIMEOUT, //!< Ответ не получен.
+    MODBUS_RTU_MASTER_STATUS_INVALID_RESPONSE, //!< Ответ не соответствует запросу.
+    MODBUS_RTU_MASTER_STATUS_SEND_ERROR //!< Ошибка передачи запроса.
+} modbus_rtu_master_status_t;
+
+//! Тип статистики ведомого.
+typedef struct _Modbus_Rtu_Master_Slave_Stats {
+    modbus_rtu_address_t address; //!< Адрес ведомого.
+    uint32_t requests; //!< Число переданных запросов, включая повторы.
+    uint32_t responses; //!< Число успешных ответов.
+    uint32_t exceptions; //!< Число ответов с исключением.
+    uint32_t timeouts; //!< Число запросов без ответа.
+    uint32_t invalid_responses; //!< Число некорректных ответов.
+    uint32_t retries; //!< Число повторов запросов.
+    uint32_t failures; //!< Число запросов, не выполненных после всех повторов.
+    uint32_t latency_last_us; //!< Время последнего ответа, мкс.
+    uint32_t latency_min_us; //!< Минимальное время ответа, мкс, UINT32_MAX до первого ответа.
+    uint32_t latency_max_us; //!< Максимальное время ответа, мкс.
+    uint64_t latency_sum_us; //!< Суммарное время ответов, мкс.
+} modbus_rtu_master_slave_stats_t;
+
+//! Предварительная декларация запроса.
+struct _Modbus_Rtu_Master_Request;
+
+/**
+ * Тип каллбэка завершения запроса.
+ * Вызывается из контекста прерывания
+ * приёма сообщения либо таймера.
+ * @param request Запрос с результатом.
+ */
+typedef void (*modbus_rtu_master_request_callback_t)(struct _Modbus_Rtu_Master_Request* request);
+
+/**
+ * Тип запроса ведущего.
+ * Поддерживаются функции чтения флагов, дискретных входов,
+ * регистров хранения и ввода, записи одного и нескольких
+ * флагов и регистров хранения, изменения регистра по маске
+ * и совмещённой записи и чтения регистров хранения.
+ * Данные запроса - значения регистров (uint16_t)
+ * в порядке байт хоста, либо значения флагов и входов,
+ * упакованные по 8 в байт начиная с младшего бита (uint8_t).
+ * Для функций чтения данные заполняются ответом ведомого.
+ * Для изменения регистра по маске данные - маски И и ИЛИ.
+ * Для совмещённой записи и чтения адрес, число и данные
+ * записываемых регистров задаются отдельно, запись
+ * выполняется ведомым перед чтением.
+ * Нулевой период означает выполнение запроса
+ * в каждом цикле опроса.
+ */
+typedef struct _Modbus_Rtu_Master_Request {
+    modbus_rtu_address_t address; //!< Адрес ведомого.
+    modbus_rtu_func_t func; //!< Функция.
+    uint16_t reg_address; //!< Адрес первого регистра.
+    uint16_t count; //!< Число регистров.
+    void* data; //!< Данные запроса.
+    uint16_t write_address; //!< Адрес первого записываемого регистра.
+    uint16_t write_count; //!< Число записываемых регистров.
+    const uint16_t* write_data; //!< Значения записываемых регистров.
+    struct timeval period; //!< Период запроса.
+    modbus_rtu_master_request_callback_t callback; //!< Каллбэк завершения запроса.
+    void* user_data; //!< Пользовательские данные.
+    // Состояние запроса.
+    struct timeval next_time; //!< Время следующего выполнения.
+    modbus_rtu_master_status_t status; //!< Результат последнего выполнения.
+    modbus_rtu_error_t error; //!< Код исключения ведомого.
+    modbus_rtu_master_slave_stats_t* stats; //!< Статистика ведомого.
+} modbus_rtu_master_request_t;
+
+//! Тип состояния ведущего.
+typedef enum _Modbus_Rtu_Master_State {
+    MODBUS_RTU_MASTER_STATE_STOPPED = 0, //!< Опрос остановлен.
+    MODBUS_RTU_MASTER_STATE_IDLE, //!< Ожидание времени выполнения запросов.
+    MODBUS_RTU_MASTER_STATE_GAP, //!< Выдержка межкадрового интервала.
+    MODBUS_RTU_MASTER_STATE_SENDING, //!< Передача запроса.
+    MODBUS_RTU_MASTER_STATE_WAIT_RESPONSE, //!< Ожидание ответа.
+    MODBUS_RTU_MASTER_STATE_TURNAROUND, //!< Задержка после широковещательного запроса.
+    MODBUS_RTU_MASTER_STATE_PROCESSING //!< Обработка результата.
+} modbus_rtu_master_state_t;
+
+//! Тип ведущего протокола Modbus RTU.
+typedef struct _Modbus_Rtu_Master {
+    modbus_rtu_t* modbus; //!< Протокол Modbus RTU.
+    timers_t* timers; //!< Таймеры.
+    modbus_rtu_master_request_t* requests; //!< Таблица запросов.
+    size_t requests_count; //!< Число запросов.
+    modbus_rtu_master_slave_stats_t* stats; //!< Статистика ведомых.
+    size_t stats_count; //!< Число ведомых.
+    struct timeval gap; //!< Межкадровый интервал.
+    struct timeval timeout; //!< Таймаут ответа.
+    struct timeval turnaround; //!< Задержка после широковещательного запроса.
+    uint8_t retries; //!< Число повторов запроса.
+    volatile modbus_rtu_master_state_t state; //!< Состояние.
+    size_t current; //!< Индекс текущего запроса.
+    uint8_t retry; //!< Номер повтора текущего запроса.
+    bool resend; //!< Флаг повтора текущего запроса.
+    timer_id_t timer; //!< Идентификатор таймера.
+    struct timeval sent_time; //!< Время завершения передачи запроса.
+} modbus_rtu_master_t;
+
+//! Тип структуры инициализации ведущего.
+typedef struct _Modbus_Rtu_Master_Init {
+    modbus_rtu_t* modbus; //!< Протокол Modbus RTU в режиме ведущего.
+    timers_t* timers; //!< Таймеры, NULL для таймеров по-умолчанию.
+    modbus_rtu_master_request_t* requests; //!< Таблица запросов.
+    size_t requests_count; //!< Число запросов.
+    modbus_rtu_master_slave_stats_t* stats; //!< Буфер статистики ведомых.
+    size_t stats_count; //!< Размер буфера статистики.
+    uint32_t baud; //!< Скорость линии, бод.
+    uint32_t timeout_us; //!< Таймаут ответа, мкс, 0 - по-умолчанию.
+    uint32_t turnaround_us; //!< Задержка после широковещательного запроса, мкс, 0 - по-умолчанию.
+    uint8_t retries; //!< Число повторов запроса.
+} modbus_rtu_master_init_t;
+
+
+/**
+ * Инициализирует ведущего.
+ * Проверяет таблицу запросов и назначает
+ * каждому запросу статистику его ведомого.
+ * @param master Ведущий.
+ * @param master_is Структура инициализации.
+ * @return Код ошибки, E_INVALID_VALUE при некорректном
+ * запросе, E_OUT_OF_MEMORY при нехватке буфера статистики.
+ */
+EXTERN err_t modbus_rtu_master_init(modbus_rtu_master_t* master, modbus_rtu_master_init_t* master_is);
+
+/**
+ * Запускает опрос.
+ * Все запросы выполняются немедленно,
+ * далее - согласно их периодам.
+ * @param master Ведущий.
+ * @return Код ошибки.
+ */
+EXTERN err_t modbus_rtu_master_start(modbus_rtu_master_t* master);
+
+/**
+ * Останавливает опрос.
+ * Текущий запрос прерывается без вызова каллбэка.
+ * @param master Ведущий.
+ */
+EXTERN void modbus_rtu_master_stop(modbus_rtu_master_t* master);
+
+/**
+ * Получает флаг выполнения опроса.
+ * @param master Ведущий.
+ * @return Флаг выполнения опроса.
+ */
+ALWAYS_INLINE static bool modbus_rtu_master_running(modbus_rtu_master_t* master)
+{
+    return master->state != MODBUS_RTU_MASTER_STATE_STOPPED;
+}
+
+/**
+ * Выполняет запрос в ближайшем цикле опроса,
+ * независимо от его периода.
+ * @param master Ведущий.
+ * @param request Запрос.
+ */
+EXTERN void modbus_rtu_master_trigger(modbus_rtu_master_t* master, modbus_rtu_master_request_t* request);
+
+/**
+ * Обрабатывает приём сообщения.
+ * Следует вызывать из каллбэка приёма сообщения протокола.
+ * @param master Ведущий.
+ */
+EXTERN void modbus_rtu_master_msg_recv(modbus_rtu_master_t* master);
+
+/**
+ * Обрабатывает завершение передачи сообщения.
+ * Следует вызывать из каллбэка передачи сообщения протокола.
+ * @param master Ведущий.
+ */
+EXTERN void modbus_rtu_master_msg_sent(modbus_rtu_master_t* master);
+
+/**
+ * Получает статистику ведомого.
+ * @param master Ведущий.
+ * @param address Адрес ведомого.
+ * @return Статистика ведомого, либо NULL.
+ */
+EXTERN const modbus_rtu_master_slave_stats_t* modbus_rtu_master_slave_stats(modbus_rtu_master_t* master, modbus_rtu_address_t address);
+
+/**
+ * Получает среднее время ответа ведомого.
+ * @param stats Статистика ведомого.
+ * @return Среднее время ответа, мкс.
+ */
+ALWAYS_INLINE static uint32_t modbus_rtu_master_slave_stats_latency_avg(const modbus_rtu_master_slave_stats_t* stats)
+{
+    if(stats->responses == 0) return 0;
+    return (uint32_t)(stats->latency_sum_us / stats->responses);
+}
+
+/**
+ * Сбрасывает статистику всех ведомых.
+ * @param master Ведущий.
+ */
+EXTERN void modbus_rtu_master_reset_stats(modbus_rtu_master_t* master);
+
+#endif /* MODBUS_RTU_MASTER_H */
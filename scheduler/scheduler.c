@@ -2,39 +2,39 @@
 #include <string.h>
 #include "defs/defs.h"
 #include "utils/critical.h"
+#ifdef USE_SCHEDULER_STATS
+#include "utils/cycles.h"
+#endif
 
 
-typedef struct _Scheduler_t {
-    task_descr_t* tasks_buffer;
-    size_t tasks_buffer_size;
-    list_t tasks_empty;
-    list_t tasks_queued;
-    task_descr_t* current_task;
-    task_id_t max_task_id;
-} scheduler_t;
+#ifdef USE_SCHEDULER_EDF
+//! Сравнение времени с учётом переполнения.
+#define SCHEDULER_TIME_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+#endif
 
-static scheduler_t scheduler;
+//! Планировщик по-умолчанию.
+static scheduler_t scheduler_default_instance;
 
 
-static size_t scheduler_task_id_to_index(task_id_t tid)
+static size_t scheduler_task_id_to_index(scheduler_t* scheduler, task_id_t tid)
 {
-    return (tid - 1) % scheduler.tasks_buffer_size;
+    return (tid - 1) % scheduler->tasks_buffer_size;
 }
 
-static task_id_t scheduler_index_to_next_task_id(size_t index)
+static task_id_t scheduler_index_to_next_task_id(scheduler_t* scheduler, size_t index)
 {
-    task_id_t max_tid = scheduler.max_task_id;
+    task_id_t max_tid = scheduler->max_task_id;
     
     if(max_tid > 0) max_tid --;
     
-    size_t count = max_tid / scheduler.tasks_buffer_size;
+    size_t count = max_tid / scheduler->tasks_buffer_size;
     
-    task_id_t res_tid = index + 1 + count * scheduler.tasks_buffer_size;
+    task_id_t res_tid = index + 1 + count * scheduler->tasks_buffer_size;
     
-    if(res_tid <= scheduler.max_task_id) res_tid += scheduler.tasks_buffer_size;
+    if(res_tid <= scheduler->max_task_id) res_tid += scheduler->tasks_buffer_size;
     
     // Переполнение.
-    if(res_tid < scheduler.max_task_id){
+    if(res_tid < scheduler->max_task_id){
         res_tid = index + 1;
     }
     
@@ -42,131 +42,418 @@ static task_id_t scheduler_index_to_next_task_id(size_t index)
 }
 
 
-static void scheduler_init_descrs(void)
+static void scheduler_init_descrs(scheduler_t* scheduler)
 {
-    list_init(&scheduler.tasks_empty);
-    list_init(&scheduler.tasks_queued);
+    list_init(&scheduler->tasks_empty);
     
-    list_item_t* item;
     size_t i;
     
-    for(i = 0; i < scheduler.tasks_buffer_size; i ++){
-        item = &scheduler.tasks_buffer[i].list_item;
+    for(i = 0; i < SCHEDULER_PRIORITIES_COUNT; i ++){
+        list_init(&scheduler->tasks_queued[i]);
+    }
+    
+    scheduler->tasks_ready_mask = 0;
+    
+    list_item_t* item;
+    
+    for(i = 0; i < scheduler->tasks_buffer_size; i ++){
+        item = &scheduler->tasks_buffer[i].list_item;
         list_item_init_data(item, (void*)i);
-        list_append(&scheduler.tasks_empty, item);
+        list_append(&scheduler->tasks_empty, item);
+    }
+}
+
+ALWAYS_INLINE static task_descr_t* scheduler_task_descr_by_index(scheduler_t* scheduler, size_t index)
+{
+    if(index >= scheduler->tasks_buffer_size) return NULL;
+    return &scheduler->tasks_buffer[index];
+}
+
+ALWAYS_INLINE static size_t scheduler_priority_level(task_priority_t priority)
+{
+    if(priority > TASK_PRIORITY_MAX) return TASK_PRIORITY_MAX;
+    return (size_t)priority;
+}
+
+#ifdef USE_SCHEDULER_EDF
+
+ALWAYS_INLINE static bool scheduler_heap_less(scheduler_heap_t* heap, task_descr_t* a, task_descr_t* b)
+{
+    if(heap->by_release) return SCHEDULER_TIME_BEFORE(a->release, b->release);
+    return SCHEDULER_TIME_BEFORE(a->abs_deadline, b->abs_deadline);
+}
+
+ALWAYS_INLINE static void scheduler_heap_set(scheduler_heap_t* heap, size_t index, task_descr_t* task_descr)
+{
+    heap->items[index] = task_descr;
+    task_descr->heap_index = index;
+}
+
+static void scheduler_heap_sift_up(scheduler_heap_t* heap, size_t index)
+{
+    task_descr_t* task_descr = heap->items[index];
+    size_t parent;
+    
+    while(index > 0){
+        parent = (index - 1) / 2;
+        if(!scheduler_heap_less(heap, task_descr, heap->items[parent])) break;
+        scheduler_heap_set(heap, index, heap->items[parent]);
+        index = parent;
     }
+    
+    scheduler_heap_set(heap, index, task_descr);
 }
 
-ALWAYS_INLINE static task_descr_t* scheduler_task_descr_by_index(size_t index)
+static void scheduler_heap_sift_down(scheduler_heap_t* heap, size_t index)
 {
-    if(index >= scheduler.tasks_buffer_size) return NULL;
-    return &scheduler.tasks_buffer[index];
+    task_descr_t* task_descr = heap->items[index];
+    size_t child;
+    
+    for(;;){
+        child = index * 2 + 1;
+        if(child >= heap->count) break;
+        if(child + 1 < heap->count &&
+           scheduler_heap_less(heap, heap->items[child + 1], heap->items[child])) child ++;
+        if(!scheduler_heap_less(heap, heap->items[child], task_descr)) break;
+        scheduler_heap_set(heap, index, heap->items[child]);
+        index = child;
+    }
+    
+    scheduler_heap_set(heap, index, task_descr);
 }
 
-static int tasks_add_compare(const void* left, const void* right)
+static void scheduler_heap_push(scheduler_heap_t* heap, task_descr_t* task_descr)
 {
-    task_descr_t* ldescr = scheduler_task_descr_by_index((size_t)left);
-    task_descr_t* rdescr = scheduler_task_descr_by_index((size_t)right);
+    // Размер кучи не меньше числа задач EDF.
+    if(heap->count >= heap->size) return;
     
-    if(ldescr == NULL || rdescr == NULL) return 0;
+    heap->items[heap->count] = task_descr;
+    scheduler_heap_sift_up(heap, heap->count ++);
+}
+
+static void scheduler_heap_remove(scheduler_heap_t* heap, task_descr_t* task_descr)
+{
+    size_t index = task_descr->heap_index;
     
-    if(ldescr->priority > rdescr->priority) return -1;
-    //if(ldescr->priority < rdescr->priority) return 1;
-    //return 0;
-    return 1;
+    if(index >= heap->count || heap->items[index] != task_descr) return;
+    
+    heap->count --;
+    
+    if(index == heap->count) return;
+    
+    scheduler_heap_set(heap, index, heap->items[heap->count]);
+    
+    if(index > 0 && scheduler_heap_less(heap, heap->items[index], heap->items[(index - 1) / 2])){
+        scheduler_heap_sift_up(heap, index);
+    }else{
+        scheduler_heap_sift_down(heap, index);
+    }
 }
 
-err_t scheduler_init(task_descr_t* buffer, size_t count)
+ALWAYS_INLINE static task_descr_t* scheduler_heap_top(scheduler_heap_t* heap)
+{
+    if(heap->count == 0) return NULL;
+    return heap->items[0];
+}
+
+/**
+ * Перемещает задачи EDF, время готовности
+ * которых наступило, в кучу готовых задач.
+ * Должна вызываться в критической секции.
+ */
+static void scheduler_edf_release_tasks(scheduler_t* scheduler)
+{
+    scheduler_time_t time = scheduler->get_time_callback();
+    task_descr_t* task_descr;
+    
+    while((task_descr = scheduler_heap_top(&scheduler->edf_pending)) != NULL){
+        if(SCHEDULER_TIME_BEFORE(time, task_descr->release)) break;
+        scheduler_heap_remove(&scheduler->edf_pending, task_descr);
+        scheduler_heap_push(&scheduler->edf_ready, task_descr);
+    }
+}
+
+/**
+ * Определяет, в какой куче находится задача EDF.
+ * @param task_descr Дескриптор задачи.
+ * @return Куча задачи.
+ */
+static scheduler_heap_t* scheduler_edf_task_heap(scheduler_t* scheduler, task_descr_t* task_descr)
+{
+    scheduler_heap_t* heap = &scheduler->edf_ready;
+    size_t index = task_descr->heap_index;
+    
+    if(index < heap->count && heap->items[index] == task_descr) return heap;
+    
+    return &scheduler->edf_pending;
+}
+
+#endif
+
+/**
+ * Помещает задачу в конец очереди её приоритета.
+ * Должна вызываться в критической секции.
+ * @param task_descr Дескриптор задачи.
+ */
+static void scheduler_enqueue_task(scheduler_t* scheduler, task_descr_t* task_descr)
+{
+#ifdef USE_SCHEDULER_EDF
+    if(task_descr->edf){
+        if(SCHEDULER_TIME_BEFORE(scheduler->get_time_callback(), task_descr->release)){
+            scheduler_heap_push(&scheduler->edf_pending, task_descr);
+        }else{
+            scheduler_heap_push(&scheduler->edf_ready, task_descr);
+        }
+        return;
+    }
+#endif
+    
+    size_t level = scheduler_priority_level(task_descr->priority);
+    
+    list_append(&scheduler->tasks_queued[level], &task_descr->list_item);
+    scheduler->tasks_ready_mask |= (1UL << level);
+}
+
+/**
+ * Извлекает задачу из очереди её приоритета.
+ * Должна вызываться в критической секции.
+ * @param task_descr Дескриптор задачи.
+ */
+static void scheduler_dequeue_task(scheduler_t* scheduler, task_descr_t* task_descr)
+{
+#ifdef USE_SCHEDULER_EDF
+    if(task_descr->edf){
+        scheduler_heap_remove(scheduler_edf_task_heap(scheduler, task_descr), task_descr);
+        return;
+    }
+#endif
+    
+    size_t level = scheduler_priority_level(task_descr->priority);
+    list_t* queue = &scheduler->tasks_queued[level];
+    
+    list_remove(queue, &task_descr->list_item);
+    
+    if(list_empty(queue)) scheduler->tasks_ready_mask &= ~(1UL << level);
+}
+
+err_t scheduler_instance_init(scheduler_t* scheduler, task_descr_t* buffer, size_t count)
 {
     if(buffer == NULL) return E_NULL_POINTER;
     if(count == 0) return E_INVALID_VALUE;
     
-    memset(&scheduler, 0x0, sizeof(scheduler_t));
+    memset(scheduler, 0x0, sizeof(scheduler_t));
     
-    scheduler.tasks_buffer = buffer;
-    scheduler.tasks_buffer_size = count;
-    scheduler.max_task_id = 0;
+    scheduler->tasks_buffer = buffer;
+    scheduler->tasks_buffer_size = count;
+    scheduler->max_task_id = 0;
     
-    scheduler_init_descrs();
+    scheduler_init_descrs(scheduler);
     
     return E_NO_ERROR;
 }
 
-task_id_t scheduler_current_task_id(void)
+task_id_t scheduler_instance_current_task_id(scheduler_t* scheduler)
 {
-    if(scheduler.current_task == NULL) return INVALID_TASK_ID;
-    return scheduler.current_task->tid;
+    if(scheduler->current_task == NULL) return INVALID_TASK_ID;
+    return scheduler->current_task->tid;
 }
 
-task_id_t scheduler_add_task(task_proc_t proc, task_priority_t priority, void* arg, task_flags_t flags, future_t* future)
+size_t scheduler_instance_tasks_count(scheduler_t* scheduler)
+{
+    return scheduler->tasks_buffer_size - list_size(&scheduler->tasks_empty);
+}
+
+/**
+ * Получает свободный дескриптор задачи и заполняет его.
+ * @param proc Функция задачи.
+ * @param arg Аргумент задачи.
+ * @param flags Флаги задачи.
+ * @param future Будущее задачи.
+ * @return Дескриптор задачи, NULL при отсутствии свободных.
+ */
+static task_descr_t* scheduler_alloc_task(scheduler_t* scheduler, task_proc_t proc, void* arg, task_flags_t flags, future_t* future)
 {
-    if(proc == NULL) return INVALID_TASK_ID;
-    
     list_item_t* task_item = NULL;
     size_t task_index = 0;
     
     CRITICAL_ENTER();
     
-    task_item = list_head(&scheduler.tasks_empty);
+    task_item = list_head(&scheduler->tasks_empty);
     
     if(task_item == NULL){
         CRITICAL_EXIT();
-        return INVALID_TASK_ID;
+        return NULL;
     }
     
-    list_remove(&scheduler.tasks_empty, task_item);
+    list_remove(&scheduler->tasks_empty, task_item);
     
     CRITICAL_EXIT();
     
     task_index = (size_t)list_item_data(task_item);
     
-    task_descr_t* descr = scheduler_task_descr_by_index(task_index);
+    task_descr_t* descr = scheduler_task_descr_by_index(scheduler, task_index);
     
     if(descr == NULL){
         CRITICAL_ENTER();
-        
-        list_append(&scheduler.tasks_empty, task_item);
-        
+    
+        list_append(&scheduler->tasks_empty, task_item);
+    
         CRITICAL_EXIT();
-        
-        return INVALID_TASK_ID;
+    
+        return NULL;
     }
     
     descr->proc = proc;
-    descr->priority = priority;
+    descr->priority = 0;
     descr->arg = arg;
     descr->future = future;
-    descr->flags = flags;
+    descr->flags = flags & ~(TASK_SUSPENDED | TASK_REMOVED);
+    
+#ifdef USE_SCHEDULER_STATS
+    memset(&descr->stats, 0x0, sizeof(task_stats_t));
+    descr->add_time = cycles_get();
+    descr->waiting = true;
+#endif
+    
+#ifdef USE_SCHEDULER_EDF
+    descr->edf = false;
+#endif
     
     if(descr->future){
         future_init(descr->future);
     }
     
+    return descr;
+}
+
+/**
+ * Назначает задаче идентификатор и помещает её в очередь.
+ * @param descr Дескриптор задачи.
+ * @return Идентификатор задачи.
+ */
+static task_id_t scheduler_start_task(scheduler_t* scheduler, task_descr_t* descr)
+{
+    size_t task_index = (size_t)list_item_data(&descr->list_item);
+    
     CRITICAL_ENTER();
     
-    descr->tid = scheduler_index_to_next_task_id(task_index);
-    scheduler.max_task_id = descr->tid;
-    list_insert_sorted(&scheduler.tasks_queued, task_item, tasks_add_compare);
+    descr->tid = scheduler_index_to_next_task_id(scheduler, task_index);
+    scheduler->max_task_id = descr->tid;
+    scheduler_enqueue_task(scheduler, descr);
     
     CRITICAL_EXIT();
     
     return descr->tid;
 }
 
-static void scheduler_remove_task_impl(task_descr_t* task_descr)
+task_id_t scheduler_instance_add_task(scheduler_t* scheduler, task_proc_t proc, task_priority_t priority, void* arg, task_flags_t flags, future_t* future)
+{
+    if(proc == NULL) return INVALID_TASK_ID;
+    
+    task_descr_t* descr = scheduler_alloc_task(scheduler, proc, arg, flags, future);
+    
+    if(descr == NULL) return INVALID_TASK_ID;
+    
+    descr->priority = priority;
+    
+    return scheduler_start_task(scheduler, descr);
+}
+
+#ifdef USE_SCHEDULER_EDF
+
+err_t scheduler_instance_edf_init(scheduler_t* scheduler, task_descr_t** ready_heap, task_descr_t** pending_heap, size_t size, scheduler_get_time_callback_t get_time)
+{
+    if(ready_heap == NULL || pending_heap == NULL) return E_NULL_POINTER;
+    if(get_time == NULL) return E_NULL_POINTER;
+    if(size == 0) return E_INVALID_VALUE;
+    
+    scheduler->edf_ready.items = ready_heap;
+    scheduler->edf_ready.size = size;
+    scheduler->edf_ready.count = 0;
+    scheduler->edf_ready.by_release = false;
+    
+    scheduler->edf_pending.items = pending_heap;
+    scheduler->edf_pending.size = size;
+    scheduler->edf_pending.count = 0;
+    scheduler->edf_pending.by_release = true;
+    
+    scheduler->edf_count = 0;
+    scheduler->get_time_callback = get_time;
+    scheduler->edf_misses = 0;
+    
+    return E_NO_ERROR;
+}
+
+task_id_t scheduler_instance_add_edf_task(scheduler_t* scheduler, task_proc_t proc, void* arg, scheduler_time_t period, scheduler_time_t deadline, future_t* future)
+{
+    if(proc == NULL) return INVALID_TASK_ID;
+    if(scheduler->get_time_callback == NULL) return INVALID_TASK_ID;
+    
+    task_descr_t* descr = scheduler_alloc_task(scheduler, proc, arg, (period == 0) ? TASK_RUN_ONCE : 0, future);
+    
+    if(descr == NULL) return INVALID_TASK_ID;
+    
+    CRITICAL_ENTER();
+    
+    // Каждая из куч должна вмещать все задачи EDF.
+    if(scheduler->edf_count >= scheduler->edf_ready.size){
+        list_append(&scheduler->tasks_empty, &descr->list_item);
+    
+        CRITICAL_EXIT();
+    
+        return INVALID_TASK_ID;
+    }
+    
+    scheduler->edf_count ++;
+    
+    CRITICAL_EXIT();
+    
+    descr->edf = true;
+    descr->period = period;
+    descr->deadline = deadline;
+    descr->release = scheduler->get_time_callback();
+    descr->abs_deadline = descr->release + deadline;
+    descr->misses = 0;
+    
+    return scheduler_start_task(scheduler, descr);
+}
+
+uint32_t scheduler_instance_edf_task_misses(scheduler_t* scheduler, task_id_t tid)
+{
+    if(tid == INVALID_TASK_ID) return 0;
+    
+    task_descr_t* task_descr = scheduler_task_descr_by_index(scheduler, scheduler_task_id_to_index(scheduler, tid));
+    
+    if(task_descr == NULL || task_descr->tid != tid || !task_descr->edf) return 0;
+    
+    return task_descr->misses;
+}
+
+uint32_t scheduler_instance_edf_misses(scheduler_t* scheduler)
+{
+    return scheduler->edf_misses;
+}
+
+#endif
+
+static void scheduler_remove_task_impl(scheduler_t* scheduler, task_descr_t* task_descr)
 {
     task_descr->tid = INVALID_TASK_ID;
-    list_remove(&scheduler.tasks_queued, &task_descr->list_item);
-    list_append(&scheduler.tasks_empty, &task_descr->list_item);
+    // Приостановленная задача не находится в очереди.
+    if(!(task_descr->flags & TASK_SUSPENDED)) scheduler_dequeue_task(scheduler, task_descr);
+#ifdef USE_SCHEDULER_EDF
+    if(task_descr->edf) scheduler->edf_count --;
+#endif
+    list_append(&scheduler->tasks_empty, &task_descr->list_item);
 }
 
-bool scheduler_remove_task(task_id_t tid)
+bool scheduler_instance_remove_task(scheduler_t* scheduler, task_id_t tid)
 {
     if(tid == INVALID_TASK_ID) return false;
     
-    size_t task_index = scheduler_task_id_to_index(tid);
+    size_t task_index = scheduler_task_id_to_index(scheduler, tid);
     
-    task_descr_t* task_descr = scheduler_task_descr_by_index(task_index);
+    task_descr_t* task_descr = scheduler_task_descr_by_index(scheduler, task_index);
     
     if(task_descr == NULL){
         return false;
@@ -176,10 +463,10 @@ bool scheduler_remove_task(task_id_t tid)
     
     CRITICAL_ENTER();
     
-    if(task_descr == scheduler.current_task){
-        task_descr->flags |= TASK_RUN_ONCE;
+    if(task_descr == scheduler->current_task){
+        task_descr->flags |= TASK_REMOVED;
     }else{
-        scheduler_remove_task_impl(task_descr);
+        scheduler_remove_task_impl(scheduler, task_descr);
     }
     
     CRITICAL_EXIT();
@@ -187,79 +474,350 @@ bool scheduler_remove_task(task_id_t tid)
     return true;
 }
 
-static task_descr_t* scheduler_first_task(void)
+/**
+ * Получает дескриптор добавленной задачи по идентификатору.
+ * @param tid Идентификатор задачи.
+ * @return Дескриптор задачи, NULL если задача не найдена.
+ */
+static task_descr_t* scheduler_task_descr_by_id(scheduler_t* scheduler, task_id_t tid)
 {
-    list_item_t* task_item = list_head(&scheduler.tasks_queued);
-    if(task_item == NULL) return NULL;
-    return scheduler_task_descr_by_index((size_t)list_item_data(task_item));
+    if(tid == INVALID_TASK_ID) return NULL;
+    
+    task_descr_t* task_descr = scheduler_task_descr_by_index(scheduler, scheduler_task_id_to_index(scheduler, tid));
+    
+    if(task_descr == NULL || task_descr->tid != tid) return NULL;
+    
+    return task_descr;
+}
+
+bool scheduler_instance_suspend_task(scheduler_t* scheduler, task_id_t tid)
+{
+    CRITICAL_ENTER();
+    
+    task_descr_t* task_descr = scheduler_task_descr_by_id(scheduler, tid);
+    
+    if(task_descr == NULL){
+        CRITICAL_EXIT();
+        return false;
+    }
+    
+    if(!(task_descr->flags & TASK_SUSPENDED)){
+        // Текущая задача извлекается из очереди после выполнения.
+        if(task_descr != scheduler->current_task) scheduler_dequeue_task(scheduler, task_descr);
+        task_descr->flags |= TASK_SUSPENDED;
+    }
+    
+    CRITICAL_EXIT();
+    
+    return true;
+}
+
+bool scheduler_instance_resume_task(scheduler_t* scheduler, task_id_t tid)
+{
+    CRITICAL_ENTER();
+    
+    task_descr_t* task_descr = scheduler_task_descr_by_id(scheduler, tid);
+    
+    if(task_descr == NULL){
+        CRITICAL_EXIT();
+        return false;
+    }
+    
+    if(task_descr->flags & TASK_SUSPENDED){
+        task_descr->flags &= ~TASK_SUSPENDED;
+        if(task_descr != scheduler->current_task) scheduler_enqueue_task(scheduler, task_descr);
+    }
+    
+    CRITICAL_EXIT();
+    
+    return true;
 }
 
-static task_descr_t* scheduler_next_task(task_descr_t* task_descr)
+/**
+ * Получает первую задачу очереди наибольшего приоритета.
+ * Готовые задачи EDF выбираются раньше задач с приоритетами.
+ * Должна вызываться в критической секции.
+ * @return Дескриптор задачи.
+ */
+static task_descr_t* scheduler_first_task(scheduler_t* scheduler)
 {
-    list_item_t* task_item = list_next(&task_descr->list_item);
+#ifdef USE_SCHEDULER_EDF
+    if(scheduler->get_time_callback){
+        scheduler_edf_release_tasks(scheduler);
+        
+        task_descr_t* task_descr = scheduler_heap_top(&scheduler->edf_ready);
+        if(task_descr != NULL) return task_descr;
+    }
+#endif
+    
+    if(scheduler->tasks_ready_mask == 0) return NULL;
+    
+    size_t level = 31 - __builtin_clz(scheduler->tasks_ready_mask);
+    
+    list_item_t* task_item = list_head(&scheduler->tasks_queued[level]);
     if(task_item == NULL) return NULL;
-    return scheduler_task_descr_by_index((size_t)list_item_data(task_item));
+    return scheduler_task_descr_by_index(scheduler, (size_t)list_item_data(task_item));
 }
 
-static task_descr_t* scheduler_select_task_by_priority(task_descr_t* task_descr_l, task_descr_t* task_descr_r)
+#ifdef USE_SCHEDULER_WORK_QUEUE
+
+void scheduler_instance_set_work_queue(scheduler_t* scheduler, work_queue_t* queue)
 {
-    if(task_descr_l->priority > task_descr_r->priority) return task_descr_l;
-    return task_descr_r;
+    scheduler->work_queue = queue;
 }
 
-bool scheduler_process(void)
+#endif
+
+bool scheduler_instance_process(scheduler_t* scheduler)
 {
-    if(list_empty(&scheduler.tasks_queued)) return false;
+#ifdef USE_SCHEDULER_WORK_QUEUE
+    size_t works_count = 0;
     
-    task_descr_t* cur_task = NULL;
+    if(scheduler->work_queue) works_count = work_queue_process(scheduler->work_queue);
+#endif
     
-    if(scheduler.current_task){
-        cur_task = scheduler.current_task;
-    }else{
-        cur_task = scheduler_first_task();
-        if(cur_task == NULL) return false;
-        scheduler.current_task = cur_task;
+    CRITICAL_ENTER();
+    
+    task_descr_t* cur_task = scheduler_first_task(scheduler);
+    
+    scheduler->current_task = cur_task;
+    
+    CRITICAL_EXIT();
+    
+#ifdef USE_SCHEDULER_WORK_QUEUE
+    if(cur_task == NULL) return works_count != 0;
+#else
+    if(cur_task == NULL) return false;
+#endif
+    
+#ifdef USE_SCHEDULER_STATS
+    uint32_t start_time = cycles_get();
+    
+    if(cur_task->waiting){
+        cur_task->stats.wait_time = start_time - cur_task->add_time;
+        cur_task->waiting = false;
     }
+#endif
+    
+    void* result;
     
     if(!cur_task->future){
-        cur_task->proc(cur_task->arg);
+        result = cur_task->proc(cur_task->arg);
     }else{
         future_start(cur_task->future);
-        void* result = cur_task->proc(cur_task->arg);
-        future_finish(cur_task->future, result);
+        result = cur_task->proc(cur_task->arg);
+        if(result != TASK_YIELD) future_finish(cur_task->future, result);
     }
     
-    task_descr_t* next_task = scheduler_next_task(cur_task);
+#ifdef USE_SCHEDULER_STATS
+    uint32_t run_time = cycles_get() - start_time;
     
-    if(cur_task->flags & TASK_RUN_ONCE){
-        CRITICAL_ENTER();
-        
-        scheduler_remove_task_impl(cur_task);
-        
+    cur_task->stats.run_count ++;
+    cur_task->stats.run_time += run_time;
+    if(run_time > cur_task->stats.run_time_max) cur_task->stats.run_time_max = run_time;
+#endif
+    
+    CRITICAL_ENTER();
+    
+    scheduler_dequeue_task(scheduler, cur_task);
+    
+#ifdef USE_SCHEDULER_EDF
+    // Завершение задания задачи EDF.
+    if(cur_task->edf && result != TASK_YIELD){
+        if(SCHEDULER_TIME_BEFORE(cur_task->abs_deadline, scheduler->get_time_callback())){
+            cur_task->misses ++;
+            scheduler->edf_misses ++;
+        }
+        cur_task->release += cur_task->period;
+        cur_task->abs_deadline = cur_task->release + cur_task->deadline;
+    }
+#endif
+    
+    if((cur_task->flags & TASK_REMOVED) ||
+       ((cur_task->flags & TASK_RUN_ONCE) && result != TASK_YIELD)){
+        cur_task->flags &= ~(TASK_SUSPENDED | TASK_REMOVED);
+        cur_task->tid = INVALID_TASK_ID;
+#ifdef USE_SCHEDULER_EDF
+        if(cur_task->edf) scheduler->edf_count --;
+#endif
+        list_append(&scheduler->tasks_empty, &cur_task->list_item);
+    }else if(!(cur_task->flags & TASK_SUSPENDED)){
+        // Перемещение в конец очереди для поочерёдного
+        // выполнения задач одного приоритета.
+        scheduler_enqueue_task(scheduler, cur_task);
+    }
+    
+    scheduler->current_task = NULL;
+    
+    CRITICAL_EXIT();
+    
+    return true;
+}
+
+#ifdef USE_SCHEDULER_STATS
+
+err_t scheduler_instance_task_stats(scheduler_t* scheduler, task_id_t tid, task_stats_t* stats)
+{
+    if(stats == NULL) return E_NULL_POINTER;
+    if(tid == INVALID_TASK_ID) return E_INVALID_VALUE;
+    
+    task_descr_t* task_descr = scheduler_task_descr_by_index(scheduler, scheduler_task_id_to_index(scheduler, tid));
+    
+    if(task_descr == NULL) return E_INVALID_VALUE;
+    
+    CRITICAL_ENTER();
+    
+    if(task_descr->tid != tid){
         CRITICAL_EXIT();
+        return E_INVALID_VALUE;
     }
     
-    task_descr_t* first_task = scheduler_first_task();
+    memcpy(stats, &task_descr->stats, sizeof(task_stats_t));
     
-    if(next_task == NULL){
-        cur_task = first_task;
-    }else{
-        if(first_task != NULL){
-            cur_task = scheduler_select_task_by_priority(first_task, next_task);
-        }// Ошибочное состояние.
-        else{
-            CRITICAL_ENTER();
-            
-            // Сбросим задачи.
-            scheduler_init_descrs();
-            
-            CRITICAL_EXIT();
-            
-            cur_task = NULL;
+    CRITICAL_EXIT();
+    
+    return E_NO_ERROR;
+}
+
+size_t scheduler_instance_stats_snapshot(scheduler_t* scheduler, task_stats_snapshot_t* snapshot, size_t count)
+{
+    if(snapshot == NULL) return 0;
+    
+    task_descr_t* task_descr;
+    size_t n = 0;
+    size_t i;
+    
+    for(i = 0; i < scheduler->tasks_buffer_size && n < count; i ++){
+        task_descr = &scheduler->tasks_buffer[i];
+        
+        CRITICAL_ENTER();
+        
+        if(task_descr->tid != INVALID_TASK_ID){
+            snapshot[n].tid = task_descr->tid;
+            snapshot[n].proc = task_descr->proc;
+            snapshot[n].priority = task_descr->priority;
+            memcpy(&snapshot[n].stats, &task_descr->stats, sizeof(task_stats_t));
+            n ++;
         }
+        
+        CRITICAL_EXIT();
     }
     
-    scheduler.current_task = cur_task;
+    return n;
+}
+
+void scheduler_instance_reset_stats(scheduler_t* scheduler)
+{
+    task_descr_t* task_descr;
+    size_t i;
     
-    return true;
+    for(i = 0; i < scheduler->tasks_buffer_size; i ++){
+        task_descr = &scheduler->tasks_buffer[i];
+        
+        CRITICAL_ENTER();
+        
+        memset(&task_descr->stats, 0x0, sizeof(task_stats_t));
+        
+        CRITICAL_EXIT();
+    }
+}
+
+#endif
+
+
+scheduler_t* scheduler_default(void)
+{
+    return &scheduler_default_instance;
+}
+
+err_t scheduler_init(task_descr_t* buffer, size_t count)
+{
+    return scheduler_instance_init(&scheduler_default_instance, buffer, count);
+}
+
+task_id_t scheduler_current_task_id(void)
+{
+    return scheduler_instance_current_task_id(&scheduler_default_instance);
+}
+
+size_t scheduler_tasks_count(void)
+{
+    return scheduler_instance_tasks_count(&scheduler_default_instance);
+}
+
+task_id_t scheduler_add_task(task_proc_t proc, task_priority_t priority, void* arg, task_flags_t flags, future_t* future)
+{
+    return scheduler_instance_add_task(&scheduler_default_instance, proc, priority, arg, flags, future);
+}
+
+bool scheduler_remove_task(task_id_t tid)
+{
+    return scheduler_instance_remove_task(&scheduler_default_instance, tid);
+}
+
+bool scheduler_suspend_task(task_id_t tid)
+{
+    return scheduler_instance_suspend_task(&scheduler_default_instance, tid);
 }
+
+bool scheduler_resume_task(task_id_t tid)
+{
+    return scheduler_instance_resume_task(&scheduler_default_instance, tid);
+}
+
+bool scheduler_process(void)
+{
+    return scheduler_instance_process(&scheduler_default_instance);
+}
+
+#ifdef USE_SCHEDULER_EDF
+
+err_t scheduler_edf_init(task_descr_t** ready_heap, task_descr_t** pending_heap, size_t size, scheduler_get_time_callback_t get_time)
+{
+    return scheduler_instance_edf_init(&scheduler_default_instance, ready_heap, pending_heap, size, get_time);
+}
+
+task_id_t scheduler_add_edf_task(task_proc_t proc, void* arg, scheduler_time_t period, scheduler_time_t deadline, future_t* future)
+{
+    return scheduler_instance_add_edf_task(&scheduler_default_instance, proc, arg, period, deadline, future);
+}
+
+uint32_t scheduler_edf_task_misses(task_id_t tid)
+{
+    return scheduler_instance_edf_task_misses(&scheduler_default_instance, tid);
+}
+
+uint32_t scheduler_edf_misses(void)
+{
+    return scheduler_instance_edf_misses(&scheduler_default_instance);
+}
+
+#endif
+
+#ifdef USE_SCHEDULER_WORK_QUEUE
+
+void scheduler_set_work_queue(work_queue_t* queue)
+{
+    scheduler_instance_set_work_queue(&scheduler_default_instance, queue);
+}
+
+#endif
+
+#ifdef USE_SCHEDULER_STATS
+
+err_t scheduler_task_stats(task_id_t tid, task_stats_t* stats)
+{
+    return scheduler_instance_task_stats(&scheduler_default_instance, tid, stats);
+}
+
+size_t scheduler_stats_snapshot(task_stats_snapshot_t* snapshot, size_t count)
+{
+    return scheduler_instance_stats_snapshot(&scheduler_default_instance, snapshot, count);
+}
+
+void scheduler_reset_stats(void)
+{
+    scheduler_instance_reset_stats(&scheduler_default_instance);
+}
+
+#endif
@@ -1,6 +1,20 @@
 /**
  * @file scheduler.h Библиотека планировщика задач.
  * Используются приоритеты и кооперативная многозадачность.
+ * При определении USE_SCHEDULER_STATS ведётся статистика
+ * выполнения задач, время измеряется счётчиком тактов
+ * (см. utils/cycles.h), который должен быть предварительно
+ * запущен функцией cycles_init().
+ * При определении USE_SCHEDULER_EDF доступны периодические
+ * задачи с относительным сроком выполнения, выполняемые
+ * в порядке ближайшего абсолютного срока (EDF) раньше
+ * задач с приоритетами; нарушения сроков подсчитываются.
+ * При определении USE_SCHEDULER_WORK_QUEUE планировщик
+ * выполняет вызовы, отложенные прерываниями в очередь
+ * work_queue_t, перед запуском очередной задачи.
+ * Функции scheduler_instance_* работают с заданным
+ * экземпляром планировщика, остальные функции - с
+ * экземпляром по-умолчанию (см. scheduler_default).
  */
 
 #ifndef SCHEDULER_H
@@ -13,6 +27,9 @@
 #include "errors/errors.h"
 #include "list/list.h"
 #include "defs/defs.h"
+#ifdef USE_SCHEDULER_WORK_QUEUE
+#include "work_queue/work_queue.h"
+#endif
 
 
 //! Ошибочный идентификатор задачи.
@@ -25,16 +42,71 @@ typedef uint32_t task_id_t;
 //! Тип приоритета задачи.
 typedef uint32_t task_priority_t;
 
+//! Число уровней приоритета.
+#define SCHEDULER_PRIORITIES_COUNT 32
+
+/**
+ * Максимальный приоритет задачи.
+ * Задачи с большим приоритетом выполняются
+ * с приоритетом TASK_PRIORITY_MAX.
+ */
+#define TASK_PRIORITY_MAX (SCHEDULER_PRIORITIES_COUNT - 1)
+
 //! Тип функции задачи.
 typedef void* (*task_proc_t)(void*);
 
+#ifdef USE_SCHEDULER_EDF
+
+//! Тип времени планировщика EDF.
+typedef uint32_t scheduler_time_t;
+
+/**
+ * Функция обратного вызова получения текущего времени.
+ * Время монотонно возрастает с переполнением,
+ * единицы измерения определяются пользователем.
+ * @return Текущее время.
+ */
+typedef scheduler_time_t (*scheduler_get_time_callback_t)(void);
+
+#endif
+
+/**
+ * Результат функции задачи, означающий,
+ * что задача не завершена и будет продолжена.
+ * Будущее задачи при этом не завершается,
+ * однократная задача не удаляется.
+ */
+#define TASK_YIELD ((void*)-1)
+
 typedef enum _Task_Flag {
-    TASK_RUN_ONCE = 1
+    TASK_RUN_ONCE = 1,
+    TASK_SUSPENDED = 2, //!< Задача приостановлена (устанавливается планировщиком).
+    TASK_REMOVED = 4 //!< Задача удалена во время выполнения (устанавливается планировщиком).
 } task_flag_t;
 
 //! Тип флагов задачи.
 typedef uint32_t task_flags_t;
 
+#ifdef USE_SCHEDULER_STATS
+
+//! Тип статистики выполнения задачи.
+typedef struct _Task_Stats {
+    uint32_t run_count; //!< Число запусков.
+    uint64_t run_time; //!< Суммарное время выполнения в тактах.
+    uint32_t run_time_max; //!< Максимальное время выполнения в тактах.
+    uint32_t wait_time; //!< Время от добавления до первого запуска в тактах.
+} task_stats_t;
+
+//! Тип снимка статистики задачи.
+typedef struct _Task_Stats_Snapshot {
+    task_id_t tid; //!< Идентификатор задачи.
+    task_proc_t proc; //!< Функция задачи.
+    task_priority_t priority; //!< Приоритет задачи.
+    task_stats_t stats; //!< Статистика задачи.
+} task_stats_snapshot_t;
+
+#endif
+
 //! Тип дескриптора задачи.
 typedef struct _Task_Descr_t {
     list_item_t list_item; //!< Элемент списка задач.
@@ -44,11 +116,125 @@ typedef struct _Task_Descr_t {
     void* arg; //!< Аргумент задачи.
     future_t* future; //!< Будущее задачи.
     task_flags_t flags; //!< Флаги задачи.
+#ifdef USE_SCHEDULER_STATS
+    task_stats_t stats; //!< Статистика задачи.
+    uint32_t add_time; //!< Время добавления задачи.
+    bool waiting; //!< Флаг ожидания первого запуска.
+#endif
+#ifdef USE_SCHEDULER_EDF
+    bool edf; //!< Флаг задачи EDF.
+    scheduler_time_t period; //!< Период задачи.
+    scheduler_time_t deadline; //!< Относительный срок выполнения.
+    scheduler_time_t release; //!< Время готовности текущего задания.
+    scheduler_time_t abs_deadline; //!< Абсолютный срок выполнения текущего задания.
+    size_t heap_index; //!< Индекс в куче задач EDF.
+    uint32_t misses; //!< Число нарушений срока выполнения.
+#endif
 } task_descr_t;
 
 //! Декларация буфера задач.
 #define TASKS_BUFFER(name, size) task_descr_t name[size]
 
+#ifdef USE_SCHEDULER_EDF
+//! Декларация буфера кучи задач EDF.
+#define TASKS_EDF_HEAP_BUFFER(name, size) task_descr_t* name[size]
+
+//! Тип кучи задач EDF.
+typedef struct _Scheduler_Heap {
+    task_descr_t** items; //!< Элементы кучи.
+    size_t size; //!< Размер буфера кучи.
+    size_t count; //!< Число элементов.
+    bool by_release; //!< Упорядочение по времени готовности.
+} scheduler_heap_t;
+#endif
+
+//! Тип планировщика.
+typedef struct _Scheduler_t {
+    task_descr_t* tasks_buffer; //!< Буфер дескрипторов задач.
+    size_t tasks_buffer_size; //!< Число дескрипторов задач.
+    list_t tasks_empty; //!< Свободные дескрипторы.
+    list_t tasks_queued[SCHEDULER_PRIORITIES_COUNT]; //!< Очереди задач по приоритетам.
+    uint32_t tasks_ready_mask; //!< Битовая карта непустых очередей.
+    task_descr_t* current_task; //!< Текущая задача.
+    task_id_t max_task_id; //!< Последний выданный идентификатор задачи.
+#ifdef USE_SCHEDULER_EDF
+    scheduler_heap_t edf_ready; //!< Готовые задачи EDF по абсолютному сроку.
+    scheduler_heap_t edf_pending; //!< Ожидающие задачи EDF по времени готовности.
+    size_t edf_count; //!< Число задач EDF.
+    scheduler_get_time_callback_t get_time_callback; //!< Функция получения времени.
+    uint32_t edf_misses; //!< Общее число нарушений сроков.
+#endif
+#ifdef USE_SCHEDULER_WORK_QUEUE
+    work_queue_t* work_queue; //!< Очередь отложенных вызовов.
+#endif
+} scheduler_t;
+
+/**
+ * Получает планировщик по-умолчанию.
+ * @return Планировщик по-умолчанию.
+ */
+EXTERN scheduler_t* scheduler_default(void);
+
+//! Аналогична scheduler_init для заданного планировщика.
+EXTERN err_t scheduler_instance_init(scheduler_t* scheduler, task_descr_t* buffer, size_t count);
+
+//! Аналогична scheduler_current_task_id для заданного планировщика.
+EXTERN task_id_t scheduler_instance_current_task_id(scheduler_t* scheduler);
+
+//! Аналогична scheduler_tasks_count для заданного планировщика.
+EXTERN size_t scheduler_instance_tasks_count(scheduler_t* scheduler);
+
+//! Аналогична scheduler_add_task для заданного планировщика.
+EXTERN task_id_t scheduler_instance_add_task(scheduler_t* scheduler, task_proc_t proc, task_priority_t priority, void* arg, task_flags_t flags, future_t* future);
+
+//! Аналогична scheduler_remove_task для заданного планировщика.
+EXTERN bool scheduler_instance_remove_task(scheduler_t* scheduler, task_id_t tid);
+
+//! Аналогична scheduler_suspend_task для заданного планировщика.
+EXTERN bool scheduler_instance_suspend_task(scheduler_t* scheduler, task_id_t tid);
+
+//! Аналогична scheduler_resume_task для заданного планировщика.
+EXTERN bool scheduler_instance_resume_task(scheduler_t* scheduler, task_id_t tid);
+
+//! Аналогична scheduler_process для заданного планировщика.
+EXTERN bool scheduler_instance_process(scheduler_t* scheduler);
+
+#ifdef USE_SCHEDULER_EDF
+
+//! Аналогична scheduler_edf_init для заданного планировщика.
+EXTERN err_t scheduler_instance_edf_init(scheduler_t* scheduler, task_descr_t** ready_heap, task_descr_t** pending_heap, size_t size, scheduler_get_time_callback_t get_time);
+
+//! Аналогична scheduler_add_edf_task для заданного планировщика.
+EXTERN task_id_t scheduler_instance_add_edf_task(scheduler_t* scheduler, task_proc_t proc, void* arg, scheduler_time_t period, scheduler_time_t deadline, future_t* future);
+
+//! Аналогична scheduler_edf_task_misses для заданного планировщика.
+EXTERN uint32_t scheduler_instance_edf_task_misses(scheduler_t* scheduler, task_id_t tid);
+
+//! Аналогична scheduler_edf_misses для заданного планировщика.
+EXTERN uint32_t scheduler_instance_edf_misses(scheduler_t* scheduler);
+
+#endif
+
+#ifdef USE_SCHEDULER_WORK_QUEUE
+
+//! Аналогична scheduler_set_work_queue для заданного планировщика.
+EXTERN void scheduler_instance_set_work_queue(scheduler_t* scheduler, work_queue_t* queue);
+
+#endif
+
+#ifdef USE_SCHEDULER_STATS
+
+//! Аналогична scheduler_task_stats для заданного планировщика.
+EXTERN err_t scheduler_instance_task_stats(scheduler_t* scheduler, task_id_t tid, task_stats_t* stats);
+
+//! Аналогична scheduler_stats_snapshot для заданного планировщика.
+EXTERN size_t scheduler_instance_stats_snapshot(scheduler_t* scheduler, task_stats_snapshot_t* snapshot, size_t count);
+
+//! Аналогична scheduler_reset_stats для заданного планировщика.
+EXTERN void scheduler_instance_reset_stats(scheduler_t* scheduler);
+
+#endif
+
 /**
  * Инициализирует планеровщик.
  * Планеровщик использует буфер дескрипторов
@@ -67,6 +253,12 @@ EXTERN err_t scheduler_init(task_descr_t* buffer, size_t count);
  */
 EXTERN task_id_t scheduler_current_task_id(void);
 
+/**
+ * Получает число добавленных задач.
+ * @return Число добавленных задач.
+ */
+EXTERN size_t scheduler_tasks_count(void);
+
 /**
  * Добавляет задачу.
  * @param proc Функция задачи.
@@ -83,11 +275,114 @@ EXTERN task_id_t scheduler_add_task(task_proc_t proc, task_priority_t priority,
  */
 EXTERN bool scheduler_remove_task(task_id_t tid);
 
+/**
+ * Приостанавливает задачу.
+ * Приостановленная задача не запускается до возобновления.
+ * Приостановка текущей задачи вступает в силу
+ * после возврата из её функции.
+ * @param tid Идентификатор задачи.
+ * @return Флаг приостановки задачи.
+ */
+EXTERN bool scheduler_suspend_task(task_id_t tid);
+
+/**
+ * Возобновляет приостановленную задачу.
+ * Может вызываться из прерывания.
+ * @param tid Идентификатор задачи.
+ * @return Флаг возобновления задачи.
+ */
+EXTERN bool scheduler_resume_task(task_id_t tid);
+
+#ifdef USE_SCHEDULER_WORK_QUEUE
+
+/**
+ * Устанавливает очередь отложенных вызовов,
+ * выполняемых планировщиком.
+ * @param queue Очередь, NULL для отключения.
+ */
+EXTERN void scheduler_set_work_queue(work_queue_t* queue);
+
+#endif
+
 /**
  * Главный цикл планеровщика.
  * Запускает очередную задачу.
- * @return Флаг запуска задачи, false если задач нет.
+ * Выбирается задача с наибольшим приоритетом,
+ * задачи с одинаковым приоритетом выполняются по очереди.
+ * Предварительно выполняются отложенные вызовы
+ * (при определении USE_SCHEDULER_WORK_QUEUE).
+ * @return Флаг запуска задачи или отложенного вызова, false если их нет.
  */
 EXTERN bool scheduler_process(void);
 
+#ifdef USE_SCHEDULER_EDF
+
+/**
+ * Инициализирует планирование EDF.
+ * Должна вызываться после scheduler_init.
+ * Каждая из куч должна вмещать все задачи EDF.
+ * @param ready_heap Буфер кучи готовых задач.
+ * @param pending_heap Буфер кучи ожидающих готовности задач.
+ * @param size Размер буферов куч.
+ * @param get_time Функция получения текущего времени.
+ * @return Код ошибки.
+ */
+EXTERN err_t scheduler_edf_init(task_descr_t** ready_heap, task_descr_t** pending_heap, size_t size, scheduler_get_time_callback_t get_time);
+
+/**
+ * Добавляет периодическую задачу EDF.
+ * Первое задание готово к выполнению немедленно,
+ * последующие - через каждый период.
+ * Завершение задания позже абсолютного срока
+ * считается нарушением срока.
+ * @param proc Функция задачи.
+ * @param arg Аргумент задачи.
+ * @param period Период задачи, 0 для однократного выполнения.
+ * @param deadline Срок выполнения относительно времени готовности.
+ * @param future Будущее задачи.
+ * @return Идентификатор задачи, при ошибке, в том числе
+ * при заполненных кучах задач EDF, возвращает INVALID_TASK_ID.
+ */
+EXTERN task_id_t scheduler_add_edf_task(task_proc_t proc, void* arg, scheduler_time_t period, scheduler_time_t deadline, future_t* future);
+
+/**
+ * Получает число нарушений срока выполнения задачи EDF.
+ * @param tid Идентификатор задачи.
+ * @return Число нарушений срока.
+ */
+EXTERN uint32_t scheduler_edf_task_misses(task_id_t tid);
+
+/**
+ * Получает общее число нарушений сроков выполнения задач EDF.
+ * @return Число нарушений сроков.
+ */
+EXTERN uint32_t scheduler_edf_misses(void);
+
+#endif
+
+#ifdef USE_SCHEDULER_STATS
+
+/**
+ * Получает статистику задачи.
+ * @param tid Идентификатор задачи.
+ * @param stats Статистика задачи.
+ * @return Код ошибки.
+ */
+EXTERN err_t scheduler_task_stats(task_id_t tid, task_stats_t* stats);
+
+/**
+ * Получает снимок статистики всех добавленных задач.
+ * @param snapshot Массив снимков статистики.
+ * @param count Размер массива.
+ * @return Число записанных снимков.
+ */
+EXTERN size_t scheduler_stats_snapshot(task_stats_snapshot_t* snapshot, size_t count);
+
+/**
+ * Сбрасывает статистику всех задач.
+ */
+EXTERN void scheduler_reset_stats(void);
+
+#endif
+
 #endif /* SCHEDULER_H */
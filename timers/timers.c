@@ -5,38 +5,29 @@
 
 
 
-typedef struct _Timers_t {
-    timers_setup_timer_callback_t setup_timer_callback;
-    timer_descr_t* timers_buffer;
-    size_t timers_buffer_size;
-    list_t timers_empty;
-    list_t timers_queued;
-    timer_descr_t* current_timer;
-    timer_id_t max_timer_id;
-} timers_t;
+//! Таймеры по-умолчанию.
+static timers_t timers_default_instance;
 
-static timers_t timers;
 
-
-static size_t timers_timer_id_to_index(timer_id_t tid)
+static size_t timers_timer_id_to_index(timers_t* timers, timer_id_t tid)
 {
-    return (tid - 1) % timers.timers_buffer_size;
+    return (tid - 1) % timers->timers_buffer_size;
 }
 
-static timer_id_t timers_index_to_next_timer_id(size_t index)
+static timer_id_t timers_index_to_next_timer_id(timers_t* timers, size_t index)
 {
-    timer_id_t max_tid = timers.max_timer_id;
+    timer_id_t max_tid = timers->max_timer_id;
     
     if(max_tid > 0) max_tid --;
     
-    size_t count = max_tid / timers.timers_buffer_size;
+    size_t count = max_tid / timers->timers_buffer_size;
     
-    timer_id_t res_tid = index + 1 + count * timers.timers_buffer_size;
+    timer_id_t res_tid = index + 1 + count * timers->timers_buffer_size;
     
-    if(res_tid <= timers.max_timer_id) res_tid += timers.timers_buffer_size;
+    if(res_tid <= timers->max_timer_id) res_tid += timers->timers_buffer_size;
     
     // Переполнение.
-    if(res_tid < timers.max_timer_id){
+    if(res_tid < timers->max_timer_id){
         res_tid = index + 1;
     }
     
@@ -44,64 +35,173 @@ static timer_id_t timers_index_to_next_timer_id(size_t index)
 }
 
 
-static void timers_init_descrs(void)
+static void timers_init_descrs(timers_t* timers)
 {
-    list_init(&timers.timers_empty);
-    list_init(&timers.timers_queued);
+    list_init(&timers->timers_empty);
+#ifdef USE_TIMERS_WHEEL
+    size_t level, slot;
+    for(level = 0; level < TIMERS_WHEEL_LEVELS; level ++){
+        for(slot = 0; slot < TIMERS_WHEEL_SLOTS; slot ++){
+            list_init(&timers->wheel[level][slot]);
+        }
+    }
+    list_init(&timers->timers_expired);
+#else
+    list_init(&timers->timers_queued);
+#endif
     
     list_item_t* item;
     size_t i;
     
-    for(i = 0; i < timers.timers_buffer_size; i ++){
-        item = &timers.timers_buffer[i].list_item;
-        list_item_init_data(item, (void*)i);
-        list_append(&timers.timers_empty, item);
+    for(i = 0; i < timers->timers_buffer_size; i ++){
+        item = &timers->timers_buffer[i].list_item;
+        list_item_init_data(item, (void*)&timers->timers_buffer[i]);
+        list_append(&timers->timers_empty, item);
     }
 }
 
-ALWAYS_INLINE static timer_descr_t* timers_timer_descr_by_index(size_t index)
+/**
+ * Получает дескриптор таймера по элементу списка.
+ * Данными элемента списка является дескриптор таймера,
+ * что позволяет сравнивать таймеры без обращения к экземпляру.
+ * @param item Элемент списка.
+ * @return Дескриптор таймера.
+ */
+ALWAYS_INLINE static timer_descr_t* timers_timer_descr_by_item(list_item_t* item)
 {
-    if(index >= timers.timers_buffer_size) return NULL;
-    return &timers.timers_buffer[index];
+    return (timer_descr_t*)list_item_data(item);
 }
 
+ALWAYS_INLINE static timer_descr_t* timers_timer_descr_by_index(timers_t* timers, size_t index)
+{
+    if(index >= timers->timers_buffer_size) return NULL;
+    return &timers->timers_buffer[index];
+}
+
+#ifdef USE_TIMERS_WHEEL
+
+/**
+ * Переводит время в число тиков колеса с округлением вверх.
+ * @param tv Время.
+ * @return Число тиков.
+ */
+static uint32_t timers_wheel_timeval_to_ticks(const struct timeval* tv)
+{
+    return (uint32_t)tv->tv_sec * (1000000UL / TIMERS_WHEEL_TICK_US) +
+           ((uint32_t)tv->tv_usec + TIMERS_WHEEL_TICK_US - 1) / TIMERS_WHEEL_TICK_US;
+}
+
+/**
+ * Помещает таймер в слот колеса согласно тику срабатывания.
+ * Должна вызываться в критической секции.
+ * @param timer_descr Дескриптор таймера.
+ */
+static void timers_wheel_insert(timers_t* timers, timer_descr_t* timer_descr)
+{
+    uint32_t expires = timer_descr->t_expires;
+    uint32_t delta = expires - timers->ticks;
+    size_t level = 0;
+    
+    if((int32_t)delta < 0){
+        // Просроченный таймер - срабатывание в ближайший тик.
+        expires = timers->ticks;
+    }else{
+        while(level < TIMERS_WHEEL_LEVELS - 1 &&
+              delta >= (1UL << (TIMERS_WHEEL_SLOT_BITS * (level + 1)))){
+            level ++;
+        }
+        // Таймер за пределами колеса - будет перемещён при каскадировании.
+        if(TIMERS_WHEEL_SLOT_BITS * TIMERS_WHEEL_LEVELS < 32 &&
+           delta >= (1UL << (TIMERS_WHEEL_SLOT_BITS * TIMERS_WHEEL_LEVELS))){
+            expires = timers->ticks + (1UL << (TIMERS_WHEEL_SLOT_BITS * TIMERS_WHEEL_LEVELS)) - 1;
+        }
+    }
+    
+    size_t slot = (expires >> (TIMERS_WHEEL_SLOT_BITS * level)) & TIMERS_WHEEL_SLOT_MASK;
+    
+    timer_descr->slot = &timers->wheel[level][slot];
+    list_append(timer_descr->slot, &timer_descr->list_item);
+}
+
+/**
+ * Перемещает таймеры слота уровня колеса на нижние уровни.
+ * Должна вызываться в критической секции.
+ * @param level Уровень колеса.
+ * @param slot Индекс слота.
+ */
+static void timers_wheel_cascade(timers_t* timers, size_t level, size_t slot)
+{
+    list_t* list = &timers->wheel[level][slot];
+    list_item_t* item;
+    
+    while((item = list_head(list)) != NULL){
+        list_remove(list, item);
+        timers_wheel_insert(timers, timers_timer_descr_by_item(item));
+    }
+}
+
+#else
+
 static int timers_add_compare(const void* left, const void* right)
 {
-    timer_descr_t* ldescr = timers_timer_descr_by_index((size_t)left);
-    timer_descr_t* rdescr = timers_timer_descr_by_index((size_t)right);
+    timer_descr_t* ldescr = (timer_descr_t*)left;
+    timer_descr_t* rdescr = (timer_descr_t*)right;
     
     if(ldescr == NULL || rdescr == NULL) return 0;
     
+#ifdef USE_TIMERS_TICKLESS
+    if(ldescr->t_deadline < rdescr->t_deadline) return -1;
+#else
     if(timercmp(&ldescr->t_value, &rdescr->t_value, <)) return -1;
     //if(timercmp(&ldescr->t_value, &rdescr->t_value, >)) return 1;
+#endif
     return 1;
 }
 
-static void timers_remove_timer_impl(timer_descr_t* timer_descr)
+#endif
+
+/**
+ * Помещает таймер в очередь.
+ * Должна вызываться в критической секции.
+ * @param timer_descr Дескриптор таймера.
+ */
+static void timers_queue_timer(timers_t* timers, timer_descr_t* timer_descr)
 {
-    timer_descr->tid = INVALID_TIMER_ID;
-    list_remove(&timers.timers_queued, &timer_descr->list_item);
-    list_append(&timers.timers_empty, &timer_descr->list_item);
+#ifdef USE_TIMERS_WHEEL
+    timers_wheel_insert(timers, timer_descr);
+#else
+    list_insert_sorted(&timers->timers_queued, &timer_descr->list_item, timers_add_compare);
+#endif
 }
 
-static void timers_move_timer_impl(timer_descr_t* timer_descr)
+/**
+ * Извлекает таймер из очереди.
+ * Должна вызываться в критической секции.
+ * @param timer_descr Дескриптор таймера.
+ */
+static void timers_unqueue_timer(timers_t* timers, timer_descr_t* timer_descr)
 {
-    list_remove(&timers.timers_queued, &timer_descr->list_item);
-    list_insert_sorted(&timers.timers_queued, &timer_descr->list_item, timers_add_compare);
+#ifdef USE_TIMERS_WHEEL
+    (void)timers;
+    
+    list_remove(timer_descr->slot, &timer_descr->list_item);
+    timer_descr->slot = NULL;
+#else
+    list_remove(&timers->timers_queued, &timer_descr->list_item);
+#endif
 }
 
-static timer_descr_t* timers_first_timer(void)
+static void timers_remove_timer_impl(timers_t* timers, timer_descr_t* timer_descr)
 {
-    list_item_t* timer_item = list_head(&timers.timers_queued);
-    if(timer_item == NULL) return NULL;
-    return timers_timer_descr_by_index((size_t)list_item_data(timer_item));
+    timer_descr->tid = INVALID_TIMER_ID;
+    timers_unqueue_timer(timers, timer_descr);
+    list_append(&timers->timers_empty, &timer_descr->list_item);
 }
 
-static timer_descr_t* timers_next_timer(timer_descr_t* timer_descr)
+static void timers_move_timer_impl(timers_t* timers, timer_descr_t* timer_descr)
 {
-    list_item_t* timer_item = list_next(&timer_descr->list_item);
-    if(timer_item == NULL) return NULL;
-    return timers_timer_descr_by_index((size_t)list_item_data(timer_item));
+    timers_unqueue_timer(timers, timer_descr);
+    timers_queue_timer(timers, timer_descr);
 }
 
 static void timers_run_timer(timer_descr_t* timer_descr)
@@ -115,9 +215,69 @@ static void timers_run_timer(timer_descr_t* timer_descr)
     }
 }
 
-static void timers_setup_first_timer(void)
+#ifndef USE_TIMERS_WHEEL
+
+static timer_descr_t* timers_first_timer(timers_t* timers)
+{
+    list_item_t* timer_item = list_head(&timers->timers_queued);
+    if(timer_item == NULL) return NULL;
+    return timers_timer_descr_by_item(timer_item);
+}
+
+static timer_descr_t* timers_next_timer(timer_descr_t* timer_descr)
+{
+    list_item_t* timer_item = list_next(&timer_descr->list_item);
+    if(timer_item == NULL) return NULL;
+    return timers_timer_descr_by_item(timer_item);
+}
+
+#ifdef USE_TIMERS_TICKLESS
+
+/**
+ * Переводит время в число тиков с округлением вверх.
+ * @param tv Время.
+ * @return Число тиков.
+ */
+static timers_ticks_t timers_tickless_timeval_to_ticks(const struct timeval* tv)
+{
+    return ((timers_ticks_t)tv->tv_sec * 1000000ULL + (timers_ticks_t)tv->tv_usec +
+            TIMERS_TICKLESS_TICK_US - 1) / TIMERS_TICKLESS_TICK_US;
+}
+
+/**
+ * Устанавливает время срабатывания таймера отсчёта времени.
+ * Таймеры, срабатывающие в пределах допустимого запаздывания
+ * от первого таймера, обрабатываются за одно срабатывание.
+ * Должна вызываться в критической секции.
+ */
+static void timers_setup_first_timer(timers_t* timers)
+{
+    timer_descr_t* cur_timer = timers_first_timer(timers);
+    
+    if(!cur_timer) return;
+    
+    timers_ticks_t limit = cur_timer->t_deadline + timers->slack;
+    timers_ticks_t deadline = cur_timer->t_deadline;
+    
+    while((cur_timer = timers_next_timer(cur_timer)) != NULL){
+        if(cur_timer->t_deadline > limit) break;
+        deadline = cur_timer->t_deadline;
+    }
+    
+    // Установленное срабатывание произойдёт раньше.
+    if(timers->deadline_set && timers->deadline <= deadline) return;
+    
+    timers->deadline = deadline;
+    timers->deadline_set = true;
+    
+    timers->setup_deadline_callback(deadline);
+}
+
+#else
+
+static void timers_setup_first_timer(timers_t* timers)
 {
-    timer_descr_t* cur_timer = timers_first_timer();
+    timer_descr_t* cur_timer = timers_first_timer(timers);
     
     if(!cur_timer) return;
     
@@ -131,73 +291,149 @@ static void timers_setup_first_timer(void)
         tv_val.tv_usec = 0;
     }
     
-    if(timers.setup_timer_callback) timers.setup_timer_callback(&tv_val);
+    if(timers->setup_timer_callback) timers->setup_timer_callback(&tv_val);
 }
 
-err_t timers_init(timers_init_t* timers_is)
+#endif //USE_TIMERS_TICKLESS
+
+#endif
+
+err_t timers_instance_init(timers_t* timers, timers_init_t* timers_is)
 {
     if(timers_is->buffer == NULL) return E_NULL_POINTER;
     if(timers_is->count == 0) return E_INVALID_VALUE;
+#ifdef USE_TIMERS_TICKLESS
+    if(timers_is->get_ticks_callback == NULL) return E_NULL_POINTER;
+    if(timers_is->setup_deadline_callback == NULL) return E_NULL_POINTER;
+#else
     if(timers_is->setup_timer_callback == NULL) return E_NULL_POINTER;
+#endif
+    
+    memset(timers, 0x0, sizeof(timers_t));
     
-    memset(&timers, 0x0, sizeof(timers_t));
+#ifdef USE_TIMERS_TICKLESS
+    timers->get_ticks_callback = timers_is->get_ticks_callback;
+    timers->setup_deadline_callback = timers_is->setup_deadline_callback;
+    timers->slack = timers_is->slack;
+#else
+    timers->setup_timer_callback = timers_is->setup_timer_callback;
+#endif
+    timers->timers_buffer = timers_is->buffer;
+    timers->timers_buffer_size = timers_is->count;
+    timers->max_timer_id = 0;
     
-    timers.setup_timer_callback = timers_is->setup_timer_callback;
-    timers.timers_buffer = timers_is->buffer;
-    timers.timers_buffer_size = timers_is->count;
-    timers.max_timer_id = 0;
+    timers_init_descrs(timers);
     
-    timers_init_descrs();
+#ifdef USE_TIMERS_WHEEL
+    struct timeval tv_tick;
+    tv_tick.tv_sec = TIMERS_WHEEL_TICK_US / 1000000UL;
+    tv_tick.tv_usec = TIMERS_WHEEL_TICK_US % 1000000UL;
+    
+    timers->setup_timer_callback(&tv_tick);
+#endif
     
     return E_NO_ERROR;
 }
 
-timer_id_t timers_current_timer_id(void)
+timer_id_t timers_instance_current_timer_id(timers_t* timers)
 {
-    if(timers.current_timer == NULL) return INVALID_TIMER_ID;
-    return timers.current_timer->tid;
+    if(timers->current_timer == NULL) return INVALID_TIMER_ID;
+    return timers->current_timer->tid;
 }
 
-timer_id_t timers_add_timer(timer_proc_t proc, struct timeval* t_start, struct timeval* t_int, void* arg, future_t* future)
+size_t timers_instance_timers_count(timers_t* timers)
+{
+    return timers->timers_buffer_size - list_size(&timers->timers_empty);
+}
+
+/**
+ * Получает свободный дескриптор таймера и заполняет его.
+ * @param proc Функция таймера.
+ * @param arg Аргумент таймера.
+ * @param future Будущее таймера.
+ * @return Дескриптор таймера, NULL при отсутствии свободных.
+ */
+static timer_descr_t* timers_alloc_timer(timers_t* timers, timer_proc_t proc, void* arg, future_t* future)
 {
-    if(proc == NULL) return INVALID_TIMER_ID;
-    if(t_start == NULL) return INVALID_TIMER_ID;
-    if(!timerisset(t_start)) return INVALID_TIMER_ID;
-    
     list_item_t* timer_item = NULL;
-    size_t timer_index = 0;
     
     CRITICAL_ENTER();
     
-    timer_item = list_head(&timers.timers_empty);
+    timer_item = list_head(&timers->timers_empty);
     
     if(timer_item == NULL){
         CRITICAL_EXIT();
-        return INVALID_TIMER_ID;
+        return NULL;
     }
     
-    list_remove(&timers.timers_empty, timer_item);
+    list_remove(&timers->timers_empty, timer_item);
     
     CRITICAL_EXIT();
     
-    timer_index = (size_t)list_item_data(timer_item);
-    
-    timer_descr_t* descr = timers_timer_descr_by_index(timer_index);
+    timer_descr_t* descr = timers_timer_descr_by_item(timer_item);
     
     if(descr == NULL){
         CRITICAL_ENTER();
         
-        list_append(&timers.timers_empty, timer_item);
+        list_append(&timers->timers_empty, timer_item);
         
         CRITICAL_EXIT();
         
-        return INVALID_TIMER_ID;
+        return NULL;
     }
     
     descr->proc = proc;
     descr->arg = arg;
     descr->future = future;
     
+    if(descr->future){
+        future_init(descr->future);
+    }
+    
+    return descr;
+}
+
+/**
+ * Назначает таймеру идентификатор и помещает его в очередь.
+ * @param descr Дескриптор таймера.
+ * @return Идентификатор таймера.
+ */
+static timer_id_t timers_start_timer(timers_t* timers, timer_descr_t* descr)
+{
+    size_t timer_index = (size_t)(descr - timers->timers_buffer);
+    
+    CRITICAL_ENTER();
+    
+    descr->tid = timers_index_to_next_timer_id(timers, timer_index);
+    timers->max_timer_id = descr->tid;
+#ifdef USE_TIMERS_WHEEL
+    descr->t_expires += timers->ticks;
+#endif
+    timers_queue_timer(timers, descr);
+    
+#ifdef USE_TIMERS_TICKLESS
+    if(timers->current_timer == NULL) timers_setup_first_timer(timers);
+#endif
+    
+    CRITICAL_EXIT();
+    
+#if !defined(USE_TIMERS_WHEEL) && !defined(USE_TIMERS_TICKLESS)
+    if(timers->current_timer == NULL) timers_setup_first_timer(timers);
+#endif
+    
+    return descr->tid;
+}
+
+timer_id_t timers_instance_add_timer(timers_t* timers, timer_proc_t proc, struct timeval* t_start, struct timeval* t_int, void* arg, future_t* future)
+{
+    if(proc == NULL) return INVALID_TIMER_ID;
+    if(t_start == NULL) return INVALID_TIMER_ID;
+    if(!timerisset(t_start)) return INVALID_TIMER_ID;
+    
+    timer_descr_t* descr = timers_alloc_timer(timers, proc, arg, future);
+    
+    if(descr == NULL) return INVALID_TIMER_ID;
+    
     if(t_int){
         descr->t_interval.tv_sec = t_int->tv_sec;
         descr->t_interval.tv_usec = t_int->tv_usec;
@@ -209,30 +445,67 @@ timer_id_t timers_add_timer(timer_proc_t proc, struct timeval* t_start, struct t
     descr->t_value.tv_sec = t_start->tv_sec;
     descr->t_value.tv_usec = t_start->tv_usec;
     
-    if(descr->future){
-        future_init(descr->future);
+#if defined(USE_TIMERS_WHEEL) || defined(USE_TIMERS_TICKLESS)
+    struct timeval tv_delay;
+    gettimeofday(&tv_delay, NULL);
+    
+    if(timercmp(&descr->t_value, &tv_delay, >)){
+        timersub(&descr->t_value, &tv_delay, &tv_delay);
+    }else{
+        tv_delay.tv_sec = 0;
+        tv_delay.tv_usec = 0;
     }
+#endif
     
-    CRITICAL_ENTER();
+#ifdef USE_TIMERS_WHEEL
+    // Задержка в тиках, отсчитывается от текущего тика при добавлении.
+    descr->t_expires = timers_wheel_timeval_to_ticks(&tv_delay);
+    descr->t_period = timers_wheel_timeval_to_ticks(&descr->t_interval);
+#endif
     
-    descr->tid = timers_index_to_next_timer_id(timer_index);
-    timers.max_timer_id = descr->tid;
-    list_insert_sorted(&timers.timers_queued, timer_item, timers_add_compare);
+#ifdef USE_TIMERS_TICKLESS
+    descr->t_deadline = timers->get_ticks_callback() + timers_tickless_timeval_to_ticks(&tv_delay);
+    descr->t_period = timers_tickless_timeval_to_ticks(&descr->t_interval);
+#endif
     
-    CRITICAL_EXIT();
+    return timers_start_timer(timers, descr);
+}
+
+#ifdef USE_TIMERS_TICKLESS
+
+timers_ticks_t timers_instance_ticks(timers_t* timers)
+{
+    return timers->get_ticks_callback();
+}
+
+timer_id_t timers_instance_add_timer_ticks(timers_t* timers, timer_proc_t proc, timers_ticks_t t_start, timers_ticks_t t_int, void* arg, future_t* future)
+{
+    if(proc == NULL) return INVALID_TIMER_ID;
     
-    if(timers.current_timer == NULL) timers_setup_first_timer();
+    timer_descr_t* descr = timers_alloc_timer(timers, proc, arg, future);
     
-    return descr->tid;
+    if(descr == NULL) return INVALID_TIMER_ID;
+    
+    descr->t_interval.tv_sec = 0;
+    descr->t_interval.tv_usec = 0;
+    descr->t_value.tv_sec = 0;
+    descr->t_value.tv_usec = 0;
+    
+    descr->t_deadline = t_start;
+    descr->t_period = t_int;
+    
+    return timers_start_timer(timers, descr);
 }
 
-bool timers_remove_timer(timer_id_t tid)
+#endif
+
+bool timers_instance_remove_timer(timers_t* timers, timer_id_t tid)
 {
     if(tid == INVALID_TIMER_ID) return false;
     
-    size_t timer_index = timers_timer_id_to_index(tid);
+    size_t timer_index = timers_timer_id_to_index(timers, tid);
     
-    timer_descr_t* timer_descr = timers_timer_descr_by_index(timer_index);
+    timer_descr_t* timer_descr = timers_timer_descr_by_index(timers, timer_index);
     
     if(timer_descr == NULL){
         return false;
@@ -242,35 +515,163 @@ bool timers_remove_timer(timer_id_t tid)
     
     CRITICAL_ENTER();
     
-    if(timer_descr == timers.current_timer){
+    if(timer_descr == timers->current_timer){
         timer_descr->t_interval.tv_sec = 0;
         timer_descr->t_interval.tv_usec = 0;
+#if defined(USE_TIMERS_WHEEL) || defined(USE_TIMERS_TICKLESS)
+        timer_descr->t_period = 0;
+#endif
     }else{
-        timers_remove_timer_impl(timer_descr);
+        timers_remove_timer_impl(timers, timer_descr);
     }
     
     CRITICAL_EXIT();
     
-    if(timers.current_timer == NULL) timers_setup_first_timer();
+#if !defined(USE_TIMERS_WHEEL) && !defined(USE_TIMERS_TICKLESS)
+    if(timers->current_timer == NULL) timers_setup_first_timer(timers);
+#endif
     
     return true;
 }
 
-void timers_timer_handler(void)
+#ifdef USE_TIMERS_WHEEL
+
+void timers_instance_timer_handler(timers_t* timers)
 {
-    if(list_empty(&timers.timers_queued)) return;
+    CRITICAL_ENTER();
+    
+    size_t slot = timers->ticks & TIMERS_WHEEL_SLOT_MASK;
+    
+    // Каскадирование верхних уровней при обороте нижнего.
+    if(slot == 0){
+        size_t level;
+        size_t level_slot;
+        for(level = 1; level < TIMERS_WHEEL_LEVELS; level ++){
+            level_slot = (timers->ticks >> (TIMERS_WHEEL_SLOT_BITS * level)) & TIMERS_WHEEL_SLOT_MASK;
+            timers_wheel_cascade(timers, level, level_slot);
+            if(level_slot != 0) break;
+        }
+    }
+    
+    list_t* list = &timers->wheel[0][slot];
+    list_item_t* item;
+    timer_descr_t* cur_timer;
+    
+    // Перенос таймеров слота в конец списка истёкших.
+    for(item = list_head(list); item != NULL; item = list_next(item)){
+        timers_timer_descr_by_item(item)->slot = &timers->timers_expired;
+    }
+    
+    list_splice(&timers->timers_expired, list);
+    
+    uint32_t cur_tick = timers->ticks ++;
+    
+    CRITICAL_EXIT();
+    
+    for(;;){
+        CRITICAL_ENTER();
+        
+        item = list_head(&timers->timers_expired);
+        
+        if(item == NULL){
+            CRITICAL_EXIT();
+            break;
+        }
+        
+        cur_timer = timers_timer_descr_by_item(item);
+        timers->current_timer = cur_timer;
+        
+        CRITICAL_EXIT();
+        
+        timers_run_timer(cur_timer);
+        
+        CRITICAL_ENTER();
+        
+        if(cur_timer->t_period != 0){
+            cur_timer->t_expires = cur_tick + cur_timer->t_period;
+            timers_move_timer_impl(timers, cur_timer);
+        }else{
+            timers_remove_timer_impl(timers, cur_timer);
+        }
+        
+        timers->current_timer = NULL;
+        
+        CRITICAL_EXIT();
+    }
+}
+
+#elif defined(USE_TIMERS_TICKLESS)
+
+void timers_instance_timer_handler(timers_t* timers)
+{
+    timer_descr_t* cur_timer;
+    
+    CRITICAL_ENTER();
+    
+    timers->deadline_set = false;
+    
+    CRITICAL_EXIT();
+    
+    timers_ticks_t ticks = timers->get_ticks_callback();
+    
+    for(;;){
+        CRITICAL_ENTER();
+        
+        cur_timer = timers_first_timer(timers);
+        
+        if(cur_timer == NULL || cur_timer->t_deadline > ticks){
+            CRITICAL_EXIT();
+            break;
+        }
+        
+        timers->current_timer = cur_timer;
+        
+        CRITICAL_EXIT();
+        
+        timers_run_timer(cur_timer);
+        
+        CRITICAL_ENTER();
+        
+        if(cur_timer->t_period != 0){
+            cur_timer->t_deadline += cur_timer->t_period;
+            // Пропуск пропущенных периодов.
+            if(cur_timer->t_deadline <= ticks){
+                cur_timer->t_deadline = ticks + cur_timer->t_period;
+            }
+            timers_move_timer_impl(timers, cur_timer);
+        }else{
+            timers_remove_timer_impl(timers, cur_timer);
+        }
+        
+        timers->current_timer = NULL;
+        
+        CRITICAL_EXIT();
+    }
+    
+    CRITICAL_ENTER();
+    
+    timers_setup_first_timer(timers);
+    
+    CRITICAL_EXIT();
+}
+
+#else
+
+void timers_instance_timer_handler(timers_t* timers)
+{
+    if(list_empty(&timers->timers_queued)) return;
     
     struct timeval tv_cur;
     gettimeofday(&tv_cur, NULL);
     
-    timer_descr_t* cur_timer = timers_first_timer();
+    timer_descr_t* cur_timer = timers_first_timer(timers);
     
     for(;;){
         if(!cur_timer) break;
         
         if(timercmp(&cur_timer->t_value, &tv_cur, >)) break;
         
-        timers.current_timer = cur_timer;
+        timers->current_timer = cur_timer;
         
         timer_descr_t* next_timer = timers_next_timer(cur_timer);
         
@@ -281,14 +682,14 @@ void timers_timer_handler(void)
             
             CRITICAL_ENTER();
             
-            timers_move_timer_impl(cur_timer);
+            timers_move_timer_impl(timers, cur_timer);
             
             CRITICAL_EXIT();
             
         }else{
             CRITICAL_ENTER();
         
-            timers_remove_timer_impl(cur_timer);
+            timers_remove_timer_impl(timers, cur_timer);
 
             CRITICAL_EXIT();
         }
@@ -296,7 +697,111 @@ void timers_timer_handler(void)
         cur_timer = next_timer;
     }
     
-    timers.current_timer = NULL;
+    timers->current_timer = NULL;
+    
+    timers_setup_first_timer(timers);
+}
+
+#endif
+
+
+timers_t* timers_default(void)
+{
+    return &timers_default_instance;
+}
+
+err_t timers_init(timers_init_t* timers_is)
+{
+    return timers_instance_init(&timers_default_instance, timers_is);
+}
+
+timer_id_t timers_current_timer_id(void)
+{
+    return timers_instance_current_timer_id(&timers_default_instance);
+}
+
+size_t timers_timers_count(void)
+{
+    return timers_instance_timers_count(&timers_default_instance);
+}
+
+timer_id_t timers_add_timer(timer_proc_t proc, struct timeval* t_start, struct timeval* t_int, void* arg, future_t* future)
+{
+    return timers_instance_add_timer(&timers_default_instance, proc, t_start, t_int, arg, future);
+}
+
+bool timers_remove_timer(timer_id_t tid)
+{
+    return timers_instance_remove_timer(&timers_default_instance, tid);
+}
+
+void timers_timer_handler(void)
+{
+    timers_instance_timer_handler(&timers_default_instance);
+}
+
+#ifdef USE_TIMERS_TICKLESS
+
+timers_ticks_t timers_ticks(void)
+{
+    return timers_instance_ticks(&timers_default_instance);
+}
+
+timer_id_t timers_add_timer_ticks(timer_proc_t proc, timers_ticks_t t_start, timers_ticks_t t_int, void* arg, future_t* future)
+{
+    return timers_instance_add_timer_ticks(&timers_default_instance, proc, t_start, t_int, arg, future);
+}
+
+#endif
+
+#ifdef USE_TIMERS_SIM_CLOCK
+
+//! Тип состояния моделируемых часов.
+typedef struct _Timers_Sim_Clock {
+    timers_ticks_t ticks; //!< Текущий тик.
+    timers_ticks_t deadline; //!< Установленное время срабатывания.
+    bool deadline_set; //!< Флаг установки времени срабатывания.
+    uint32_t interrupts; //!< Число срабатываний.
+} timers_sim_clock_t;
+
+static timers_sim_clock_t timers_sim_clock;
+
+timers_ticks_t timers_sim_get_ticks(void)
+{
+    return timers_sim_clock.ticks;
+}
+
+void timers_sim_setup_deadline(timers_ticks_t deadline)
+{
+    timers_sim_clock.deadline = deadline;
+    timers_sim_clock.deadline_set = true;
+}
+
+void timers_instance_sim_advance(timers_t* timers, timers_ticks_t ticks)
+{
+    timers_ticks_t end = timers_sim_clock.ticks + ticks;
+    
+    while(timers_sim_clock.deadline_set && timers_sim_clock.deadline <= end){
+        if(timers_sim_clock.deadline > timers_sim_clock.ticks){
+            timers_sim_clock.ticks = timers_sim_clock.deadline;
+        }
+        timers_sim_clock.deadline_set = false;
+        timers_sim_clock.interrupts ++;
+        
+        timers_instance_timer_handler(timers);
+    }
     
-    timers_setup_first_timer();
+    timers_sim_clock.ticks = end;
+}
+
+void timers_sim_advance(timers_ticks_t ticks)
+{
+    timers_instance_sim_advance(&timers_default_instance, ticks);
 }
+
+uint32_t timers_sim_interrupts(void)
+{
+    return timers_sim_clock.interrupts;
+}
+
+#endif
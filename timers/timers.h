@@ -1,5 +1,19 @@
 /**
  * @file timers.h Библиотека таймеров.
+ * По-умолчанию таймеры хранятся в сортированном по времени
+ * срабатывания списке, при определении USE_TIMERS_WHEEL
+ * используется иерархическое колесо таймеров с
+ * добавлением и удалением таймера за O(1).
+ * При определении USE_TIMERS_TICKLESS время срабатывания
+ * таймеров хранится в 64-битных тиках монотонных часов,
+ * а таймер отсчёта времени устанавливается только на
+ * ближайшее срабатывание; таймеры, срабатывающие в пределах
+ * допустимого запаздывания, обрабатываются за одно срабатывание.
+ * USE_TIMERS_SIM_CLOCK добавляет моделируемые часы для
+ * проверки таймеров без аппаратного таймера.
+ * Функции timers_instance_* работают с заданным
+ * экземпляром таймеров, остальные функции - с
+ * экземпляром по-умолчанию (см. timers_default).
  */
 
 #ifndef TIMERS_H
@@ -20,6 +34,67 @@
 //! Ошибочный идентификатор таймера.
 #define INVALID_TIMER_ID 0
 
+#ifdef USE_TIMERS_WHEEL
+
+//! Период тика колеса таймеров в микросекундах.
+#ifndef TIMERS_WHEEL_TICK_US
+#define TIMERS_WHEEL_TICK_US 1000
+#endif
+
+//! Число бит индекса слота уровня колеса таймеров.
+#ifndef TIMERS_WHEEL_SLOT_BITS
+#define TIMERS_WHEEL_SLOT_BITS 5
+#endif
+
+//! Число уровней колеса таймеров.
+#ifndef TIMERS_WHEEL_LEVELS
+#define TIMERS_WHEEL_LEVELS 4
+#endif
+
+//! Число слотов уровня колеса таймеров.
+#define TIMERS_WHEEL_SLOTS (1UL << TIMERS_WHEEL_SLOT_BITS)
+
+//! Маска индекса слота уровня колеса таймеров.
+#define TIMERS_WHEEL_SLOT_MASK (TIMERS_WHEEL_SLOTS - 1)
+
+#endif //USE_TIMERS_WHEEL
+
+#ifdef USE_TIMERS_TICKLESS
+
+#ifdef USE_TIMERS_WHEEL
+#error timers tickless mode incompatible with USE_TIMERS_WHEEL!
+#endif
+
+//! Период тика монотонных часов в микросекундах.
+#ifndef TIMERS_TICKLESS_TICK_US
+#define TIMERS_TICKLESS_TICK_US 1
+#endif
+
+//! Тип тиков монотонных часов.
+typedef uint64_t timers_ticks_t;
+
+/**
+ * Функция обратного вызова получения текущего тика монотонных часов.
+ * @return Текущий тик.
+ */
+typedef timers_ticks_t (*timers_get_ticks_callback_t)(void);
+
+/**
+ * Функция обратного вызова установки таймера отсчёта времени.
+ * Таймер должен сработать при достижении заданного тика,
+ * либо немедленно, если тик уже достигнут.
+ * @param deadline Тик срабатывания.
+ */
+typedef void (*timers_setup_deadline_callback_t)(timers_ticks_t deadline);
+
+#endif //USE_TIMERS_TICKLESS
+
+#ifdef USE_TIMERS_SIM_CLOCK
+#ifndef USE_TIMERS_TICKLESS
+#error timers sim clock need defined USE_TIMERS_TICKLESS!
+#endif
+#endif
+
 
 //! Тип идентификатора таймера.
 typedef uint32_t timer_id_t;
@@ -36,6 +111,15 @@ typedef struct _Timer_Descr_t {
     struct timeval t_value; //!< Следующее время срабатывания таймера.
     void* arg; //!< Аргумент таймера.
     future_t* future; //!< Будущее таймера.
+#ifdef USE_TIMERS_WHEEL
+    uint32_t t_expires; //!< Тик срабатывания таймера.
+    uint32_t t_period; //!< Период таймера в тиках.
+    list_t* slot; //!< Список колеса, содержащий таймер.
+#endif
+#ifdef USE_TIMERS_TICKLESS
+    timers_ticks_t t_deadline; //!< Тик срабатывания таймера.
+    timers_ticks_t t_period; //!< Период таймера в тиках.
+#endif
 } timer_descr_t;
 
 //! Декларация буфера таймеров.
@@ -43,6 +127,9 @@ typedef struct _Timer_Descr_t {
 
 /**
  * Функция обратного вызова однократного запуска таймера для отсчёта времени.
+ * При использовании колеса таймеров вызывается однократно
+ * при инициализации с периодом тика, таймер отсчёта времени
+ * должен срабатывать периодически с этим периодом.
  * @param tv_time Время, через которое должен сработать таймер.
  */
 typedef void (*timers_setup_timer_callback_t)(const struct timeval* tv_time);
@@ -51,9 +138,81 @@ typedef void (*timers_setup_timer_callback_t)(const struct timeval* tv_time);
 typedef struct _Timers_Init_Struct {
     timer_descr_t* buffer; //!< Массив дескрипторов таймеров.
     size_t count; //!< Число дескрипторов.
+#ifdef USE_TIMERS_TICKLESS
+    timers_get_ticks_callback_t get_ticks_callback; //!< Функция обратного вызова получения тика.
+    timers_setup_deadline_callback_t setup_deadline_callback; //!< Функция обратного вызова установки таймера.
+    timers_ticks_t slack; //!< Допустимое запаздывание срабатывания в тиках.
+#else
     timers_setup_timer_callback_t setup_timer_callback; //!< Функция обратного вызова запуска таймера.
+#endif
 } timers_init_t;
 
+//! Тип таймеров.
+typedef struct _Timers_t {
+#ifdef USE_TIMERS_TICKLESS
+    timers_get_ticks_callback_t get_ticks_callback; //!< Функция получения текущего тика.
+    timers_setup_deadline_callback_t setup_deadline_callback; //!< Функция установки времени срабатывания.
+    timers_ticks_t slack; //!< Допустимое запаздывание для объединения срабатываний.
+    timers_ticks_t deadline; //!< Установленное время срабатывания.
+    bool deadline_set; //!< Флаг установки времени срабатывания.
+#else
+    timers_setup_timer_callback_t setup_timer_callback; //!< Функция запуска таймера.
+#endif
+    timer_descr_t* timers_buffer; //!< Буфер дескрипторов таймеров.
+    size_t timers_buffer_size; //!< Число дескрипторов таймеров.
+    list_t timers_empty; //!< Свободные дескрипторы.
+#ifdef USE_TIMERS_WHEEL
+    list_t wheel[TIMERS_WHEEL_LEVELS][TIMERS_WHEEL_SLOTS]; //!< Слоты колеса таймеров.
+    list_t timers_expired; //!< Сработавшие таймеры текущего тика.
+    uint32_t ticks; //!< Следующий обрабатываемый тик.
+#else
+    list_t timers_queued; //!< Очередь таймеров.
+#endif
+    timer_descr_t* current_timer; //!< Текущий таймер.
+    timer_id_t max_timer_id; //!< Последний выданный идентификатор таймера.
+} timers_t;
+
+/**
+ * Получает таймеры по-умолчанию.
+ * @return Таймеры по-умолчанию.
+ */
+EXTERN timers_t* timers_default(void);
+
+//! Аналогична timers_init для заданных таймеров.
+EXTERN err_t timers_instance_init(timers_t* timers, timers_init_t* timers_is);
+
+//! Аналогична timers_current_timer_id для заданных таймеров.
+EXTERN timer_id_t timers_instance_current_timer_id(timers_t* timers);
+
+//! Аналогична timers_timers_count для заданных таймеров.
+EXTERN size_t timers_instance_timers_count(timers_t* timers);
+
+//! Аналогична timers_add_timer для заданных таймеров.
+EXTERN timer_id_t timers_instance_add_timer(timers_t* timers, timer_proc_t proc, struct timeval* t_start, struct timeval* t_int, void* arg, future_t* future);
+
+//! Аналогична timers_remove_timer для заданных таймеров.
+EXTERN bool timers_instance_remove_timer(timers_t* timers, timer_id_t tid);
+
+//! Аналогична timers_timer_handler для заданных таймеров.
+EXTERN void timers_instance_timer_handler(timers_t* timers);
+
+#ifdef USE_TIMERS_TICKLESS
+
+//! Аналогична timers_ticks для заданных таймеров.
+EXTERN timers_ticks_t timers_instance_ticks(timers_t* timers);
+
+//! Аналогична timers_add_timer_ticks для заданных таймеров.
+EXTERN timer_id_t timers_instance_add_timer_ticks(timers_t* timers, timer_proc_t proc, timers_ticks_t t_start, timers_ticks_t t_int, void* arg, future_t* future);
+
+#endif
+
+#ifdef USE_TIMERS_SIM_CLOCK
+
+//! Аналогична timers_sim_advance для заданных таймеров.
+EXTERN void timers_instance_sim_advance(timers_t* timers, timers_ticks_t ticks);
+
+#endif
+
 /**
  * Инициализирует таймеры.
  * Таймеры используют буфер дескрипторов
@@ -71,6 +230,12 @@ EXTERN err_t timers_init(timers_init_t* timers_is);
  */
 EXTERN timer_id_t timers_current_timer_id(void);
 
+/**
+ * Получает число добавленных таймеров.
+ * @return Число добавленных таймеров.
+ */
+EXTERN size_t timers_timers_count(void);
+
 /**
  * Добавляет таймер.
  * @param proc Функция таймера.
@@ -83,6 +248,27 @@ EXTERN timer_id_t timers_current_timer_id(void);
  */
 EXTERN timer_id_t timers_add_timer(timer_proc_t proc, struct timeval* t_start, struct timeval* t_int, void* arg, future_t* future);
 
+#ifdef USE_TIMERS_TICKLESS
+
+/**
+ * Получает текущий тик монотонных часов.
+ * @return Текущий тик.
+ */
+EXTERN timers_ticks_t timers_ticks(void);
+
+/**
+ * Добавляет таймер, время которого задано в тиках.
+ * @param proc Функция таймера.
+ * @param t_start Тик срабатывания таймера.
+ * @param t_int Период срабатывания таймера в тиках.
+ * 0 для однократного запуска.
+ * @param arg Аргумент таймера.
+ * @return Идентификатор таймера, при ошибке возвращает INVALID_TIMER_ID.
+ */
+EXTERN timer_id_t timers_add_timer_ticks(timer_proc_t proc, timers_ticks_t t_start, timers_ticks_t t_int, void* arg, future_t* future);
+
+#endif //USE_TIMERS_TICKLESS
+
 /**
  * Удаляет таймер.
  * @param tid Идентификатор таймера.
@@ -92,7 +278,41 @@ EXTERN bool timers_remove_timer(timer_id_t tid);
 
 /**
  * Обработчик срабатывания таймера отсчёта времени.
+ * При использовании колеса таймеров должен вызываться
+ * каждый тик, обрабатывает один слот колеса.
  */
 EXTERN void timers_timer_handler(void);
 
+#ifdef USE_TIMERS_SIM_CLOCK
+
+/**
+ * Получает текущий тик моделируемых часов.
+ * Используется как get_ticks_callback.
+ * @return Текущий тик.
+ */
+EXTERN timers_ticks_t timers_sim_get_ticks(void);
+
+/**
+ * Устанавливает срабатывание моделируемого таймера.
+ * Используется как setup_deadline_callback.
+ * @param deadline Тик срабатывания.
+ */
+EXTERN void timers_sim_setup_deadline(timers_ticks_t deadline);
+
+/**
+ * Продвигает моделируемые часы на заданное число тиков,
+ * вызывая обработчик таймеров по-умолчанию при достижении
+ * установленного времени срабатывания.
+ * @param ticks Число тиков.
+ */
+EXTERN void timers_sim_advance(timers_ticks_t ticks);
+
+/**
+ * Получает число срабатываний моделируемого таймера.
+ * @return Число срабатываний.
+ */
+EXTERN uint32_t timers_sim_interrupts(void);
+
+#endif //USE_TIMERS_SIM_CLOCK
+
 #endif /* TIMERS_H */
@@ -147,6 +147,52 @@ rbtree_node_t* rbtree_search(rbtree_t* tree, rbtree_key_t key)
     return NULL;
 }
 
+rbtree_node_t* rbtree_lower_bound(rbtree_t* tree, rbtree_key_t key)
+{
+    rbtree_node_t* cur_node = tree->root;
+    rbtree_node_t* res_node = NULL;
+    
+    while(cur_node){
+        if(tree->compare(cur_node->key, key) >= 0){
+            res_node = cur_node;
+            cur_node = cur_node->left;
+        }else{
+            cur_node = cur_node->right;
+        }
+    }
+    
+    return res_node;
+}
+
+rbtree_node_t* rbtree_upper_bound(rbtree_t* tree, rbtree_key_t key)
+{
+    rbtree_node_t* cur_node = tree->root;
+    rbtree_node_t* res_node = NULL;
+    
+    while(cur_node){
+        if(tree->compare(cur_node->key, key) > 0){
+            res_node = cur_node;
+            cur_node = cur_node->left;
+        }else{
+            cur_node = cur_node->right;
+        }
+    }
+    
+    return res_node;
+}
+
+void rbtree_range_init(rbtree_range_t* range, rbtree_t* tree, rbtree_key_t lo, rbtree_key_t hi)
+{
+    range->tree = tree;
+    range->node = rbtree_lower_bound(tree, lo);
+    range->end = rbtree_lower_bound(tree, hi);
+    
+    // Пустой либо обратный интервал.
+    if(tree->compare(lo, hi) >= 0){
+        range->node = range->end;
+    }
+}
+
 //! Получает цвет элемента.
 ALWAYS_INLINE static rbtree_color_t rbtree_node_color(rbtree_node_t* node)
 {
@@ -464,6 +510,63 @@ bool rbtree_insert(rbtree_t* tree, rbtree_key_t key, rbtree_value_t value)
     return rbtree_insert_impl(tree, key, value, NULL);
 }
 
+/**
+ * Строит поддерево из части упорядоченного массива.
+ * Середина части становится корнем поддерева,
+ * т.о. все листья находятся на двух соседних уровнях.
+ * Узлы самого нижнего уровня красятся в красный цвет,
+ * остальные - в чёрный, что даёт одинаковую
+ * чёрную высоту всех путей.
+ * @param nodes Массив указателей на элементы.
+ * @param count Число элементов части.
+ * @param depth Глубина корня поддерева.
+ * @param red_depth Глубина красных узлов.
+ * @return Корень поддерева.
+ */
+static rbtree_node_t* rbtree_build_impl(rbtree_node_t** nodes, size_t count, size_t depth, size_t red_depth)
+{
+    if(count == 0) return NULL;
+    
+    size_t mid = count / 2;
+    rbtree_node_t* node = nodes[mid];
+    
+    node->parent = NULL;
+    node->color = (depth == red_depth) ? RBTREE_COLOR_RED : RBTREE_COLOR_BLACK;
+    
+    node->left = rbtree_build_impl(nodes, mid, depth + 1, red_depth);
+    if(node->left) node->left->parent = node;
+    
+    node->right = rbtree_build_impl(nodes + mid + 1, count - mid - 1, depth + 1, red_depth);
+    if(node->right) node->right->parent = node;
+    
+    return node;
+}
+
+err_t rbtree_build_from_sorted(rbtree_t* tree, rbtree_node_t** nodes, size_t count)
+{
+    if(count != 0 && nodes == NULL) return E_NULL_POINTER;
+    if(tree->root != NULL) return E_INVALID_VALUE;
+    
+    size_t i;
+    
+    // Ключи должны строго возрастать.
+    for(i = 1; i < count; i ++){
+        if(tree->compare(nodes[i - 1]->key, nodes[i]->key) >= 0) return E_INVALID_VALUE;
+    }
+    
+    // Глубина самого нижнего уровня.
+    size_t red_depth = 0;
+    for(i = count; i > 1; i >>= 1) red_depth ++;
+    
+    // Единственный узел - корень, он чёрный.
+    if(red_depth == 0) red_depth = SIZE_MAX;
+    
+    tree->root = rbtree_build_impl(nodes, count, 0, red_depth);
+    tree->size = count;
+    
+    return E_NO_ERROR;
+}
+
 //! Балансирует дерево при удалении элемента.
 static void rbtree_remove_balance_fix(rbtree_t* tree, rbtree_node_t* parent, rbtree_node_t* node)
 {
@@ -53,6 +53,13 @@ struct _RBTree_Node {
     rbtree_color_t color; //!< Цвет.
 };
 
+//! Структура диапазона элементов дерева.
+typedef struct _RBTree_Range {
+    rbtree_t* tree; //!< Дерево.
+    rbtree_node_t* node; //!< Текущий элемент.
+    rbtree_node_t* end; //!< Элемент после конца диапазона.
+} rbtree_range_t;
+
 //! Структура двоичного дерева поиска.
 struct _RBTree {
     rbtree_node_t* root; //!< Корень дерева.
@@ -167,6 +174,51 @@ ALWAYS_INLINE static rbtree_node_t* rbtree_prev(rbtree_t* tree, rbtree_node_t* n
  */
 EXTERN rbtree_node_t* rbtree_search(rbtree_t* tree, rbtree_key_t key);
 
+/**
+ * Ищет первый элемент дерева с ключом,
+ * не меньшим заданного.
+ * @param tree Дерево.
+ * @param key Ключ.
+ * @return Найденный элемент дерева, либо NULL.
+ */
+EXTERN rbtree_node_t* rbtree_lower_bound(rbtree_t* tree, rbtree_key_t key);
+
+/**
+ * Ищет первый элемент дерева с ключом,
+ * большим заданного.
+ * @param tree Дерево.
+ * @param key Ключ.
+ * @return Найденный элемент дерева, либо NULL.
+ */
+EXTERN rbtree_node_t* rbtree_upper_bound(rbtree_t* tree, rbtree_key_t key);
+
+/**
+ * Инициализирует диапазон элементов дерева
+ * с ключами в интервале [lo, hi).
+ * Дерево не должно изменяться во время обхода диапазона.
+ * @param range Диапазон.
+ * @param tree Дерево.
+ * @param lo Нижняя граница ключей (включительно).
+ * @param hi Верхняя граница ключей (исключительно).
+ */
+EXTERN void rbtree_range_init(rbtree_range_t* range, rbtree_t* tree, rbtree_key_t lo, rbtree_key_t hi);
+
+/**
+ * Получает следующий элемент диапазона.
+ * @param range Диапазон.
+ * @return Элемент дерева, либо NULL по достижении конца диапазона.
+ */
+ALWAYS_INLINE static rbtree_node_t* rbtree_range_next(rbtree_range_t* range)
+{
+    rbtree_node_t* node = range->node;
+    
+    if(node == range->end) return NULL;
+    
+    range->node = rbtree_successor(range->tree, node);
+    
+    return node;
+}
+
 /**
  * Вставляет элемент в дерево.
  * @param tree Дерево.
@@ -184,6 +236,18 @@ EXTERN bool rbtree_insert_node(rbtree_t* tree, rbtree_node_t* node);
  */
 EXTERN bool rbtree_insert(rbtree_t* tree, rbtree_key_t key, rbtree_value_t value);
 
+/**
+ * Строит сбалансированное дерево из
+ * массива элементов, упорядоченных по возрастанию ключей.
+ * Выполняется за линейное время без поворотов.
+ * Дерево должно быть пустым.
+ * @param tree Дерево.
+ * @param nodes Массив указателей на элементы.
+ * @param count Число элементов.
+ * @return Код ошибки.
+ */
+EXTERN err_t rbtree_build_from_sorted(rbtree_t* tree, rbtree_node_t** nodes, size_t count);
+
 /**
  * Удаляет элемент дерева.
  * @param tree Дерево.
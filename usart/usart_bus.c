@@ -38,7 +38,7 @@ static void usart_bus_dma_tx_config(usart_bus_t* usart, void* address, size_t si
     usart->dma_tx_channel->CCR &= ~DMA_CCR1_EN;
     usart->dma_tx_channel->CNDTR = size;
     usart->dma_tx_channel->CPAR = (uint32_t)&usart->usart_device->DR;
-    usart->dma_tx_channel->CMAR = (uint32_t)address;
+    dma_channel_set_memory_address(usart->dma_tx_channel, address);
     usart->dma_tx_channel->CCR = DMA_CCR1_PL_0 | DMA_CCR1_TEIE | DMA_CCR1_TCIE | DMA_CCR1_DIR | DMA_CCR1_MINC;
 }
 
@@ -47,8 +47,17 @@ static void usart_bus_dma_rx_config(usart_bus_t* usart, void* address, size_t si
     usart->dma_rx_channel->CCR &= ~DMA_CCR1_EN;
     usart->dma_rx_channel->CNDTR = size;
     usart->dma_rx_channel->CPAR = (uint32_t)&usart->usart_device->DR;
-    usart->dma_rx_channel->CMAR = (uint32_t)address;
-    usart->dma_rx_channel->CCR = DMA_CCR1_PL_0 | DMA_CCR1_TEIE | DMA_CCR1_TCIE | DMA_CCR1_MINC;
+    dma_channel_set_memory_address(usart->dma_rx_channel, address);
+    
+    uint32_t ccr = DMA_CCR1_PL_0 | DMA_CCR1_TEIE | DMA_CCR1_TCIE | DMA_CCR1_MINC;
+    
+    // Прерывание половины передачи - для обработки хода приёма.
+    if(usart->rx_progress_callback){
+        dma_channel_it_flag_clear(dma_channel_it_flag(usart->dma_rx_channel, DMA_IT_HT));
+        ccr |= DMA_CCR1_HTIE;
+    }
+    
+    usart->dma_rx_channel->CCR = ccr;
 }
 
 static void usart_bus_dma_start_rx(usart_bus_t* usart)
@@ -209,6 +218,7 @@ err_t usart_bus_init(usart_bus_t* usart, usart_bus_init_t* usart_bus_is)
     usart->rx_callback = NULL;
     usart->tx_callback = NULL;
     usart->tc_callback = NULL;
+    usart->rx_progress_callback = NULL;
     usart->dma_rx_locked = false;
     usart->dma_tx_locked = false;
     usart->rx_status = USART_STATUS_IDLE;
@@ -296,10 +306,11 @@ bool usart_bus_dma_rx_channel_irq_handler(usart_bus_t* usart)
     
     uint32_t dma_tc_flag = dma_channel_it_flag(usart->dma_rx_channel, DMA_IT_TC);
     uint32_t dma_te_flag = dma_channel_it_flag(usart->dma_rx_channel, DMA_IT_TE);
+    uint32_t dma_ht_flag = dma_channel_it_flag(usart->dma_rx_channel, DMA_IT_HT);
 
     if(dma_channel_it_flag_status(dma_tc_flag)){
 
-        dma_channel_it_flag_clear(dma_tc_flag);
+        dma_channel_it_flag_clear(dma_tc_flag | dma_ht_flag);
 
         usart_bus_dma_rx_done(usart);
         
@@ -312,6 +323,13 @@ bool usart_bus_dma_rx_channel_irq_handler(usart_bus_t* usart)
         usart_bus_dma_rx_error(usart);
         
         usart_bus_rx_done(usart);
+
+    }else if(dma_channel_it_flag_status(dma_ht_flag)){
+
+        dma_channel_it_flag_clear(dma_ht_flag);
+        
+        // Приём продолжается, канал DMA не останавливается.
+        if(usart->rx_progress_callback) usart->rx_progress_callback();
     }
     
     return true;
@@ -442,6 +460,16 @@ void usart_bus_set_rx_callback(usart_bus_t* usart, usart_bus_callback_t callback
     usart->rx_callback = callback;
 }
 
+usart_bus_callback_t usart_bus_rx_progress_callback(usart_bus_t* usart)
+{
+    return usart->rx_progress_callback;
+}
+
+void usart_bus_set_rx_progress_callback(usart_bus_t* usart, usart_bus_callback_t callback)
+{
+    usart->rx_progress_callback = callback;
+}
+
 usart_bus_callback_t usart_bus_tx_callback(usart_bus_t* usart)
 {
     return usart->tx_callback;
@@ -495,6 +523,13 @@ size_t usart_bus_bytes_received(usart_bus_t* usart)
     return usart->rx_size;
 }
 
+size_t usart_bus_rx_position(usart_bus_t* usart)
+{
+    if(usart->rx_status != USART_STATUS_TRANSFERING) return usart->rx_size;
+    
+    return usart->rx_size - usart->dma_rx_channel->CNDTR;
+}
+
 size_t usart_bus_bytes_transmitted(usart_bus_t* usart)
 {
     return usart->tx_size;
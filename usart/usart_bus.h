@@ -85,6 +85,7 @@ typedef struct _UsartBus {
     usart_bus_callback_t rx_callback; //!< Каллбэк событий приёма данных шины USART.
     usart_bus_callback_t tx_callback; //!< Каллбэк событий передачи данных шины USART.
     usart_bus_callback_t tc_callback; //!< Каллбэк события окончания передачи данных шины USART.
+    usart_bus_callback_t rx_progress_callback; //!< Каллбэк хода приёма данных.
     bool dma_rx_locked;//!< Заблокирован канал получения.
     bool dma_tx_locked;//!< Заблокирован канал передачи.
     usart_transfer_id_t rx_transfer_id;//!< Идентификатор приёма.
@@ -271,6 +272,25 @@ EXTERN usart_bus_callback_t usart_bus_rx_callback(usart_bus_t* usart);
  */
 EXTERN void usart_bus_set_rx_callback(usart_bus_t* usart, usart_bus_callback_t callback);
 
+/**
+ * Получает каллбэк хода приёма данных шины USART.
+ * @param usart Шина USART.
+ * @return Каллбэк хода приёма.
+ */
+EXTERN usart_bus_callback_t usart_bus_rx_progress_callback(usart_bus_t* usart);
+
+/**
+ * Устанавливает каллбэк хода приёма данных шины USART.
+ * Вызывается из прерывания половины передачи канала DMA приёма,
+ * приём выполняется одной передачей DMA без остановки канала,
+ * поэтому задержка прерывания не приводит к потере данных.
+ * Число принятых байт - usart_bus_rx_position.
+ * Устанавливается до начала приёма.
+ * @param usart Шина USART.
+ * @param callback Каллбэк хода приёма.
+ */
+EXTERN void usart_bus_set_rx_progress_callback(usart_bus_t* usart, usart_bus_callback_t callback);
+
 /**
  * Получает каллбэк событий передачи данных шины USART.
  * @param usart Шина USART.
@@ -335,6 +355,15 @@ EXTERN usart_errors_t usart_bus_tx_errors(usart_bus_t* usart);
  */
 EXTERN size_t usart_bus_bytes_received(usart_bus_t* usart);
 
+/**
+ * Получает число байт данных, принятых
+ * к текущему моменту во время приёма.
+ * После завершения приёма равно usart_bus_bytes_received.
+ * @param usart Шина USART.
+ * @return Число принятых байт данных.
+ */
+EXTERN size_t usart_bus_rx_position(usart_bus_t* usart);
+
 /**
  * Получает число переданных
  * после завершения передачи байт данных.
@@ -4,8 +4,14 @@
 #ifndef CRITICAL_H
 #define CRITICAL_H
 
+#ifdef __arm__
 #define CRITICAL_ENTER() __asm__ volatile ("cpsid i")
 #define CRITICAL_EXIT() __asm__ volatile ("cpsie i")
+#else
+// Сборка для хоста - прерывания отсутствуют.
+#define CRITICAL_ENTER() do{}while(0)
+#define CRITICAL_EXIT() do{}while(0)
+#endif
 
 #endif /* CRITICAL_H */
 
@@ -0,0 +1,60 @@
+/**
+ * @file cycles.h Счётчик тактов для измерения времени выполнения.
+ * На целевой платформе используется счётчик тактов DWT,
+ * на хосте - монотонные часы с разрешением в наносекунды.
+ */
+
+#ifndef CYCLES_H
+#define	CYCLES_H
+
+#include <stdint.h>
+#include "defs/defs.h"
+
+#ifdef __arm__
+
+//! Регистр управления отладкой и мониторингом.
+#define CYCLES_DEMCR (*(volatile uint32_t*)0xE000EDFCUL)
+//! Бит разрешения трассировки.
+#define CYCLES_DEMCR_TRCENA (1UL << 24)
+//! Регистр управления DWT.
+#define CYCLES_DWT_CTRL (*(volatile uint32_t*)0xE0001000UL)
+//! Бит разрешения счётчика тактов.
+#define CYCLES_DWT_CTRL_CYCCNTENA (1UL << 0)
+//! Счётчик тактов DWT.
+#define CYCLES_DWT_CYCCNT (*(volatile uint32_t*)0xE0001004UL)
+
+#else
+
+#include <time.h>
+
+#endif
+
+/**
+ * Инициализирует и запускает счётчик тактов.
+ */
+ALWAYS_INLINE static void cycles_init(void)
+{
+#ifdef __arm__
+    CYCLES_DEMCR |= CYCLES_DEMCR_TRCENA;
+    CYCLES_DWT_CYCCNT = 0;
+    CYCLES_DWT_CTRL |= CYCLES_DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+/**
+ * Получает текущее значение счётчика тактов.
+ * На хосте возвращает время в наносекундах.
+ * @return Значение счётчика тактов.
+ */
+ALWAYS_INLINE static uint32_t cycles_get(void)
+{
+#ifdef __arm__
+    return CYCLES_DWT_CYCCNT;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+#endif	/* CYCLES_H */
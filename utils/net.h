@@ -1,5 +1,7 @@
 /**
  * @file net.h Функции преобразования порядка байт.
+ * На хосте (little-endian) используются встроенные
+ * функции компилятора вместо инструкций rev.
  */
 
 #ifndef NET_H
@@ -17,11 +19,15 @@
  */
 ALWAYS_INLINE static uint16_t htons(uint16_t hostshort)
 {
+#ifdef __arm__
     uint16_t res;
     
     __asm__ __volatile__ ("rev16 %0, %1" : "=r"(res) : "r"(hostshort));
     
     return res;
+#else
+    return __builtin_bswap16(hostshort);
+#endif
 }
 
 /**
@@ -33,11 +39,15 @@ ALWAYS_INLINE static uint16_t htons(uint16_t hostshort)
  */
 ALWAYS_INLINE static uint16_t ntohs(uint16_t netshort)
 {
+#ifdef __arm__
     uint16_t res;
     
     __asm__ __volatile__ ("rev16 %0, %1" : "=r"(res) : "r"(netshort));
     
     return res;
+#else
+    return __builtin_bswap16(netshort);
+#endif
 }
 
 /**
@@ -49,11 +59,15 @@ ALWAYS_INLINE static uint16_t ntohs(uint16_t netshort)
  */
 ALWAYS_INLINE static uint32_t htonl(uint32_t hostlong)
 {
+#ifdef __arm__
     uint32_t res;
     
     __asm__ __volatile__ ("rev %0, %1" : "=r"(res) : "r"(hostlong));
     
     return res;
+#else
+    return __builtin_bswap32(hostlong);
+#endif
 }
 
 /**
@@ -65,11 +79,15 @@ ALWAYS_INLINE static uint32_t htonl(uint32_t hostlong)
  */
 ALWAYS_INLINE static uint32_t ntohl(uint32_t netlong)
 {
+#ifdef __arm__
     uint32_t res;
     
     __asm__ __volatile__ ("rev %0, %1" : "=r"(res) : "r"(netlong));
     
     return res;
+#else
+    return __builtin_bswap32(netlong);
+#endif
 }
 
 #endif  //NET_H
@@ -0,0 +1,208 @@
+#include "work_queue.h"
+#include "utils/cycles.h"
+
+
+#ifdef __arm__
+
+ALWAYS_INLINE static void work_queue_barrier(void)
+{
+    __asm__ volatile ("dmb" ::: "memory");
+}
+
+ALWAYS_INLINE static uint32_t work_queue_load(work_queue_atomic_t* ptr)
+{
+    uint32_t val = *ptr;
+    work_queue_barrier();
+    return val;
+}
+
+ALWAYS_INLINE static void work_queue_store(work_queue_atomic_t* ptr, uint32_t val)
+{
+    work_queue_barrier();
+    *ptr = val;
+}
+
+/**
+ * Атомарно сравнивает и заменяет значение.
+ * @param ptr Указатель на значение.
+ * @param expected Ожидаемое значение, при неудаче - текущее значение.
+ * @param desired Новое значение.
+ * @return Флаг замены значения.
+ */
+static bool work_queue_cas(work_queue_atomic_t* ptr, uint32_t* expected, uint32_t desired)
+{
+    uint32_t val;
+    uint32_t res;
+    
+    do{
+        __asm__ volatile ("ldrex %0, [%1]" : "=r" (val) : "r" (ptr) : "memory");
+        
+        if(val != *expected){
+            __asm__ volatile ("clrex" ::: "memory");
+            *expected = val;
+            return false;
+        }
+        
+        __asm__ volatile ("strex %0, %2, [%1]" : "=&r" (res) : "r" (ptr), "r" (desired) : "memory");
+    }while(res != 0);
+    
+    work_queue_barrier();
+    
+    return true;
+}
+
+static void work_queue_inc(work_queue_atomic_t* ptr)
+{
+    uint32_t val;
+    uint32_t res;
+    
+    do{
+        __asm__ volatile ("ldrex %0, [%1]" : "=r" (val) : "r" (ptr) : "memory");
+        val ++;
+        __asm__ volatile ("strex %0, %2, [%1]" : "=&r" (res) : "r" (ptr), "r" (val) : "memory");
+    }while(res != 0);
+}
+
+#else
+
+ALWAYS_INLINE static uint32_t work_queue_load(work_queue_atomic_t* ptr)
+{
+    return atomic_load_explicit(ptr, memory_order_acquire);
+}
+
+ALWAYS_INLINE static void work_queue_store(work_queue_atomic_t* ptr, uint32_t val)
+{
+    atomic_store_explicit(ptr, val, memory_order_release);
+}
+
+ALWAYS_INLINE static bool work_queue_cas(work_queue_atomic_t* ptr, uint32_t* expected, uint32_t desired)
+{
+    return atomic_compare_exchange_weak_explicit(ptr, expected, desired,
+                                                 memory_order_acq_rel, memory_order_relaxed);
+}
+
+ALWAYS_INLINE static void work_queue_inc(work_queue_atomic_t* ptr)
+{
+    atomic_fetch_add_explicit(ptr, 1, memory_order_relaxed);
+}
+
+#endif
+
+err_t work_queue_init(work_queue_t* queue, work_item_t* items, size_t size)
+{
+    if(queue == NULL || items == NULL) return E_NULL_POINTER;
+    if(size == 0) return E_INVALID_VALUE;
+    
+    uint32_t count = 1;
+    
+    while(count <= size / 2) count <<= 1;
+    
+    queue->items = items;
+    queue->mask = count - 1;
+    queue->get = 0;
+    queue->max_depth = 0;
+    queue->max_latency = 0;
+    
+    uint32_t i;
+    for(i = 0; i < count; i ++){
+        items[i].proc = NULL;
+        items[i].arg = NULL;
+        work_queue_store(&items[i].sequence, i);
+    }
+    
+    work_queue_store(&queue->overruns, 0);
+    work_queue_store(&queue->put, 0);
+    
+    return E_NO_ERROR;
+}
+
+bool work_queue_post(work_queue_t* queue, work_proc_t proc, void* arg)
+{
+    if(proc == NULL) return false;
+    
+    uint32_t time = cycles_get();
+    uint32_t pos = work_queue_load(&queue->put);
+    work_item_t* item;
+    int32_t diff;
+    
+    for(;;){
+        item = &queue->items[pos & queue->mask];
+        diff = (int32_t)(work_queue_load(&item->sequence) - pos);
+        
+        if(diff == 0){
+            // Ячейка свободна - резервирование.
+            if(work_queue_cas(&queue->put, &pos, pos + 1)) break;
+        }else if(diff < 0){
+            // Ячейка ещё не прочитана - очередь заполнена.
+            work_queue_inc(&queue->overruns);
+            return false;
+        }else{
+            // Ячейка зарезервирована другим источником.
+            pos = work_queue_load(&queue->put);
+        }
+    }
+    
+    item->proc = proc;
+    item->arg = arg;
+    item->post_time = time;
+    
+    work_queue_store(&item->sequence, pos + 1);
+    
+    return true;
+}
+
+size_t work_queue_process(work_queue_t* queue)
+{
+    work_item_t* item;
+    work_proc_t proc;
+    void* arg;
+    uint32_t latency;
+    uint32_t depth;
+    size_t count = 0;
+    
+    depth = work_queue_load(&queue->put) - queue->get;
+    if(depth > queue->max_depth) queue->max_depth = depth;
+    
+    // Не более одного оборота очереди за вызов,
+    // чтобы постоянные вызовы из прерываний не
+    // блокировали главный цикл.
+    while(count <= queue->mask){
+        item = &queue->items[queue->get & queue->mask];
+        
+        // Ячейка ещё не записана.
+        if((int32_t)(work_queue_load(&item->sequence) - (queue->get + 1)) < 0) break;
+        
+        proc = item->proc;
+        arg = item->arg;
+        latency = cycles_get() - item->post_time;
+        
+        // Освобождение ячейки для следующего оборота.
+        work_queue_store(&item->sequence, queue->get + queue->mask + 1);
+        queue->get ++;
+        
+        if(latency > queue->max_latency) queue->max_latency = latency;
+        
+        proc(arg);
+        
+        count ++;
+    }
+    
+    return count;
+}
+
+size_t work_queue_depth(work_queue_t* queue)
+{
+    return work_queue_load(&queue->put) - queue->get;
+}
+
+uint32_t work_queue_overruns(work_queue_t* queue)
+{
+    return work_queue_load(&queue->overruns);
+}
+
+void work_queue_reset_stats(work_queue_t* queue)
+{
+    queue->max_depth = 0;
+    queue->max_latency = 0;
+    work_queue_store(&queue->overruns, 0);
+}
@@ -0,0 +1,126 @@
+/**
+ * @file work_queue.h Библиотека очереди отложенных вызовов.
+ * Очередь позволяет обработчикам прерываний за несколько
+ * тактов поместить вызов функции с аргументом, который
+ * будет выполнен в главном цикле (см. scheduler_process).
+ * Помещать вызовы могут одновременно несколько источников
+ * (вложенные прерывания), извлекать - один потребитель.
+ * Очередь не использует блокировок: на целевой платформе
+ * используются инструкции LDREX/STREX, на хосте - атомарные
+ * операции C11. Каждая ячейка очереди содержит порядковый
+ * номер, определяющий её готовность к записи или чтению.
+ * Время задержки измеряется счётчиком тактов (см. utils/cycles.h).
+ */
+
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "errors/errors.h"
+#include "defs/defs.h"
+
+#ifdef __arm__
+//! Тип атомарно изменяемого значения.
+typedef volatile uint32_t work_queue_atomic_t;
+#else
+#include <stdatomic.h>
+//! Тип атомарно изменяемого значения.
+typedef _Atomic uint32_t work_queue_atomic_t;
+#endif
+
+//! Тип функции отложенного вызова.
+typedef void (*work_proc_t)(void* arg);
+
+//! Элемент очереди отложенных вызовов.
+typedef struct _Work_Item {
+    work_queue_atomic_t sequence; //!< Порядковый номер ячейки.
+    work_proc_t proc; //!< Функция.
+    void* arg; //!< Аргумент функции.
+    uint32_t post_time; //!< Время помещения в очередь.
+} work_item_t;
+
+//! Декларация буфера очереди отложенных вызовов.
+#define WORK_QUEUE_BUFFER(name, size) work_item_t name[size]
+
+//! Очередь отложенных вызовов.
+typedef struct _Work_Queue {
+    work_item_t* items; //!< Элементы очереди.
+    uint32_t mask; //!< Маска индекса элемента.
+    work_queue_atomic_t put; //!< Индекс записи.
+    uint32_t get; //!< Индекс чтения.
+    work_queue_atomic_t overruns; //!< Число переполнений.
+    uint32_t max_depth; //!< Максимальная наблюдаемая глубина очереди.
+    uint32_t max_latency; //!< Максимальная задержка выполнения в тактах.
+} work_queue_t;
+
+/**
+ * Инициализирует очередь отложенных вызовов.
+ * @param queue Очередь.
+ * @param items Буфер элементов.
+ * @param size Размер буфера, округляется вниз до степени двойки.
+ * @return Код ошибки.
+ */
+EXTERN err_t work_queue_init(work_queue_t* queue, work_item_t* items, size_t size);
+
+/**
+ * Помещает вызов в очередь.
+ * Может вызываться из прерываний.
+ * @param queue Очередь.
+ * @param proc Функция.
+ * @param arg Аргумент функции.
+ * @return Флаг помещения вызова, false при переполнении.
+ */
+EXTERN bool work_queue_post(work_queue_t* queue, work_proc_t proc, void* arg);
+
+/**
+ * Выполняет все готовые вызовы в порядке помещения,
+ * но не более размера очереди за вызов.
+ * Должна вызываться одним потребителем.
+ * @param queue Очередь.
+ * @return Число выполненных вызовов.
+ */
+EXTERN size_t work_queue_process(work_queue_t* queue);
+
+/**
+ * Получает текущую глубину очереди.
+ * @param queue Очередь.
+ * @return Число вызовов в очереди.
+ */
+EXTERN size_t work_queue_depth(work_queue_t* queue);
+
+/**
+ * Получает максимальную глубину очереди.
+ * @param queue Очередь.
+ * @return Максимальное число вызовов в очереди.
+ */
+ALWAYS_INLINE static size_t work_queue_max_depth(work_queue_t* queue)
+{
+    return queue->max_depth;
+}
+
+/**
+ * Получает максимальную задержку от помещения вызова до его выполнения.
+ * @param queue Очередь.
+ * @return Максимальная задержка в тактах.
+ */
+ALWAYS_INLINE static uint32_t work_queue_max_latency(work_queue_t* queue)
+{
+    return queue->max_latency;
+}
+
+/**
+ * Получает число вызовов, не помещённых из-за переполнения.
+ * @param queue Очередь.
+ * @return Число переполнений.
+ */
+EXTERN uint32_t work_queue_overruns(work_queue_t* queue);
+
+/**
+ * Сбрасывает статистику очереди.
+ * @param queue Очередь.
+ */
+EXTERN void work_queue_reset_stats(work_queue_t* queue);
+
+#endif /* WORK_QUEUE_H */